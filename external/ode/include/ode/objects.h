@@ -464,6 +464,25 @@ ODE_API void dWorldSetQuickStepW (dWorldID, dReal over_relaxation);
  */
 ODE_API dReal dWorldGetQuickStepW (dWorldID);
 
+/**
+ * @brief Set the QuickStep warm starting factor.
+ *
+ * When non-zero, QuickStep starts each solve from the lambda every joint 
+ * stored on the previous step, scaled by this factor, instead of from zero.
+ * Joints that are recreated every step (such as contacts) start cold unless 
+ * their lambda is restored with dJointSetLambda.
+ * @ingroup world
+ * @param factor scale applied to the stored lambda, 0 disables warm starting
+ */
+ODE_API void dWorldSetQuickStepWarmStarting (dWorldID, dReal factor);
+
+/**
+ * @brief Get the QuickStep warm starting factor.
+ * @ingroup world
+ * @returns the warm starting factor, 0 if disabled
+ */
+ODE_API dReal dWorldGetQuickStepWarmStarting (dWorldID);
+
 /* World contact parameter functions */
 
 /**
@@ -1857,6 +1876,25 @@ ODE_API void dJointSetFeedback (dJointID, dJointFeedback *);
  */
 ODE_API dJointFeedback *dJointGetFeedback (dJointID);
 
+/**
+ * @brief Get the constraint impulses (lambda) the last QuickStep solved for.
+ *
+ * Only written while QuickStep warm starting is enabled.
+ * @ingroup joints
+ * @param lambda receives up to 6 values, one per constraint row
+ */
+ODE_API void dJointGetLambda (dJointID, dReal *lambda);
+
+/**
+ * @brief Set the constraint impulses (lambda) the next QuickStep starts from.
+ *
+ * Only used while QuickStep warm starting is enabled.
+ * @ingroup joints
+ * @param lambda up to 6 values, one per constraint row
+ * @param count number of values to set, the rest are zeroed
+ */
+ODE_API void dJointSetLambda (dJointID, const dReal *lambda, int count);
+
 /**
  * @brief Set the joint anchor point.
  * @ingroup joints
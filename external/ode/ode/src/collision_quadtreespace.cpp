@@ -281,6 +281,7 @@ void Block::DelObject(dGeomID Object){
     }
 
     Object->tome_ex = 0;
+    Object->next_ex = 0;
 
     // Now traverse upwards to tell that we have lost a geom
     Block* Block = this;
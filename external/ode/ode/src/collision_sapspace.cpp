@@ -347,6 +347,10 @@ void dxSAPSpace::remove( dxGeom* g )
         GeomList.setSize( geomSize-1 );
     }
 
+    // clear the indices so the geom can be added to another space
+    g->next_ex = 0;
+    g->tome_ex = 0;
+
     dxSpace::remove(g);
 }
 
@@ -30,7 +30,10 @@
 //****************************************************************************
 // random numbers
 
-static volatile duint32 seed = 0;
+// note: the seed is per thread, so independent worlds stepped on different threads each get their
+// own deterministic sequence instead of interleaving one shared sequence
+
+static volatile thread_local duint32 seed = 0;
 
 unsigned long dRand()
 {
@@ -72,7 +72,8 @@ dxDampingParameters::dxDampingParameters(void *):
 
 dxQuickStepParameters::dxQuickStepParameters(void *):
     num_iterations(20),
-    w(REAL(1.3))
+    w(REAL(1.3)),
+    warm_start(REAL(0.0))
 {
 }
 
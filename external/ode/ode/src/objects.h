@@ -106,6 +106,7 @@ struct dxDampingParameters {
 struct dxQuickStepParameters {
     int num_iterations;		// number of SOR iterations to perform
     dReal w;			// the SOR over-relaxation parameter
+    dReal warm_start;		// scale applied to the previous step's lambda, 0 = cold start
 
     dxQuickStepParameters() {}
     explicit dxQuickStepParameters(void *);
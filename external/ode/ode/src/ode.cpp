@@ -1491,6 +1491,21 @@ dJointFeedback *dJointGetFeedback (dxJoint *joint)
 }
 
 
+void dJointGetLambda (dxJoint *joint, dReal *lambda)
+{
+    dAASSERT (joint && lambda);
+    memcpy (lambda, joint->lambda, sizeof(joint->lambda));
+}
+
+
+void dJointSetLambda (dxJoint *joint, const dReal *lambda, int count)
+{
+    dAASSERT (joint && lambda && count >= 0 && count <= 6);
+    dSetZero (joint->lambda, 6);
+    memcpy (joint->lambda, lambda, (size_t)count * sizeof(dReal));
+}
+
+
 
 dJointID dConnectingJoint (dBodyID in_b1, dBodyID in_b2)
 {
@@ -2051,6 +2066,20 @@ dReal dWorldGetQuickStepW (dWorldID w)
 }
 
 
+void dWorldSetQuickStepWarmStarting (dWorldID w, dReal factor)
+{
+    dAASSERT(w);
+    w->qs.warm_start = factor;
+}
+
+
+dReal dWorldGetQuickStepWarmStarting (dWorldID w)
+{
+    dAASSERT(w);
+    return w->qs.warm_start;
+}
+
+
 void dWorldSetContactMaxCorrectingVel (dWorldID w, dReal vel)
 {
     dAASSERT(w);
@@ -45,9 +45,11 @@
 // configuration
 
 // for the SOR and CG methods:
-// uncomment the following line to use warm starting. this definitely
+// uncomment the following line to always use warm starting. this definitely
 // help for motor-driven joints. unfortunately it appears to hurt
-// with high-friction contacts using the SOR method. use with care
+// with high-friction contacts using the SOR method. use with care.
+// for the SOR method it can also be enabled per world at runtime with
+// dWorldSetQuickStepWarmStarting.
 
 //#define WARM_STARTING 1
 
@@ -302,7 +304,6 @@ static void compute_invM_JT (unsigned int m, const dReal *J, dReal *iMJ, int *jb
 }
 
 // compute out = inv(M)*J'*in.
-#ifdef WARM_STARTING
 static void multiply_invM_JT (unsigned int m, unsigned int nb, dReal *iMJ, int *jb,
                               const dReal *in, dReal *out)
 {
@@ -322,7 +323,6 @@ static void multiply_invM_JT (unsigned int m, unsigned int nb, dReal *iMJ, int *
         iMJ_ptr += 6;
     }
 }
-#endif
 
 // compute out = J*in.
 static void multiplyAdd_J (volatile unsigned *mi_storage, 
@@ -531,26 +531,32 @@ static void SOR_LCP (dxWorldProcessMemArena *memarena,
                      const dxQuickStepParameters *qs)
 {
 #ifdef WARM_STARTING
-    {
-        // for warm starting, this seems to be necessary to prevent
-        // jerkiness in motor-driven joints. i have no idea why this works.
-        for (unsigned int i=0; i<m; i++) lambda[i] *= 0.9;
-    }
+    const dReal warm_start = REAL(0.9);
 #else
-    dSetZero (lambda,m);
+    const dReal warm_start = qs->warm_start;
 #endif
 
+    if (warm_start != REAL(0.0)) {
+        // for warm starting, scaling down seems to be necessary to prevent
+        // jerkiness in motor-driven joints. i have no idea why this works.
+        for (unsigned int i=0; i<m; i++) lambda[i] *= warm_start;
+    }
+    else {
+        dSetZero (lambda,m);
+    }
+
     // precompute iMJ = inv(M)*J'
     dReal *iMJ = memarena->AllocateArray<dReal>((size_t)m*12);
     compute_invM_JT (m,J,iMJ,jb,body,invI);
 
     // compute fc=(inv(M)*J')*lambda. we will incrementally maintain fc
     // as we change lambda.
-#ifdef WARM_STARTING
-    multiply_invM_JT (m,nb,iMJ,jb,lambda,fc);
-#else
-    dSetZero (fc,(size_t)nb*6);
-#endif
+    if (warm_start != REAL(0.0)) {
+        multiply_invM_JT (m,nb,iMJ,jb,lambda,fc);
+    }
+    else {
+        dSetZero (fc,(size_t)nb*6);
+    }
 
     dReal *Ad = memarena->AllocateArray<dReal>(m);
 
@@ -1405,7 +1411,9 @@ void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext
         // load lambda from the value saved on the previous iteration
         dReal *lambda = memarena->AllocateArray<dReal>(m);
 
-#ifdef WARM_STARTING
+#ifndef WARM_STARTING
+        if (world->qs.warm_start != REAL(0.0))
+#endif
         {
             dReal *lambdscurr = lambda;
             const dJointWithInfo1 *jicurr = jointinfos;
@@ -1416,7 +1424,6 @@ void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext
                 lambdscurr += infom;
             }
         }
-#endif
 
         dReal *cforce = memarena->AllocateArray<dReal>((size_t)nb*6);
 
@@ -1427,10 +1434,13 @@ void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext
 
         } END_STATE_SAVE(memarena, lcpstate);
 
-#ifdef WARM_STARTING
+#ifndef WARM_STARTING
+        if (world->qs.warm_start != REAL(0.0))
+#endif
         {
             // save lambda for the next iteration
-            //@@@ note that this doesn't work for contact joints yet, as they are
+            //@@@ note that this doesn't work for contact joints unless the caller
+            // carries lambda over with dJointGetLambda/dJointSetLambda, as they are
             // recreated every iteration
             const dReal *lambdacurr = lambda;
             const dJointWithInfo1 *jicurr = jointinfos;
@@ -1441,7 +1451,6 @@ void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext
                 lambdacurr += infom;
             }
         }
-#endif
 
         // note that the SOR method overwrites rhs and J at this point, so
         // they should not be used again.
@@ -660,13 +660,6 @@ void dxtemplateJobListContainer<tThreadLull, tThreadMutex, tAtomicsProvider>::Re
             break;
         }
 
-        void *job_call_wait = current_job->m_call_wait;
-
-        if (job_call_wait != NULL)
-        {
-            wait_signal_proc_ptr(job_call_wait);
-        }
-
         int call_fault = current_job->m_call_fault;
 
         if (current_job->m_fault_accumulator_ptr)
@@ -674,9 +667,18 @@ void dxtemplateJobListContainer<tThreadLull, tThreadMutex, tAtomicsProvider>::Re
             *current_job->m_fault_accumulator_ptr = call_fault;
         }
 
+        // The fault accumulator is usually on the waiter's stack and the job 
+        // may be reused as soon as the waiter resumes, so read everything 
+        // needed and store the fault before signaling the wait.
+        void *job_call_wait = current_job->m_call_wait;
         dxThreadedJobInfo *dependent_job = current_job->m_dependent_job;
         ReleaseJobInfoIntoPool(current_job);
 
+        if (job_call_wait != NULL)
+        {
+            wait_signal_proc_ptr(job_call_wait);
+        }
+
         if (dependent_job == NULL)
         {
             break;
@@ -128,6 +128,30 @@ vectorial_inline simd4f simd4f_div(simd4f lhs, simd4f rhs) {
     return ret;
 }
 
+vectorial_inline simd4f simd4f_min(simd4f lhs, simd4f rhs) {
+    simd4f ret = { fminf(simd4f_get_x(lhs), simd4f_get_x(rhs)), fminf(simd4f_get_y(lhs), simd4f_get_y(rhs)),
+                   fminf(simd4f_get_z(lhs), simd4f_get_z(rhs)), fminf(simd4f_get_w(lhs), simd4f_get_w(rhs)) };
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_max(simd4f lhs, simd4f rhs) {
+    simd4f ret = { fmaxf(simd4f_get_x(lhs), simd4f_get_x(rhs)), fmaxf(simd4f_get_y(lhs), simd4f_get_y(rhs)),
+                   fmaxf(simd4f_get_z(lhs), simd4f_get_z(rhs)), fmaxf(simd4f_get_w(lhs), simd4f_get_w(rhs)) };
+    return ret;
+}
+
+typedef int _simd4f_mask __attribute__ ((vector_size (16)));
+
+vectorial_inline simd4f simd4f_less(simd4f lhs, simd4f rhs) {
+    simd4f ret = (simd4f)(lhs < rhs);
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_and(simd4f lhs, simd4f rhs) {
+    simd4f ret = (simd4f)((_simd4f_mask)lhs & (_simd4f_mask)rhs);
+    return ret;
+}
+
 
 vectorial_inline simd4f simd4f_cross3(simd4f l, simd4f r) {
     _simd4f_union lhs = {l};
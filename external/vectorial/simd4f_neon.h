@@ -145,6 +145,26 @@ vectorial_inline simd4f simd4f_div(simd4f lhs, simd4f rhs) {
     return ret;
 }
 
+vectorial_inline simd4f simd4f_min(simd4f lhs, simd4f rhs) {
+    simd4f ret = vminq_f32(lhs, rhs);
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_max(simd4f lhs, simd4f rhs) {
+    simd4f ret = vmaxq_f32(lhs, rhs);
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_less(simd4f lhs, simd4f rhs) {
+    simd4f ret = vreinterpretq_f32_u32(vcltq_f32(lhs, rhs));
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_and(simd4f lhs, simd4f rhs) {
+    simd4f ret = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(lhs), vreinterpretq_u32_f32(rhs)));
+    return ret;
+}
+
 
 vectorial_inline float simd4f_get_x(simd4f s) { return vgetq_lane_f32(s, 0); }
 vectorial_inline float simd4f_get_y(simd4f s) { return vgetq_lane_f32(s, 1); }
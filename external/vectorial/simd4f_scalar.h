@@ -124,6 +124,42 @@ vectorial_inline simd4f simd4f_div(simd4f lhs, simd4f rhs) {
     return ret;
 }
 
+vectorial_inline simd4f simd4f_min(simd4f lhs, simd4f rhs) {
+    simd4f ret = { lhs.x < rhs.x ? lhs.x : rhs.x, lhs.y < rhs.y ? lhs.y : rhs.y, lhs.z < rhs.z ? lhs.z : rhs.z, lhs.w < rhs.w ? lhs.w : rhs.w };
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_max(simd4f lhs, simd4f rhs) {
+    simd4f ret = { lhs.x > rhs.x ? lhs.x : rhs.x, lhs.y > rhs.y ? lhs.y : rhs.y, lhs.z > rhs.z ? lhs.z : rhs.z, lhs.w > rhs.w ? lhs.w : rhs.w };
+    return ret;
+}
+
+// note: comparisons return a mask with all bits set where true, like the simd versions
+
+vectorial_inline float _simd4f_mask(int condition) {
+    union { unsigned int u; float f; } m;
+    m.u = condition ? 0xFFFFFFFFu : 0u;
+    return m.f;
+}
+
+vectorial_inline float _simd4f_and(float lhs, float rhs) {
+    union { float f; unsigned int u; } l, r;
+    l.f = lhs;
+    r.f = rhs;
+    l.u &= r.u;
+    return l.f;
+}
+
+vectorial_inline simd4f simd4f_less(simd4f lhs, simd4f rhs) {
+    simd4f ret = { _simd4f_mask(lhs.x < rhs.x), _simd4f_mask(lhs.y < rhs.y), _simd4f_mask(lhs.z < rhs.z), _simd4f_mask(lhs.w < rhs.w) };
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_and(simd4f lhs, simd4f rhs) {
+    simd4f ret = { _simd4f_and(lhs.x, rhs.x), _simd4f_and(lhs.y, rhs.y), _simd4f_and(lhs.z, rhs.z), _simd4f_and(lhs.w, rhs.w) };
+    return ret;
+}
+
 
 vectorial_inline simd4f simd4f_cross3(simd4f lhs, simd4f rhs) {
     return simd4f_create( lhs.y * rhs.z - lhs.z * rhs.y,
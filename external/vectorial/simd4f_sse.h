@@ -124,6 +124,26 @@ vectorial_inline simd4f simd4f_div(simd4f lhs, simd4f rhs) {
     return ret;
 }
 
+vectorial_inline simd4f simd4f_min(simd4f lhs, simd4f rhs) {
+    simd4f ret = _mm_min_ps(lhs, rhs);
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_max(simd4f lhs, simd4f rhs) {
+    simd4f ret = _mm_max_ps(lhs, rhs);
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_less(simd4f lhs, simd4f rhs) {
+    simd4f ret = _mm_cmplt_ps(lhs, rhs);
+    return ret;
+}
+
+vectorial_inline simd4f simd4f_and(simd4f lhs, simd4f rhs) {
+    simd4f ret = _mm_and_ps(lhs, rhs);
+    return ret;
+}
+
 
 vectorial_inline simd4f simd4f_cross3(simd4f lhs, simd4f rhs) {
     
@@ -4,12 +4,13 @@
 #include "protocol/Connection.h"
 #include "network/Simulator.h"
 #include "network/Interface.h"
+#include "network/Resolver.h"
 #include "core/Memory.h"
 
 namespace clientServer
 {
     Client::Client( const ClientConfig & config )
-        : m_config( config )
+        : m_config( config ), m_rateController( config.rateController )
     {
         CORE_ASSERT( m_config.networkInterface );
         CORE_ASSERT( m_config.channelStructure );
@@ -111,12 +112,15 @@ namespace clientServer
             return;
         }
 
-#if PROTOCOL_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
 
         // if we don't have a resolver, we can't resolve the string to an address...
 
         if ( !m_config.resolver )
+        {
             DisconnectAndSetError( CLIENT_ERROR_MISSING_RESOLVER );
+            return;
+        }
 
         // ok, it's probably a hostname. go into the resolving hostname state
 
@@ -145,15 +149,22 @@ namespace clientServer
 
 //            printf( "client disconnect\n" );
 
-        auto packet = (DisconnectedPacket*) m_packetFactory->Create( CLIENT_SERVER_PACKET_DISCONNECTED );
+        // IMPORTANT: no server address yet while resolving the hostname
 
-        packet->clientId = m_clientId;
-        packet->serverId = m_serverId;
+        if ( m_state >= CLIENT_STATE_SENDING_CONNECTION_REQUEST )
+        {
+            auto packet = (DisconnectedPacket*) m_packetFactory->Create( CLIENT_SERVER_PACKET_DISCONNECTED );
+
+            packet->clientId = m_clientId;
+            packet->serverId = m_serverId;
 
-        SendPacket( packet );
+            SendPacket( packet );
+        }
 
         m_connection->Reset();
 
+        m_rateController.Reset();
+
         ClearStateData();
         
         SetClientState( CLIENT_STATE_DISCONNECTED );
@@ -206,7 +217,7 @@ namespace clientServer
 
 #if NETWORK_USE_RESOLVER
 
-    Resolver * Client::GetResolver() const
+    network::Resolver * Client::GetResolver() const
     {
         return m_config.resolver;
     }
@@ -228,6 +239,18 @@ namespace clientServer
         return m_dataBlockReceiver ? m_dataBlockReceiver->GetBlock() : nullptr;
     }
 
+    float Client::GetSendRate() const
+    {
+        if ( !IsConnected() )
+            return m_config.connectingSendRate;
+        return m_config.adaptiveSendRate ? m_rateController.GetSendRate() : m_config.connectedSendRate;
+    }
+
+    int Client::GetPacketSize() const
+    {
+        return m_connection->GetPacketSize();
+    }
+
     void Client::SetContext( int index, const void * ptr )
     {
         CORE_ASSERT( index >= CONTEXT_USER );
@@ -239,7 +262,7 @@ namespace clientServer
     {
         m_timeBase = timeBase;
 
-#if PROTOCOL_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
         UpdateResolver();
 #endif
      
@@ -280,7 +303,7 @@ namespace clientServer
         m_config.networkInterface->Update( m_timeBase );
     }
 
-#if PROTOCOL_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
 
     void Client::UpdateResolver()
     {
@@ -294,14 +317,14 @@ namespace clientServer
 
 //            printf( "update resolve hostname\n" );
 
-        if ( !entry || entry->status == RESOLVE_FAILED )
+        if ( !entry || entry->status == network::RESOLVE_FAILED )
         {
 //                printf( "resolve hostname failed\n" );
             DisconnectAndSetError( CLIENT_ERROR_RESOLVE_HOSTNAME_FAILED );
             return;
         }
 
-        if ( entry->status == RESOLVE_SUCCEEDED )
+        if ( entry->status == network::RESOLVE_SUCCEEDED )
         {
 //                printf( "resolve hostname succeeded: %s\n", entry->result->addresses[0].ToString().c_str() );
 
@@ -327,6 +350,12 @@ namespace clientServer
                 DisconnectAndSetError( CLIENT_ERROR_CONNECTION_ERROR );
                 return;
             }
+
+            if ( m_config.adaptiveSendRate )
+            {
+                m_rateController.Update( m_timeBase.deltaTime, m_connection->GetRTT(), m_connection->GetPacketLoss() );
+                m_connection->SetPacketSize( m_rateController.GetPacketSize() );
+            }
         }
     }
 
@@ -337,7 +366,7 @@ namespace clientServer
 
         m_accumulator += m_timeBase.deltaTime;
 
-        const float timeBetweenPackets = 1.0 / ( IsConnected() ? m_config.connectedSendRate : m_config.connectingSendRate );
+        const float timeBetweenPackets = 1.0 / GetSendRate();
 
         if ( m_accumulator >= timeBetweenPackets )
         {
@@ -358,6 +387,8 @@ namespace clientServer
                     auto packet = (ChallengeResponsePacket*) m_packetFactory->Create( CLIENT_SERVER_PACKET_CHALLENGE_RESPONSE );
                     packet->clientId = m_clientId;
                     packet->serverId = m_serverId;
+                    packet->challengeTime = m_challengeTime;
+                    packet->challengeToken = m_challengeToken;
                     m_config.networkInterface->SendPacket( m_address, packet );
                 }
                 break;
@@ -422,6 +453,8 @@ namespace clientServer
                             m_lastPacketReceiveTime = m_timeBase.time;
 
                             m_serverId = connectionChallengePacket->serverId;
+                            m_challengeTime = connectionChallengePacket->challengeTime;
+                            m_challengeToken = connectionChallengePacket->challengeToken;
 
                             ClientServerInfo info;
                             info.address = m_address;
@@ -460,6 +493,18 @@ namespace clientServer
                     {
                         ProcessDataBlockFragment( (DataBlockFragmentPacket*) packet );
                     }
+                    else if ( type == CLIENT_SERVER_PACKET_CONNECTION_DENIED )
+                    {
+                        // IMPORTANT: the server only commits a slot on challenge response, so it may fill up in the meantime
+
+                        auto connectionDeniedPacket = static_cast<ConnectionDeniedPacket*>( packet );
+
+                        if ( connectionDeniedPacket->GetAddress() == m_address &&
+                             connectionDeniedPacket->clientId == m_clientId )
+                        {
+                            DisconnectAndSetError( CLIENT_ERROR_CONNECTION_REQUEST_DENIED, connectionDeniedPacket->reason );
+                        }
+                    }
                     else if ( type == CLIENT_SERVER_PACKET_READY_FOR_CONNECTION )
                     {
                         auto readyForConnectionPacket = static_cast<ReadyForConnectionPacket*>( packet );
@@ -646,6 +691,8 @@ namespace clientServer
         m_address = network::Address();
         m_clientId = 0;
         m_serverId = 0;
+        m_challengeTime = 0;
+        m_challengeToken = 0;
         m_clientServerContext.RemoveClient( 0 );
     }
 
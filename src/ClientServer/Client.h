@@ -8,6 +8,8 @@
 #include "ClientServerContext.h"
 #include "ClientServerDataBlock.h"
 #include "ClientServerConstants.h"
+#include "RateController.h"
+#include "network/Config.h"
 
 namespace network
 {
@@ -38,8 +40,11 @@ namespace clientServer
         float connectingSendRate = 10.0f;                       // client send rate while connecting
         float connectedSendRate = 30.0f;                        // client send rate *after* being connected, eg. connection packets
 
-        #if PROTOCOL_USE_RESOLVER
-        Resolver * resolver = nullptr;                          // optional resolver used to to lookup server address by hostname.
+        bool adaptiveSendRate = false;                          // if true the connected send rate adapts to measured RTT and packet loss instead of using connectedSendRate.
+        RateControllerConfig rateController;                    // floor, ceiling and tuning for the adaptive send rate. only used if adaptiveSendRate is true.
+
+        #if NETWORK_USE_RESOLVER
+        network::Resolver * resolver = nullptr;                 // optional resolver used to lookup server address by hostname.
         #endif
         
         network::Interface * networkInterface = nullptr;        // network interface used to send and receive packets. required.
@@ -69,6 +74,8 @@ namespace clientServer
         ClientState m_state = CLIENT_STATE_DISCONNECTED;
         uint16_t m_clientId = 0;
         uint16_t m_serverId = 0;
+        uint64_t m_challengeTime = 0;
+        uint64_t m_challengeToken = 0;
         double m_accumulator = 0.0;
         double m_lastPacketReceiveTime = 0.0;
         ClientError m_error = CLIENT_ERROR_NONE;
@@ -77,6 +84,8 @@ namespace clientServer
         DataBlockSender * m_dataBlockSender = nullptr;
         DataBlockReceiver * m_dataBlockReceiver = nullptr;
 
+        RateController m_rateController;
+
         ClientServerContext m_clientServerContext;
 
         const void * m_context[protocol::MaxContexts];
@@ -114,8 +123,8 @@ namespace clientServer
 
         void ClearError();
 
-        #if PROTOCOL_USE_RESOLVER
-        Resolver * GetResolver() const;
+        #if NETWORK_USE_RESOLVER
+        network::Resolver * GetResolver() const;
         #endif
 
         network::Interface * GetNetworkInterface() const;
@@ -124,6 +133,10 @@ namespace clientServer
 
         const protocol::Block * GetServerData() const;
 
+        float GetSendRate() const;
+
+        int GetPacketSize() const;
+
         void SetContext( int index, const void * ptr );
 
         uint16_t GetClientId() const { return m_clientId; }
@@ -140,7 +153,7 @@ namespace clientServer
 
         void UpdateNetworkInterface();
 
-        #if PROTOCOL_USE_RESOLVER
+        #if NETWORK_USE_RESOLVER
         void UpdateResolver();
         #endif
 
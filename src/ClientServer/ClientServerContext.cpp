@@ -5,19 +5,48 @@
 
 namespace clientServer
 {
+    static uint64_t id_key( uint16_t clientId, uint16_t serverId )
+    {
+        return ( uint64_t( clientId ) << 16 ) | serverId;
+    }
+
+    static void remove_index( core::Hash<int> & index, uint64_t key, int clientIndex )
+    {
+        auto entry = core::multi_hash::find_first( index, key );
+        while ( entry )
+        {
+            if ( entry->value == clientIndex )
+            {
+                core::multi_hash::remove( index, entry );
+                return;
+            }
+            entry = core::multi_hash::find_next( index, entry );
+        }
+        CORE_ASSERT( false );
+    }
+
     void ClientServerContext::Initialize( core::Allocator & allocator, int numClients )
     {
         CORE_ASSERT( numClients > 0 );
         this->classId = ClientServerContext::ClassId;
         this->numClients = numClients;
         this->clientInfo = (ClientInfo*) CORE_NEW_ARRAY( allocator, ClientInfo, numClients );
+        this->addressIndex = CORE_NEW( allocator, core::Hash<int>, allocator );
+        this->idIndex = CORE_NEW( allocator, core::Hash<int>, allocator );
+        core::hash::reserve( *addressIndex, numClients );
+        core::hash::reserve( *idIndex, numClients );
     }
 
     void ClientServerContext::Free( core::Allocator & allocator )
     {
         CORE_ASSERT( clientInfo );
         CORE_DELETE_ARRAY( allocator, clientInfo, numClients );
+        typedef core::Hash<int> IndexHash;
+        CORE_DELETE( allocator, IndexHash, addressIndex );
+        CORE_DELETE( allocator, IndexHash, idIndex );
         clientInfo = nullptr;
+        addressIndex = nullptr;
+        idIndex = nullptr;
         numClients = 0;
     }
 
@@ -25,28 +54,39 @@ namespace clientServer
     {
         CORE_ASSERT( clientIndex >= 0 );
         CORE_ASSERT( clientIndex < numClients );
+        RemoveClient( clientIndex );
         ClientInfo & client = clientInfo[clientIndex];
         client.connected = true;
         client.address = address;
         client.clientId = clientId;
         client.serverId = serverId;
+        core::multi_hash::insert( *addressIndex, address.Hash(), clientIndex );
+        core::multi_hash::insert( *idIndex, id_key( clientId, serverId ), clientIndex );
     }
 
     void ClientServerContext::RemoveClient( int clientIndex )
     {
         CORE_ASSERT( clientIndex >= 0 );
         CORE_ASSERT( clientIndex < numClients );
-        clientInfo[clientIndex] = ClientInfo();
+        ClientInfo & client = clientInfo[clientIndex];
+        if ( client.connected )
+        {
+            remove_index( *addressIndex, client.address.Hash(), clientIndex );
+            remove_index( *idIndex, id_key( client.clientId, client.serverId ), clientIndex );
+        }
+        client = ClientInfo();
     }
 
     int ClientServerContext::FindClient( const network::Address & address ) const
     {
         CORE_ASSERT( classId == ClientServerContext::ClassId );
-        for ( int i = 0; i < numClients; ++i )
+        auto entry = core::multi_hash::find_first( *addressIndex, address.Hash() );
+        while ( entry )
         {
-            if ( clientInfo[i].connected && 
-                 clientInfo[i].address == address )
+            const int i = entry->value;
+            if ( clientInfo[i].address == address )
                 return i;
+            entry = core::multi_hash::find_next( *addressIndex, entry );
         }
         return -1;
     }
@@ -54,12 +94,14 @@ namespace clientServer
     int ClientServerContext::FindClient( const network::Address & address, uint16_t clientId ) const
     {
         CORE_ASSERT( classId == ClientServerContext::ClassId );
-        for ( int i = 0; i < numClients; ++i )
+        auto entry = core::multi_hash::find_first( *addressIndex, address.Hash() );
+        while ( entry )
         {
-            if ( clientInfo[i].connected && 
-                 clientInfo[i].address == address &&
+            const int i = entry->value;
+            if ( clientInfo[i].address == address &&
                  clientInfo[i].clientId == clientId )
                 return i;
+            entry = core::multi_hash::find_next( *addressIndex, entry );
         }
         return -1;
     }
@@ -67,13 +109,15 @@ namespace clientServer
     int ClientServerContext::FindClient( const network::Address & address, uint16_t clientId, uint16_t serverId ) const
     {
         CORE_ASSERT( classId == ClientServerContext::ClassId );
-        for ( int i = 0; i < numClients; ++i )
+        auto entry = core::multi_hash::find_first( *addressIndex, address.Hash() );
+        while ( entry )
         {
-            if ( clientInfo[i].connected && 
-                 clientInfo[i].address == address &&
+            const int i = entry->value;
+            if ( clientInfo[i].address == address &&
                  clientInfo[i].clientId == clientId && 
                  clientInfo[i].serverId == serverId )
                 return i;
+            entry = core::multi_hash::find_next( *addressIndex, entry );
         }
         return -1;
     }
@@ -81,13 +125,6 @@ namespace clientServer
     bool ClientServerContext::ClientPotentiallyExists( uint16_t clientId, uint16_t serverId ) const
     {
         CORE_ASSERT( classId == ClientServerContext::ClassId );
-        for ( int i = 0; i < numClients; ++i )
-        {
-            if ( clientInfo[i].connected &&
-                 clientInfo[i].clientId == clientId && 
-                 clientInfo[i].serverId == serverId )
-                return true;
-        }
-        return false;
+        return core::hash::has( *idIndex, id_key( clientId, serverId ) );
     }
 }
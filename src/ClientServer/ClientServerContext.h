@@ -4,6 +4,7 @@
 #define PROTOCOL_CLIENT_SERVER_CONTEXT_H
 
 #include "core/Core.h"
+#include "core/Hash.h"
 #include "network/Address.h"
 
 namespace clientServer
@@ -26,6 +27,10 @@ namespace clientServer
 
         ClientInfo * clientInfo = nullptr;
 
+        core::Hash<int> * addressIndex = nullptr;           // client index by address hash. IMPORTANT: keys may collide, so always compare the address.
+
+        core::Hash<int> * idIndex = nullptr;                // client index by client id and server id, for ClientPotentiallyExists.
+
         void Initialize( core::Allocator & allocator, int numClients );
 
         void Free( core::Allocator & allocator );
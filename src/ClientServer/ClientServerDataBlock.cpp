@@ -3,6 +3,9 @@
 #include "ClientServerDataBlock.h"
 #include "ClientServerPackets.h"
 #include "network/Interface.h"
+#include "protocol/Block.h"
+#include "protocol/ProtocolConstants.h"
+#include "core/Allocator.h"
 
 namespace clientServer
 {
@@ -35,4 +38,139 @@ namespace clientServer
 
         m_info.networkInterface->SendPacket( m_info.address, packet );
     }
+
+    ServerDataSender::ServerDataSender( core::Allocator & allocator, protocol::Block & dataBlock, int fragmentSize, int fragmentsPerSecond, int maxClients )
+    {
+        CORE_ASSERT( dataBlock.GetSize() > 0 );
+        CORE_ASSERT( dataBlock.GetData() );
+        CORE_ASSERT( fragmentSize > 0 );
+        CORE_ASSERT( fragmentSize <= protocol::MaxFragmentSize );
+        CORE_ASSERT( fragmentsPerSecond > 0 );
+        CORE_ASSERT( maxClients > 0 );
+
+        m_allocator = &allocator;
+        m_data = dataBlock.GetData();
+        m_blockSize = dataBlock.GetSize();
+        m_fragmentSize = fragmentSize;
+        m_numFragments = m_blockSize / m_fragmentSize + ( ( m_blockSize % m_fragmentSize ) ? 1 : 0 );
+        m_timeBetweenFragments = 1.0f / fragmentsPerSecond;
+        m_maxClients = maxClients;
+        m_ackWords = ( m_numFragments + 63 ) / 64;
+
+        m_clients = (ClientState*) m_allocator->Allocate( sizeof( ClientState ) * m_maxClients );
+        m_ackedFragments = (uint64_t*) m_allocator->Allocate( sizeof( uint64_t ) * m_ackWords * m_maxClients );
+
+        for ( int i = 0; i < m_maxClients; ++i )
+            Reset( i );
+    }
+
+    ServerDataSender::~ServerDataSender()
+    {
+        CORE_ASSERT( m_allocator );
+        CORE_ASSERT( m_clients );
+        CORE_ASSERT( m_ackedFragments );
+
+        m_allocator->Free( m_clients );
+        m_allocator->Free( m_ackedFragments );
+        m_clients = nullptr;
+        m_ackedFragments = nullptr;
+        m_allocator = nullptr;
+    }
+
+    void ServerDataSender::Reset( int clientIndex )
+    {
+        CORE_ASSERT( clientIndex >= 0 );
+        CORE_ASSERT( clientIndex < m_maxClients );
+
+        ClientState & client = m_clients[clientIndex];
+        client.fragmentIndex = 0;
+        client.numAckedFragments = 0;
+        client.lastFragmentSendTime = 0.0;
+
+        memset( m_ackedFragments + clientIndex * m_ackWords, 0, sizeof( uint64_t ) * m_ackWords );
+    }
+
+    void ServerDataSender::Update( int clientIndex, const core::TimeBase & timeBase, const ClientServerInfo & info )
+    {
+        CORE_ASSERT( clientIndex >= 0 );
+        CORE_ASSERT( clientIndex < m_maxClients );
+
+        ClientState & client = m_clients[clientIndex];
+
+        if ( client.lastFragmentSendTime + m_timeBetweenFragments >= timeBase.time )
+            return;
+
+        client.lastFragmentSendTime = timeBase.time;
+
+        CORE_ASSERT( client.numAckedFragments < m_numFragments );
+
+        const uint64_t * acked = m_ackedFragments + clientIndex * m_ackWords;
+
+        for ( int i = 0; i < m_numFragments; ++i )
+        {
+            if ( !( acked[client.fragmentIndex>>6] & ( uint64_t(1) << ( client.fragmentIndex & 63 ) ) ) )
+                break;
+            client.fragmentIndex++;
+            client.fragmentIndex %= m_numFragments;
+        }
+
+        const int fragmentId = client.fragmentIndex;
+
+        CORE_ASSERT( fragmentId >= 0 );
+        CORE_ASSERT( fragmentId < m_numFragments );
+
+        int fragmentBytes = m_fragmentSize;
+        if ( fragmentId == m_numFragments - 1 )
+            fragmentBytes = m_blockSize - ( m_numFragments - 1 ) * m_fragmentSize;
+
+        CORE_ASSERT( fragmentBytes > 0 );
+        CORE_ASSERT( fragmentBytes <= protocol::MaxFragmentSize );
+
+        auto packet = (DataBlockFragmentPacket*) info.packetFactory->Create( CLIENT_SERVER_PACKET_DATA_BLOCK_FRAGMENT );
+
+        packet->clientId = info.clientId;
+        packet->serverId = info.serverId;
+        packet->blockSize = m_blockSize;
+        packet->fragmentSize = m_fragmentSize;
+        packet->numFragments = m_numFragments;
+        packet->fragmentId = fragmentId;
+        packet->fragmentBytes = fragmentBytes;
+        packet->fragmentData = m_data + fragmentId * m_fragmentSize;
+        packet->sharedFragmentData = true;
+
+        info.networkInterface->SendPacket( info.address, packet );
+
+        client.fragmentIndex = ( fragmentId + 1 ) % m_numFragments;
+    }
+
+    void ServerDataSender::ProcessAck( int clientIndex, int fragmentId )
+    {
+        CORE_ASSERT( clientIndex >= 0 );
+        CORE_ASSERT( clientIndex < m_maxClients );
+
+        if ( fragmentId < 0 || fragmentId >= m_numFragments )
+            return;
+
+        uint64_t & word = m_ackedFragments[clientIndex * m_ackWords + ( fragmentId >> 6 )];
+        const uint64_t bit = uint64_t(1) << ( fragmentId & 63 );
+
+        if ( !( word & bit ) )
+        {
+            word |= bit;
+            m_clients[clientIndex].numAckedFragments++;
+            CORE_ASSERT( m_clients[clientIndex].numAckedFragments <= m_numFragments );
+        }
+    }
+
+    bool ServerDataSender::SendCompleted( int clientIndex ) const
+    {
+        return GetNumAckedFragments( clientIndex ) == m_numFragments;
+    }
+
+    int ServerDataSender::GetNumAckedFragments( int clientIndex ) const
+    {
+        CORE_ASSERT( clientIndex >= 0 );
+        CORE_ASSERT( clientIndex < m_maxClients );
+        return m_clients[clientIndex].numAckedFragments;
+    }
 }
@@ -41,6 +41,62 @@ namespace clientServer
         void SendFragment( int fragmentId, uint8_t * fragmentData, int fragmentBytes );
     };
 
+    /*
+        Sends one constant block (the server data) to many clients at once.
+
+        Fragment layout and payload are shared. Each client slot only has an
+        ack bitmap and a pacing cursor, and fragment packets point straight
+        into the block instead of copying it, so a wave of connecting clients
+        costs a few bytes per slot.
+
+        IMPORTANT: the block must outlive any fragment packets in flight.
+    */
+
+    class ServerDataSender
+    {
+    public:
+
+        ServerDataSender( core::Allocator & allocator, protocol::Block & dataBlock, int fragmentSize, int fragmentsPerSecond, int maxClients );
+
+        ~ServerDataSender();
+
+        void Reset( int clientIndex );
+
+        void Update( int clientIndex, const core::TimeBase & timeBase, const ClientServerInfo & info );
+
+        void ProcessAck( int clientIndex, int fragmentId );
+
+        bool SendCompleted( int clientIndex ) const;
+
+        int GetBlockSize() const { return m_blockSize; }
+        int GetFragmentSize() const { return m_fragmentSize; }
+        int GetNumFragments() const { return m_numFragments; }
+        int GetNumAckedFragments( int clientIndex ) const;
+
+    private:
+
+        struct ClientState
+        {
+            int fragmentIndex;
+            int numAckedFragments;
+            double lastFragmentSendTime;
+        };
+
+        core::Allocator * m_allocator;
+        uint8_t * m_data;
+        int m_blockSize;
+        int m_fragmentSize;
+        int m_numFragments;
+        float m_timeBetweenFragments;
+        int m_maxClients;
+        int m_ackWords;                     // uint64_t words of ack bitmap per client.
+        ClientState * m_clients;
+        uint64_t * m_ackedFragments;        // ack bitmaps for all clients. m_ackWords per client.
+
+        ServerDataSender( const ServerDataSender & other );
+        ServerDataSender & operator = ( const ServerDataSender & other );
+    };
+
     class DataBlockReceiver : public protocol::DataBlockReceiver
     {
         ClientServerInfo m_info;
@@ -80,7 +80,6 @@ namespace clientServer
     enum ServerClientState
     {
         SERVER_CLIENT_STATE_DISCONNECTED,                       // client is disconnected. default state.
-        SERVER_CLIENT_STATE_SENDING_CHALLENGE,                  // responding with connection challenge waiting for challenge response
         SERVER_CLIENT_STATE_SENDING_SERVER_DATA,                // sending server data to client
         SERVER_CLIENT_STATE_READY_FOR_CONNECTION,               // server side is ready for connection. once client is also ready the connection is established.
         SERVER_CLIENT_STATE_CONNECTED                           // client is fully connected. connection packets are now exchanged.
@@ -91,7 +90,6 @@ namespace clientServer
         switch ( clientState )
         {
             case SERVER_CLIENT_STATE_DISCONNECTED:              return "DISCONNECTED";
-            case SERVER_CLIENT_STATE_SENDING_CHALLENGE:         return "SENDING_CHALLENGE";
             case SERVER_CLIENT_STATE_SENDING_SERVER_DATA:       return "SENDING_SERVER_DATA";
             case SERVER_CLIENT_STATE_READY_FOR_CONNECTION:      return "READY_FOR_CONNECTION";
             case SERVER_CLIENT_STATE_CONNECTED:                 return "CONNECTION";
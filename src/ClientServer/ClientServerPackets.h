@@ -24,7 +24,7 @@ namespace clientServer
         // server -> client
 
         CLIENT_SERVER_PACKET_CONNECTION_DENIED,                 // server denies request for connection. contains reason int, eg. full, closed etc.
-        CLIENT_SERVER_PACKET_CONNECTION_CHALLENGE,              // server response to client connection request.
+        CLIENT_SERVER_PACKET_CONNECTION_CHALLENGE,              // server response to client connection request. stateless: no client slot is reserved until a valid challenge response arrives.
 
         // bidirectional
 
@@ -52,6 +52,8 @@ namespace clientServer
     {
         uint16_t clientId = 0;
         uint16_t serverId = 0;
+        uint64_t challengeTime = 0;                             // echoed back from the connection challenge.
+        uint64_t challengeToken = 0;                            // echoed back from the connection challenge.
 
         ChallengeResponsePacket() : Packet( CLIENT_SERVER_PACKET_CHALLENGE_RESPONSE ) {}
 
@@ -59,6 +61,8 @@ namespace clientServer
         {
             serialize_uint16( stream, clientId );
             serialize_uint16( stream, serverId );
+            serialize_uint64( stream, challengeTime );
+            serialize_uint64( stream, challengeToken );
         }
     };
 
@@ -80,6 +84,8 @@ namespace clientServer
     {
         uint16_t clientId = 0;
         uint16_t serverId = 0;
+        uint64_t challengeTime = 0;                             // server time in milliseconds when the challenge was issued.
+        uint64_t challengeToken = 0;                            // MAC of client address, ids and challenge time, keyed with a server secret.
 
         ConnectionChallengePacket() : Packet( CLIENT_SERVER_PACKET_CONNECTION_CHALLENGE ) {}
 
@@ -87,6 +93,8 @@ namespace clientServer
         {
             serialize_uint16( stream, clientId );
             serialize_uint16( stream, serverId );
+            serialize_uint64( stream, challengeTime );
+            serialize_uint64( stream, challengeToken );
         }
     };
 
@@ -114,6 +122,7 @@ namespace clientServer
         uint32_t fragmentId : 16;
         uint32_t fragmentBytes : 16;
         uint8_t * fragmentData = nullptr;
+        bool sharedFragmentData = false;                        // if true, fragment data points into a block that outlives this packet and is not freed.
 
         DataBlockFragmentPacket() : Packet( CLIENT_SERVER_PACKET_DATA_BLOCK_FRAGMENT ) 
         {
@@ -123,7 +132,7 @@ namespace clientServer
 
         ~DataBlockFragmentPacket()
         {
-            if ( fragmentData )
+            if ( fragmentData && !sharedFragmentData )
             {
                 core::memory::scratch_allocator().Free( fragmentData );
                 fragmentData = nullptr;
@@ -0,0 +1,83 @@
+// Client Server Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#include "RateController.h"
+
+namespace clientServer
+{
+    RateController::RateController( const RateControllerConfig & config )
+        : m_config( config )
+    {
+        CORE_ASSERT( m_config.minSendRate > 0.0f );
+        CORE_ASSERT( m_config.minSendRate <= m_config.maxSendRate );
+        CORE_ASSERT( m_config.minPacketSize <= m_config.maxPacketSize );
+        CORE_ASSERT( m_config.multiplicativeDecrease > 0.0f );
+        CORE_ASSERT( m_config.multiplicativeDecrease < 1.0f );
+        CORE_ASSERT( m_config.minRTTWindow > 0.0f );
+
+        Reset();
+    }
+
+    void RateController::Reset()
+    {
+        m_sendRate = m_config.minSendRate;
+        m_minRTT = 0.0f;
+        m_windowMinRTT = 0.0f;
+        m_windowTime = 0.0;
+        m_accumulator = 0.0;
+        m_congested = false;
+    }
+
+    void RateController::Update( double deltaTime, float rtt, float packetLoss )
+    {
+        // IMPORTANT: RTT of zero means no packets have been acked yet. Hold the rate until we have a measurement.
+
+        if ( rtt <= 0.0f )
+            return;
+
+        // windowed minimum RTT: the lowest RTT of the previous window and the window in progress.
+        // if the base RTT goes up, eg. on a route change, the old minimum ages out within two windows
+
+        if ( m_minRTT == 0.0f || rtt < m_minRTT )
+            m_minRTT = rtt;
+
+        if ( m_windowMinRTT == 0.0f || rtt < m_windowMinRTT )
+            m_windowMinRTT = rtt;
+
+        m_windowTime += deltaTime;
+
+        if ( m_windowTime >= m_config.minRTTWindow )
+        {
+            m_minRTT = m_windowMinRTT;
+            m_windowMinRTT = 0.0f;
+            m_windowTime = 0.0;
+        }
+
+        m_accumulator += deltaTime;
+
+        if ( m_accumulator < m_config.adjustTime )
+            return;
+
+        m_accumulator = 0.0;
+
+        m_congested = packetLoss > m_config.maxPacketLoss ||
+                      rtt > m_config.maxRTT ||
+                      rtt - m_minRTT > m_config.maxQueueDelay;
+
+        if ( m_congested )
+            m_sendRate *= m_config.multiplicativeDecrease;
+        else
+            m_sendRate += m_config.additiveIncrease;
+
+        m_sendRate = core::clamp( m_sendRate, m_config.minSendRate, m_config.maxSendRate );
+    }
+
+    int RateController::GetPacketSize() const
+    {
+        if ( m_config.maxSendRate <= m_config.minSendRate )
+            return m_config.maxPacketSize;
+
+        const float t = ( m_sendRate - m_config.minSendRate ) / ( m_config.maxSendRate - m_config.minSendRate );
+
+        return m_config.minPacketSize + (int) ( t * ( m_config.maxPacketSize - m_config.minPacketSize ) );
+    }
+}
@@ -0,0 +1,67 @@
+// Client Server Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#ifndef CLIENT_SERVER_RATE_CONTROLLER_H
+#define CLIENT_SERVER_RATE_CONTROLLER_H
+
+#include "core/Core.h"
+
+namespace clientServer
+{
+    struct RateControllerConfig
+    {
+        float minSendRate = 10.0f;                              // floor for the connected send rate in packets per-second.
+        float maxSendRate = 60.0f;                              // ceiling for the connected send rate in packets per-second.
+
+        int minPacketSize = 256;                                // packet size in bytes recommended at the minimum send rate. must fit the largest message or block fragment plus the connection packet header.
+        int maxPacketSize = 1024;                               // packet size in bytes recommended at the maximum send rate.
+
+        float adjustTime = 0.25f;                               // seconds between send rate adjustments.
+        float additiveIncrease = 2.0f;                          // packets per-second added to the send rate per adjustment while the link is good.
+        float multiplicativeDecrease = 0.75f;                   // send rate is multiplied by this on each adjustment while the link is congested.
+
+        float maxRTT = 0.25f;                                   // RTT above this many seconds is treated as congestion.
+        float maxQueueDelay = 0.05f;                            // RTT above the lowest recent RTT by more than this many seconds is treated as congestion (bufferbloat).
+        float minRTTWindow = 10.0f;                             // the lowest RTT is taken over the last one to two windows of this many seconds, so it follows route changes.
+        float maxPacketLoss = 5.0f;                             // packet loss above this percentage is treated as congestion.
+    };
+
+    /*
+        AIMD send rate controller for connected clients.
+
+        Fed the smoothed RTT and packet loss measured by the connection,
+        it increases the send rate additively while the link is good and
+        backs off multiplicatively as soon as loss, high RTT or growing
+        queuing delay indicate congestion. The recommended packet size
+        scales with the send rate between the min and max packet size.
+    */
+
+    class RateController
+    {
+        RateControllerConfig m_config;
+
+        float m_sendRate;
+        float m_minRTT;
+        float m_windowMinRTT;
+        double m_windowTime;
+        double m_accumulator;
+        bool m_congested;
+
+    public:
+
+        RateController( const RateControllerConfig & config = RateControllerConfig() );
+
+        void Reset();
+
+        void Update( double deltaTime, float rtt, float packetLoss );
+
+        float GetSendRate() const { return m_sendRate; }
+
+        int GetPacketSize() const;
+
+        bool IsCongested() const { return m_congested; }
+
+        const RateControllerConfig & GetConfig() const { return m_config; }
+    };
+}
+
+#endif
@@ -3,11 +3,14 @@
 #include "Server.h"
 #include "network/Simulator.h"
 #include "core/Memory.h"
+#include <string.h>
 
 namespace clientServer
 {
     Server::Server( const ServerConfig & config )
-        : m_config( config )
+        : m_config( config ),
+          m_connectionPool( config.allocator ? *config.allocator : core::memory::default_allocator() ),
+          m_dataBlockReceiverPool( config.allocator ? *config.allocator : core::memory::default_allocator() )
     {
         CORE_ASSERT( m_config.networkInterface );
         CORE_ASSERT( m_config.channelStructure );
@@ -32,24 +35,20 @@ namespace clientServer
 
         m_config.networkInterface->SetContext( m_context );
 
-        protocol::ConnectionConfig connectionConfig;
-        connectionConfig.maxPacketSize = m_config.networkInterface->GetMaxPacketSize();
-        connectionConfig.channelStructure = m_config.channelStructure;
-        connectionConfig.packetFactory = m_packetFactory;
-        connectionConfig.context = m_context;
+        core::random_bytes( m_challengeKey, sizeof( m_challengeKey ) );
+
+        m_connectionConfig.maxPacketSize = m_config.networkInterface->GetMaxPacketSize();
+        m_connectionConfig.channelStructure = m_config.channelStructure;
+        m_connectionConfig.packetFactory = m_packetFactory;
+        m_connectionConfig.context = m_context;
 
         m_clients = CORE_NEW_ARRAY( *m_allocator, ClientData, m_numClients );
 
         for ( int i = 0; i < m_numClients; ++i )
-        {
-            m_clients[i].connection = CORE_NEW( *m_allocator, protocol::Connection, connectionConfig );
-
-            if ( m_config.serverData )
-                m_clients[i].dataBlockSender = CORE_NEW( *m_allocator, DataBlockSender, *m_allocator, *m_config.serverData, m_config.fragmentSize, m_config.fragmentsPerSecond );
+            m_clients[i].rateController = RateController( m_config.rateController );
 
-            if ( m_config.maxClientDataSize > 0 )
-                m_clients[i].dataBlockReceiver = CORE_NEW( *m_allocator, DataBlockReceiver, *m_allocator, m_config.fragmentSize, m_config.maxClientDataSize );
-        }
+        if ( m_config.serverData )
+            m_serverDataSender = CORE_NEW( *m_allocator, ServerDataSender, *m_allocator, *m_config.serverData, m_config.fragmentSize, m_config.fragmentsPerSecond, m_numClients );
     }
 
     Server::~Server()
@@ -62,23 +61,36 @@ namespace clientServer
 
         for ( int i = 0; i < m_numClients; ++i )
         {
-            CORE_ASSERT( m_clients[i].connection );
-            CORE_DELETE( *m_allocator, Connection, m_clients[i].connection );
-            m_clients[i].connection = nullptr;
+            ClientData & client = m_clients[i];
 
-            if ( m_clients[i].dataBlockSender )
+            if ( client.connection )
             {
-                CORE_DELETE( *m_allocator, DataBlockSender, m_clients[i].dataBlockSender );
-                m_clients[i].dataBlockSender = nullptr;
+                ReleaseConnection( client.connection );
+                client.connection = nullptr;
             }
 
-            if ( m_clients[i].dataBlockReceiver )
+            if ( client.dataBlockReceiver )
             {
-                CORE_DELETE( *m_allocator, DataBlockReceiver, m_clients[i].dataBlockReceiver );
-                m_clients[i].dataBlockReceiver = nullptr;
+                ReleaseDataBlockReceiver( client.dataBlockReceiver );
+                client.dataBlockReceiver = nullptr;
             }
         }
 
+        if ( m_serverDataSender )
+        {
+            CORE_DELETE( *m_allocator, ServerDataSender, m_serverDataSender );
+            m_serverDataSender = nullptr;
+        }
+
+        for ( uint32_t i = 0; i < core::array::size( m_connectionPool ); ++i )
+            CORE_DELETE( *m_allocator, Connection, m_connectionPool[i] );
+
+        for ( uint32_t i = 0; i < core::array::size( m_dataBlockReceiverPool ); ++i )
+            CORE_DELETE( *m_allocator, DataBlockReceiver, m_dataBlockReceiverPool[i] );
+
+        core::array::clear( m_connectionPool );
+        core::array::clear( m_dataBlockReceiverPool );
+
         CORE_DELETE_ARRAY( *m_allocator, m_clients, m_numClients );
 
         m_clients = nullptr;
@@ -159,6 +171,21 @@ namespace clientServer
         return client.dataBlockReceiver ? client.dataBlockReceiver->GetBlock() : nullptr;
     }
 
+    float Server::GetClientSendRate( int clientIndex ) const
+    {
+        CORE_ASSERT( clientIndex >= 0 );
+        CORE_ASSERT( clientIndex < m_numClients );
+        return m_config.adaptiveSendRate ? m_clients[clientIndex].rateController.GetSendRate() : m_config.connectedSendRate;
+    }
+
+    int Server::GetClientPacketSize( int clientIndex ) const
+    {
+        CORE_ASSERT( clientIndex >= 0 );
+        CORE_ASSERT( clientIndex < m_numClients );
+        const ClientData & client = m_clients[clientIndex];
+        return client.connection ? client.connection->GetPacketSize() : m_config.networkInterface->GetMaxPacketSize();
+    }
+
     void Server::SetContext( int index, const void * ptr )
     {
         CORE_ASSERT( index >= CONTEXT_USER );
@@ -172,10 +199,6 @@ namespace clientServer
         {
             switch ( m_clients[i].state )
             {
-                case SERVER_CLIENT_STATE_SENDING_CHALLENGE:
-                    UpdateSendingChallenge( i );
-                    break;
-
                 case SERVER_CLIENT_STATE_SENDING_SERVER_DATA:
                     UpdateSendingServerData( i );
                     break;
@@ -196,34 +219,14 @@ namespace clientServer
 
             if ( m_clients[i].state == SERVER_CLIENT_STATE_READY_FOR_CONNECTION && m_clients[i].readyForConnection )
             {
+                CORE_ASSERT( !m_clients[i].connection );
+                m_clients[i].connection = AcquireConnection();
                 SetClientState( i, SERVER_CLIENT_STATE_CONNECTED );
                 m_clients[i].accumulator = 0.0f;
             }
         }
     }
 
-    void Server::UpdateSendingChallenge( int clientIndex )
-    {
-        CORE_ASSERT( clientIndex >= 0 );
-        CORE_ASSERT( clientIndex < m_numClients );
-
-        ClientData & client = m_clients[clientIndex];
-
-        CORE_ASSERT( client.state == SERVER_CLIENT_STATE_SENDING_CHALLENGE );
-
-        if ( client.accumulator > 1.0 / m_config.connectingSendRate )
-        {
-            auto packet = (ConnectionChallengePacket*) m_packetFactory->Create( CLIENT_SERVER_PACKET_CONNECTION_CHALLENGE );
-
-            packet->clientId = client.clientId;
-            packet->serverId = client.serverId;
-
-            SendPacket( client.address, packet );
-
-            client.accumulator = 0.0;
-        }
-    }
-
     void Server::UpdateSendingServerData( int clientIndex )
     {
         CORE_ASSERT( clientIndex >= 0 );
@@ -236,7 +239,14 @@ namespace clientServer
 
         CORE_ASSERT( client.state == SERVER_CLIENT_STATE_SENDING_SERVER_DATA );
 
-        client.dataBlockSender->Update( m_timeBase );
+        ClientServerInfo info;
+        info.address = client.address;
+        info.clientId = client.clientId;
+        info.serverId = client.serverId;
+        info.packetFactory = m_packetFactory;
+        info.networkInterface = m_config.networkInterface;
+
+        m_serverDataSender->Update( clientIndex, m_timeBase, info );
     }
 
     void Server::UpdateReadyForConnection( int clientIndex )
@@ -281,7 +291,13 @@ namespace clientServer
             return;
         }
 
-        if ( client.accumulator > 1.0 / m_config.connectedSendRate )
+        if ( m_config.adaptiveSendRate )
+        {
+            client.rateController.Update( m_timeBase.deltaTime, client.connection->GetRTT(), client.connection->GetPacketLoss() );
+            client.connection->SetPacketSize( client.rateController.GetPacketSize() );
+        }
+
+        if ( client.accumulator > 1.0 / GetClientSendRate( clientIndex ) )
         {
             auto packet = client.connection->WritePacket();
 
@@ -418,14 +434,13 @@ namespace clientServer
             return;
         }
 
-        if ( FindClientSlot( address, packet->clientId ) != -1 )
+        if ( clientIndex != -1 )
         {
             // printf( "ignoring connection request. client already has a slot\n" );
             return;
         }
 
-        clientIndex = FindFreeClientSlot();
-        if ( clientIndex == -1 )
+        if ( FindFreeClientSlot() == -1 )
         {
             // printf( "server is full. denying connection request\n" );
             auto connectionDeniedPacket = (ConnectionDeniedPacket*) m_packetFactory->Create( CLIENT_SERVER_PACKET_CONNECTION_DENIED );
@@ -435,6 +450,52 @@ namespace clientServer
             return;
         }
 
+        // IMPORTANT: stateless. nothing is stored until the client echoes back a valid challenge token,
+        // so a flood of connection requests (eg. from spoofed addresses) cannot tie up client slots.
+
+        auto challengePacket = (ConnectionChallengePacket*) m_packetFactory->Create( CLIENT_SERVER_PACKET_CONNECTION_CHALLENGE );
+        challengePacket->clientId = packet->clientId;
+        challengePacket->serverId = core::generate_id();
+        challengePacket->challengeTime = uint64_t( m_timeBase.time * 1000.0 );
+        challengePacket->challengeToken = GenerateChallengeToken( address, challengePacket->clientId, challengePacket->serverId, challengePacket->challengeTime );
+
+        SendPacket( address, challengePacket );
+    }
+
+    void Server::ProcessChallengeResponsePacket( ChallengeResponsePacket * packet )
+    {
+        CORE_ASSERT( packet );
+
+        auto address = packet->GetAddress();
+
+        const uint64_t time = uint64_t( m_timeBase.time * 1000.0 );
+
+        if ( packet->challengeTime > time || time - packet->challengeTime > uint64_t( m_config.challengeTimeOut * 1000.0 ) )
+            return;
+
+        if ( packet->challengeToken != GenerateChallengeToken( address, packet->clientId, packet->serverId, packet->challengeTime ) )
+            return;
+
+        if ( !m_open )
+            return;
+
+        if ( FindClientSlot( address ) != -1 )
+        {
+            // printf( "ignoring challenge response. client already has a slot\n" );
+            return;
+        }
+
+        const int clientIndex = FindFreeClientSlot();
+        if ( clientIndex == -1 )
+        {
+            // printf( "server filled up while challenging. denying connection\n" );
+            auto connectionDeniedPacket = (ConnectionDeniedPacket*) m_packetFactory->Create( CLIENT_SERVER_PACKET_CONNECTION_DENIED );
+            connectionDeniedPacket->clientId = packet->clientId;
+            connectionDeniedPacket->reason = CONNECTION_REQUEST_DENIED_SERVER_FULL;
+            SendPacket( address, connectionDeniedPacket );
+            return;
+        }
+
         // printf( "incoming client connection at index %d\n", clientIndex );
 
         CORE_ASSERT( clientIndex >= 0 );
@@ -444,10 +505,15 @@ namespace clientServer
 
         client.address = address;
         client.clientId = packet->clientId;
-        client.serverId = core::generate_id();
+        client.serverId = packet->serverId;
+        client.accumulator = 0.0;
         client.lastPacketTime = m_timeBase.time;
 
-        SetClientState( clientIndex, SERVER_CLIENT_STATE_SENDING_CHALLENGE );
+        if ( m_serverDataSender )
+            m_serverDataSender->Reset( clientIndex );
+
+        if ( m_config.maxClientDataSize > 0 )
+            client.dataBlockReceiver = AcquireDataBlockReceiver();
 
         ClientServerInfo info;
         info.address = address;
@@ -456,30 +522,11 @@ namespace clientServer
         info.packetFactory = m_packetFactory;
         info.networkInterface = m_config.networkInterface;
 
-        if ( client.dataBlockSender )
-            client.dataBlockSender->SetInfo( info );
-
         if ( client.dataBlockReceiver )
             client.dataBlockReceiver->SetInfo( info );
 
         m_clientServerContext.AddClient( clientIndex, client.address, client.clientId, client.serverId );
-    }
-
-    void Server::ProcessChallengeResponsePacket( ChallengeResponsePacket * packet )
-    {
-        CORE_ASSERT( packet );
-
-        const int clientIndex = FindClientSlot( packet->GetAddress(), packet->clientId, packet->serverId );
-        if ( clientIndex == -1 )
-            return;
 
-        ClientData & client = m_clients[clientIndex];
-
-        if ( client.state != SERVER_CLIENT_STATE_SENDING_CHALLENGE )
-            return;
-
-        client.accumulator = 0.0;
-        client.lastPacketTime = m_timeBase.time;
         SetClientState( clientIndex, m_config.serverData ? SERVER_CLIENT_STATE_SENDING_SERVER_DATA : SERVER_CLIENT_STATE_READY_FOR_CONNECTION );
     }
 
@@ -555,15 +602,15 @@ namespace clientServer
         if ( client.serverId != packet->serverId )
             return;
         
-        if ( !client.dataBlockSender )
+        if ( !m_serverDataSender )
             return;
 
-        if ( client.dataBlockSender->SendCompleted() )
+        if ( client.state != SERVER_CLIENT_STATE_SENDING_SERVER_DATA )
             return;
 
-        client.dataBlockSender->ProcessAck( packet->fragmentId );
+        m_serverDataSender->ProcessAck( clientIndex, packet->fragmentId );
 
-        if ( client.dataBlockSender->SendCompleted() )
+        if ( m_serverDataSender->SendCompleted( clientIndex ) )
         {
             client.accumulator = 0.0;
             client.lastPacketTime = m_timeBase.time;
@@ -639,15 +686,87 @@ namespace clientServer
 
         SetClientState( clientIndex, SERVER_CLIENT_STATE_DISCONNECTED );
 
-        client.Clear();
+        if ( client.connection )
+        {
+            ReleaseConnection( client.connection );
+            client.connection = nullptr;
+        }
 
-        CORE_ASSERT( client.connection );
+        if ( client.dataBlockReceiver )
+        {
+            ReleaseDataBlockReceiver( client.dataBlockReceiver );
+            client.dataBlockReceiver = nullptr;
+        }
 
-        client.connection->Reset();
+        client.Clear();
 
         m_clientServerContext.RemoveClient( clientIndex );
     }
 
+    protocol::Connection * Server::AcquireConnection()
+    {
+        if ( core::array::size( m_connectionPool ) )
+        {
+            auto connection = core::array::back( m_connectionPool );
+            core::array::pop_back( m_connectionPool );
+            return connection;
+        }
+
+        return CORE_NEW( *m_allocator, protocol::Connection, m_connectionConfig );
+    }
+
+    DataBlockReceiver * Server::AcquireDataBlockReceiver()
+    {
+        CORE_ASSERT( m_config.maxClientDataSize > 0 );
+
+        if ( core::array::size( m_dataBlockReceiverPool ) )
+        {
+            auto dataBlockReceiver = core::array::back( m_dataBlockReceiverPool );
+            core::array::pop_back( m_dataBlockReceiverPool );
+            return dataBlockReceiver;
+        }
+
+        return CORE_NEW( *m_allocator, DataBlockReceiver, *m_allocator, m_config.fragmentSize, m_config.maxClientDataSize );
+    }
+
+    void Server::ReleaseConnection( protocol::Connection * connection )
+    {
+        CORE_ASSERT( connection );
+        connection->Reset();
+        core::array::push_back( m_connectionPool, connection );
+    }
+
+    void Server::ReleaseDataBlockReceiver( DataBlockReceiver * dataBlockReceiver )
+    {
+        CORE_ASSERT( dataBlockReceiver );
+        dataBlockReceiver->Clear();
+        core::array::push_back( m_dataBlockReceiverPool, dataBlockReceiver );
+    }
+
+    uint64_t Server::GenerateChallengeToken( const network::Address & address, uint16_t clientId, uint16_t serverId, uint64_t challengeTime ) const
+    {
+        uint8_t data[32];
+        memset( data, 0, sizeof( data ) );
+
+        data[0] = address.GetType();
+        const uint16_t port = address.GetPort();
+        memcpy( data + 2, &port, 2 );
+        if ( address.GetType() == network::ADDRESS_IPV4 )
+        {
+            const uint32_t address4 = address.GetAddress4();
+            memcpy( data + 4, &address4, 4 );
+        }
+        else if ( address.GetType() == network::ADDRESS_IPV6 )
+        {
+            memcpy( data + 4, address.GetAddress6(), 16 );
+        }
+        memcpy( data + 20, &clientId, 2 );
+        memcpy( data + 22, &serverId, 2 );
+        memcpy( data + 24, &challengeTime, 8 );
+
+        return core::siphash_24( data, sizeof( data ), m_challengeKey );
+    }
+
     void Server::SendPacket( const network::Address & address, protocol::Packet * packet )
     {
         auto interface = m_config.networkSimulator ? m_config.networkSimulator : m_config.networkInterface;
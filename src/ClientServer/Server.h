@@ -4,10 +4,12 @@
 #define CLIENT_SERVER_SERVER_H
 
 #include "protocol/Connection.h"
+#include "core/Array.h"
 #include "ClientServerContext.h"
 #include "ClientServerDataBlock.h"
 #include "ClientServerPackets.h"
 #include "ClientServerEnums.h"
+#include "RateController.h"
 
 namespace core { class Allocator; }
 
@@ -28,7 +30,11 @@ namespace clientServer
         float connectingSendRate = 10;                          // packets to send per-second while a client slot is connecting.
         float connectedSendRate = 30;                           // packets to send per-second once a client is connected.
 
+        bool adaptiveSendRate = false;                          // if true the connected send rate adapts per-client to measured RTT and packet loss instead of using connectedSendRate.
+        RateControllerConfig rateController;                    // floor, ceiling and tuning for the adaptive send rate. only used if adaptiveSendRate is true.
+
         float connectingTimeOut = 5.0f;                         // timeout in seconds while a client is connecting
+        float challengeTimeOut = 5.0f;                          // seconds a connection challenge token stays valid. no slot is reserved until the client responds.
         float connectedTimeOut = 10.0f;                         // timeout in seconds once a client is connected
 
         network::Interface * networkInterface = nullptr;        // network interface used to send and receive packets
@@ -54,14 +60,13 @@ namespace clientServer
             uint16_t serverId;                          // the server id generated randomly on connection request unique to this client.
             ServerClientState state;                    // the current state of this client slot.
             bool readyForConnection;                    // set to true once the client is ready for a connection to start, eg. client has sent their client data across (if any)
-            protocol::Connection * connection;          // connection object. active in SERVER_CLIENT_STATE_CONNECTION.
-            DataBlockSender * dataBlockSender;          // data block sender. active while in SERVER_CLIENT_STATE_SENDING_SERVER_DATA.
-            DataBlockReceiver * dataBlockReceiver;      // data block receiver. active while in SERVER_CLIENT_STATE_SENDING_SERVER_DATA.
+            protocol::Connection * connection;          // connection object. taken from the pool on SERVER_CLIENT_STATE_CONNECTED.
+            DataBlockReceiver * dataBlockReceiver;      // data block receiver. taken from the pool when the slot is committed. holds the client data until the slot is reset.
+            RateController rateController;              // adaptive send rate for this client. active in SERVER_CLIENT_STATE_CONNECTED if adaptive send rate is enabled.
 
             ClientData()
             {
                 connection = nullptr;
-                dataBlockSender = nullptr;
                 dataBlockReceiver = nullptr;
                 Clear();
             }
@@ -75,11 +80,10 @@ namespace clientServer
                 state = SERVER_CLIENT_STATE_DISCONNECTED;
                 readyForConnection = false;
 
-                if ( dataBlockSender )
-                    dataBlockSender->Clear();
+                rateController.Reset();
 
-                if ( dataBlockReceiver )
-                    dataBlockReceiver->Clear();
+                CORE_ASSERT( !connection );                 // IMPORTANT: return slot objects to the pool before clearing
+                CORE_ASSERT( !dataBlockReceiver );
             }
         };
 
@@ -95,12 +99,24 @@ namespace clientServer
 
         ClientData * m_clients = nullptr;
 
+        protocol::ConnectionConfig m_connectionConfig;
+
+        // IMPORTANT: slot objects are created on demand and recycled, so a server with
+        // thousands of slots only pays for the clients that actually get that far.
+
+        core::Array<protocol::Connection*> m_connectionPool;
+        core::Array<DataBlockReceiver*> m_dataBlockReceiverPool;
+
+        ServerDataSender * m_serverDataSender = nullptr;          // sends the server data to all connecting clients. only created if there is server data.
+
         protocol::PacketFactory * m_packetFactory = nullptr;       // important: we don't own this pointer. it comes from the network interface
 
         ClientServerContext m_clientServerContext;
 
         const void * m_context[protocol::MaxContexts];
 
+        uint8_t m_challengeKey[16];                                 // secret key for challenge tokens. generated randomly per-server.
+
     public:
 
         Server( const ServerConfig & config );
@@ -123,6 +139,10 @@ namespace clientServer
 
         const protocol::Block * GetClientData( int clientIndex ) const;
 
+        float GetClientSendRate( int clientIndex ) const;
+
+        int GetClientPacketSize( int clientIndex ) const;
+
         void SetContext( int index, const void * ptr );
 
         int FindClientSlot( const network::Address & address, uint64_t clientId, uint64_t serverId ) const;
@@ -131,12 +151,12 @@ namespace clientServer
 
         const core::TimeBase & GetTimeBase() const { return m_timeBase; }
 
+        int GetNumPooledConnections() const { return (int) core::array::size( m_connectionPool ); }
+
     protected:
 
         void UpdateClients();
 
-        void UpdateSendingChallenge( int clientIndex );
-
         void UpdateSendingServerData( int clientIndex );
 
         void UpdateReadyForConnection( int clientIndex );
@@ -173,6 +193,16 @@ namespace clientServer
 
         void ResetClientSlot( int clientIndex );
 
+        protocol::Connection * AcquireConnection();
+
+        DataBlockReceiver * AcquireDataBlockReceiver();
+
+        void ReleaseConnection( protocol::Connection * connection );
+
+        void ReleaseDataBlockReceiver( DataBlockReceiver * dataBlockReceiver );
+
+        uint64_t GenerateChallengeToken( const network::Address & address, uint16_t clientId, uint16_t serverId, uint64_t challengeTime ) const;
+
         void SendPacket( const network::Address & address, protocol::Packet * packet );
 
         void SetClientState( int clientIndex, ServerClientState state );
@@ -2,6 +2,7 @@
 
 #include "core/Core.h"
 #include <time.h>
+#include <stdio.h>
 #if CORE_PLATFORM == CORE_PLATFORM_MAC || CORE_PLATFORM == CORE_PLATFORM_UNIX
 #include <unistd.h>
 #endif
@@ -152,6 +153,101 @@ namespace core
         return h;
     }
 
+    static uint64_t siphash_load64( const uint8_t * p )
+    {
+        return uint64_t( p[0] )       | ( uint64_t( p[1] ) << 8 )  |
+             ( uint64_t( p[2] ) << 16 ) | ( uint64_t( p[3] ) << 24 ) |
+             ( uint64_t( p[4] ) << 32 ) | ( uint64_t( p[5] ) << 40 ) |
+             ( uint64_t( p[6] ) << 48 ) | ( uint64_t( p[7] ) << 56 );
+    }
+
+    #define SIPHASH_ROTL( x, b ) ( ( (x) << (b) ) | ( (x) >> ( 64 - (b) ) ) )
+
+    #define SIPHASH_ROUND                                                                   \
+        do                                                                                  \
+        {                                                                                   \
+            v0 += v1; v1 = SIPHASH_ROTL( v1, 13 ); v1 ^= v0; v0 = SIPHASH_ROTL( v0, 32 );   \
+            v2 += v3; v3 = SIPHASH_ROTL( v3, 16 ); v3 ^= v2;                                \
+            v0 += v3; v3 = SIPHASH_ROTL( v3, 21 ); v3 ^= v0;                                \
+            v2 += v1; v1 = SIPHASH_ROTL( v1, 17 ); v1 ^= v2; v2 = SIPHASH_ROTL( v2, 32 );   \
+        } while ( 0 )
+
+    uint64_t siphash_24( const void * data, uint32_t len, const uint8_t key[16] )
+    {
+        const uint64_t k0 = siphash_load64( key );
+        const uint64_t k1 = siphash_load64( key + 8 );
+
+        uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+        uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+        uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+        uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+        const uint8_t * p = (const uint8_t*) data;
+        const uint8_t * end = p + ( len & ~7 );
+
+        for ( ; p != end; p += 8 )
+        {
+            const uint64_t m = siphash_load64( p );
+            v3 ^= m;
+            SIPHASH_ROUND;
+            SIPHASH_ROUND;
+            v0 ^= m;
+        }
+
+        uint64_t b = uint64_t( len ) << 56;
+
+        switch ( len & 7 )
+        {
+            case 7: b |= uint64_t( p[6] ) << 48;
+            case 6: b |= uint64_t( p[5] ) << 40;
+            case 5: b |= uint64_t( p[4] ) << 32;
+            case 4: b |= uint64_t( p[3] ) << 24;
+            case 3: b |= uint64_t( p[2] ) << 16;
+            case 2: b |= uint64_t( p[1] ) << 8;
+            case 1: b |= uint64_t( p[0] );
+        };
+
+        v3 ^= b;
+        SIPHASH_ROUND;
+        SIPHASH_ROUND;
+        v0 ^= b;
+
+        v2 ^= 0xff;
+        SIPHASH_ROUND;
+        SIPHASH_ROUND;
+        SIPHASH_ROUND;
+        SIPHASH_ROUND;
+
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+
+    #undef SIPHASH_ROUND
+    #undef SIPHASH_ROTL
+
+    void random_bytes( uint8_t * data, int bytes )
+    {
+        CORE_ASSERT( data );
+        CORE_ASSERT( bytes >= 0 );
+
+        #if CORE_PLATFORM == CORE_PLATFORM_MAC || CORE_PLATFORM == CORE_PLATFORM_UNIX
+
+            FILE * file = fopen( "/dev/urandom", "rb" );
+            if ( file )
+            {
+                const bool ok = fread( data, 1, bytes, file ) == size_t( bytes );
+                fclose( file );
+                if ( ok )
+                    return;
+            }
+
+        #endif
+
+        // IMPORTANT: fallback is not cryptographically secure
+
+        for ( int i = 0; i < bytes; ++i )
+            data[i] = uint8_t( rand() );
+    }
+
     uint64_t nanoseconds() 
     {
         static uint64_t is_init = 0;
@@ -170,7 +266,7 @@ namespace core
             now /= info.denom;
             return now;
 
-        #elif CORE_PLATFORM == CORE_PLATFORM_LINUX
+        #elif CORE_PLATFORM == CORE_PLATFORM_UNIX
 
             #ifdef CLOCK_MONOTONIC
             #define CLOCKID CLOCK_MONOTONIC
@@ -238,6 +238,12 @@ namespace core
     uint32_t hash_string( const char string[], uint32_t hash = 0 );
     uint64_t murmur_hash_64( const void * key, uint32_t len, uint64_t seed );
 
+    // keyed hash (SipHash-2-4). use as a MAC when the key is secret, eg. for stateless challenge tokens.
+
+    uint64_t siphash_24( const void * data, uint32_t len, const uint8_t key[16] );
+
+    void random_bytes( uint8_t * data, int bytes );
+
     struct TimeBase
     {
         double time = 0.0;                // frame time. 0.0 is start of process
@@ -363,6 +363,11 @@ namespace game
 		{
 			return localPlayerId;
 		}
+
+		uint64_t GetStateHash() const
+		{
+			return simulation->GetStateHash();
+		}
 	
 		void SetPlayerInput( int playerId, const Input & input )
 		{
@@ -765,14 +770,16 @@ namespace game
 		{
 			int numActiveObjects = activeObjects.GetCount();
 
+			simObjectStates.Resize( numActiveObjects );
+
 			for ( int i = 0; i < numActiveObjects; ++i )
 			{
 				ActiveObject * activeObject = &activeObjects.GetObject( i );
 				assert( activeObject );
-				SimulationObjectState objectState;
-				activeObject->ActiveToSimulation( objectState );
-				simulation->SetObjectState( activeObject->activeId, objectState, true );
+				activeObject->ActiveToSimulation( simObjectStates, i );
 			}
+
+			simulation->SetObjectStates( simObjectStates, true );
 			
 			simulation->Update( deltaTime, GetFlag( FLAG_Pause ) );
 
@@ -782,15 +789,14 @@ namespace game
             const vectorial::vec3f position_min( -PositionBoundXY, -PositionBoundXY, 0 );
             const vectorial::vec3f position_max( +PositionBoundXY, +PositionBoundXY, PositionBoundZ );
 
+			simulation->GetObjectStates( simObjectStates );
+
 			for ( int i = 0; i < numActiveObjects; ++i )
 			{
 				ActiveObject * activeObject = &activeObjects.GetObject( i );
 				assert( activeObject );
 				
-				SimulationObjectState simObjectState;
-				simulation->GetObjectState( activeObject->activeId, simObjectState );
-				
-				activeObject->SimulationToActive( simObjectState );
+				activeObject->SimulationToActive( simObjectStates, i );
 
 				vectorial::vec3f position( activeObject->position.x, activeObject->position.y, activeObject->position.z );
 
@@ -907,8 +913,8 @@ namespace game
 					
 					while ( head != tail )
 					{
-						const std::vector<uint16_t> & objectInteractions = simulation->GetObjectInteractions( queue[tail] );
-						for ( int i = 0; i < (int) objectInteractions.size(); ++i )
+						const SimulationInteractions objectInteractions = simulation->GetObjectInteractions( queue[tail] );
+						for ( int i = 0; i < objectInteractions.size(); ++i )
 						{
 							const int activeId = objectInteractions[i];
 							assert( activeId >= 0 );
@@ -971,6 +977,8 @@ namespace game
 
         activation::Set<ActiveObject> activeObjects;
 
+		SimulationObjectStates simObjectStates;
+
         view::Packet viewPacket;
 	};
 }
@@ -62,6 +62,25 @@ namespace hypercube
 			enabled = simulationObject.enabled;
 		}
 		
+		void ActiveToSimulation( SimulationObjectStates & simulationObjects, int index )
+		{
+			simulationObjects.id[index] = activeId;
+			simulationObjects.position[index] = position;
+			simulationObjects.orientation[index] = orientation;
+			simulationObjects.linearVelocity[index] = linearVelocity;
+			simulationObjects.angularVelocity[index] = angularVelocity;
+			simulationObjects.enabled[index] = enabled;
+		}
+
+		void SimulationToActive( const SimulationObjectStates & simulationObjects, int index )
+		{
+			position = simulationObjects.position[index];
+			orientation = simulationObjects.orientation[index];
+			linearVelocity = simulationObjects.linearVelocity[index];
+			angularVelocity = simulationObjects.angularVelocity[index];
+			enabled = simulationObjects.enabled[index];
+		}
+		
 		void ActiveToView( view::ObjectState & viewObjectState, int authority, bool pendingDeactivation )
 		{
 			viewObjectState.id = id;
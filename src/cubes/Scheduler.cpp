@@ -0,0 +1,190 @@
+/*
+	Networked Physics Demo
+	Copyright © 2008-2015 Glenn Fiedler
+	http://www.gafferongames.com/networking-for-game-programmers
+*/
+
+#include "Scheduler.h"
+#include "Simulation.h"
+#define dSINGLE
+#include <ode/ode.h>
+#include <assert.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace cubes
+{
+	struct SchedulerImpl
+	{
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable start;
+		std::condition_variable finish;
+
+		// current batch. workers wake when the generation changes and pull job indices until none are left
+
+		SchedulerJob job;
+		void * data;
+		int numJobs;
+		uint64_t generation;
+		bool quit;
+
+		std::atomic<int> nextJob;
+		int jobsDone;
+		int activeWorkers;
+
+		SchedulerImpl()
+		{
+			job = NULL;
+			data = NULL;
+			numJobs = 0;
+			generation = 0;
+			quit = false;
+			nextJob = 0;
+			jobsDone = 0;
+			activeWorkers = 0;
+		}
+
+		void RunJobs( SchedulerJob job, void * data, int numJobs )
+		{
+			int completed = 0;
+
+			while ( true )
+			{
+				const int index = nextJob.fetch_add( 1 );
+				if ( index >= numJobs )
+					break;
+				job( data, index );
+				completed++;
+			}
+
+			if ( completed )
+			{
+				std::lock_guard<std::mutex> lock( mutex );
+				jobsDone += completed;
+				if ( jobsDone == numJobs )
+					finish.notify_one();
+			}
+		}
+
+		void WorkerThread()
+		{
+			dAllocateODEDataForThread( dAllocateMaskAll );
+
+			uint64_t lastGeneration = 0;
+
+			while ( true )
+			{
+				// copy the batch under the lock. the next batch may overwrite it once this one finishes
+
+				SchedulerJob batchJob;
+				void * batchData;
+				int batchJobs;
+
+				{
+					std::unique_lock<std::mutex> lock( mutex );
+					start.wait( lock, [this, lastGeneration] { return quit || generation != lastGeneration; } );
+					if ( quit )
+						break;
+					lastGeneration = generation;
+					batchJob = job;
+					batchData = data;
+					batchJobs = numJobs;
+					activeWorkers++;
+				}
+
+				RunJobs( batchJob, batchData, batchJobs );
+
+				{
+					std::lock_guard<std::mutex> lock( mutex );
+					activeWorkers--;
+					if ( activeWorkers == 0 )
+						finish.notify_one();
+				}
+			}
+
+			// note: ode is initialized without dInitFlagManualThreadCleanup, so thread data is freed on thread exit
+		}
+	};
+
+	Scheduler::Scheduler( int numThreads )
+	{
+		assert( numThreads >= 1 );
+
+		// note: ode must be initialized before worker threads allocate their thread data
+
+		Simulation::AddODEReference();
+
+		impl = new SchedulerImpl();
+
+		// the calling thread runs jobs too, so spawn one less worker
+
+		for ( int i = 0; i < numThreads - 1; ++i )
+			impl->threads.push_back( std::thread( [this] { impl->WorkerThread(); } ) );
+	}
+
+	Scheduler::~Scheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock( impl->mutex );
+			impl->quit = true;
+		}
+
+		impl->start.notify_all();
+
+		for ( int i = 0; i < (int) impl->threads.size(); ++i )
+			impl->threads[i].join();
+
+		delete impl;
+		impl = NULL;
+
+		Simulation::RemoveODEReference();
+	}
+
+	void Scheduler::Run( SchedulerJob job, void * data, int numJobs )
+	{
+		assert( job );
+		assert( numJobs >= 0 );
+
+		if ( numJobs == 0 )
+			return;
+
+		// with no workers, or only one job, there is nothing to hand off
+
+		if ( impl->threads.empty() || numJobs == 1 )
+		{
+			for ( int i = 0; i < numJobs; ++i )
+				job( data, i );
+			return;
+		}
+
+		{
+			// a worker that woke late for the previous batch may still be pulling from the job counter. wait for it to leave before resetting
+
+			std::unique_lock<std::mutex> lock( impl->mutex );
+			impl->finish.wait( lock, [this] { return impl->activeWorkers == 0; } );
+			impl->job = job;
+			impl->data = data;
+			impl->numJobs = numJobs;
+			impl->nextJob = 0;
+			impl->jobsDone = 0;
+			impl->generation++;
+		}
+
+		impl->start.notify_all();
+
+		impl->RunJobs( job, data, numJobs );
+
+		std::unique_lock<std::mutex> lock( impl->mutex );
+		impl->finish.wait( lock, [this, numJobs] { return impl->jobsDone == numJobs; } );
+	}
+
+	int Scheduler::GetNumThreads() const
+	{
+		return (int) impl->threads.size() + 1;
+	}
+}
@@ -0,0 +1,51 @@
+/*
+	Networked Physics Demo
+	Copyright © 2008-2015 Glenn Fiedler
+	http://www.gafferongames.com/networking-for-game-programmers
+*/
+
+#ifndef CUBES_SCHEDULER_H
+#define CUBES_SCHEDULER_H
+
+#include "Config.h"
+
+namespace cubes
+{
+	/*
+		Steps independent simulations in parallel, eg. left and right simulations
+		in a demo, rollback copies or one game instance per room on a server.
+
+		Run calls the job function once per index, spread over a pool of worker
+		threads plus the calling thread, and returns when every job is done.
+		Jobs must not share state with each other.
+
+		Worker threads allocate their own ODE thread data and hold a reference
+		on ODE, so jobs may create, step and destroy simulations. ODE is built
+		with --enable-ou so its collision caches are thread local, and its random
+		seed is per thread, so seeding inside a job keeps each simulation
+		deterministic regardless of which thread runs it.
+	*/
+
+	typedef void (*SchedulerJob)( void * data, int index );
+
+	class Scheduler
+	{
+	public:
+
+		Scheduler( int numThreads );
+		~Scheduler();
+
+		void Run( SchedulerJob job, void * data, int numJobs );
+
+		int GetNumThreads() const;
+
+	private:
+
+		Scheduler( const Scheduler & other );
+		Scheduler & operator = ( const Scheduler & other );
+
+		struct SchedulerImpl * impl;
+	};
+}
+
+#endif
@@ -5,14 +5,20 @@
 */
 
 #include "Simulation.h"
+#include "core/Core.h"
 #define dSINGLE
 #include <ode/ode.h>
+#include <algorithm>
+#include <mutex>
 
 namespace cubes
 {	
 	// simulation internal implementation
 	
 	const int MaxContacts = 16;
+	const int ContactLambdaRows = 3;				// normal + two friction directions
+	const uint32_t StaticContactId = 0xFFFF;
+	const uint32_t StaticGeomId = 0x10000;			// planes sort after every object in deterministic mode
 
 	struct SimulationImpl
 	{
@@ -20,26 +26,50 @@ namespace cubes
 		{
 			world = 0;
 			space = 0;
+			sleepSpace = 0;
 			contacts = 0;
+			threading = 0;
+			threadPool = 0;
+			collideTime = 0.0;
+			stepTime = 0.0;
 		}
 		
 		~SimulationImpl()
 		{
+			// IMPORTANT: stop the pool serving the threading implementation before anything it steps goes away
+			if ( threading )
+				dThreadingImplementationShutdownProcessing( threading );
+			if ( threadPool )
+				dThreadingFreeThreadPool( threadPool );
+			if ( world )
+				dWorldSetStepThreadingImplementation( world, NULL, NULL );
+			if ( threading )
+				dThreadingFreeImplementation( threading );
+			for ( int i = 0; i < (int) bodyPool.size(); ++i )
+				dGeomDestroy( bodyPool[i].geom );
 			if ( contacts )
 				dJointGroupDestroy( contacts );
 			if ( world )
 				dWorldDestroy( world );
 			if ( space )
 				dSpaceDestroy( space );
+			if ( sleepSpace )
+				dSpaceDestroy( sleepSpace );
 				
 			contacts = 0;
 			world = 0;
 			space = 0;
+			sleepSpace = 0;
+			threading = 0;
+			threadPool = 0;
 		}
 		
 		dWorldID world;
 		dSpaceID space;
+		dSpaceID sleepSpace;
 		dJointGroupID contacts;
+		dThreadingImplementationID threading;
+		dThreadingThreadPoolID threadPool;
 
 		struct ObjectData
 		{
@@ -47,6 +77,9 @@ namespace cubes
 			dGeomID geom;
 			float scale;
 			float timeAtRest;
+			bool sleeping;
+			int sleepHead;
+			int sleepNext;
 
 			ObjectData()
 			{
@@ -54,6 +87,9 @@ namespace cubes
 				geom = 0;
 				scale = 1.0f;
 				timeAtRest = 0.0f;
+				sleeping = false;
+				sleepHead = -1;
+				sleepNext = -1;
 			}
 
 			bool exists() const
@@ -62,13 +98,44 @@ namespace cubes
 			}
 		};
 
+		struct PooledBody
+		{
+			dBodyID body;
+			dGeomID geom;
+		};
+
 		SimulationConfig config;
 		std::vector<dGeomID> planes;
 		std::vector<ObjectData> objects;
-		std::vector< std::vector<uint16_t> > interactions;
+		std::vector<int> freeObjects;
+		std::vector<PooledBody> bodyPool;
+
+		// interaction pairs are appended during collision, then bucketed per object (CSR) so
+		// each object's interactions are one contiguous run. all buffers are reused frame to frame
+
+		struct InteractionPair
+		{
+			uint16_t a;
+			uint16_t b;
+		};
+
+		std::vector<InteractionPair> interactionPairs;
+		std::vector<int> interactionStart;
+		std::vector<uint16_t> interactions;
 
 	    dContact contact[MaxContacts];			
 
+		// island sleeping. awake geoms live in the main space and sleeping geoms in the sleep space,
+		// so resting islands cost nothing in collision. each sleeping island is a linked list
+		// through its objects so touching any one of them wakes the lot
+
+		std::vector<int> islandParent;
+		std::vector<uint8_t> islandAtRest;
+		std::vector<int> wakeObjects;
+
+		double collideTime;
+		double stepTime;
+
 		void UpdateInteractionPairs( dBodyID b1, dBodyID b2 )
 		{
 			if ( !b1 || !b2 )
@@ -77,46 +144,409 @@ namespace cubes
 			uint64_t objectId1 = reinterpret_cast<uint64_t>( dBodyGetData( b1 ) );
 			uint64_t objectId2 = reinterpret_cast<uint64_t>( dBodyGetData( b2 ) );
 
-			interactions[objectId1].push_back( objectId2 );
-			interactions[objectId2].push_back( objectId1 );
+			InteractionPair pair;
+			pair.a = objectId1;
+			pair.b = objectId2;
+			interactionPairs.push_back( pair );
 		}
 
-		static void NearCallback( void * data, dGeomID o1, dGeomID o2 )
+		void BuildInteractions()
+		{
+			// count interactions per object, prefix sum into start offsets, then scatter.
+			// pairs are scattered in collision order, so each object sees its interactions in the same order as before
+
+			const int numObjects = (int) objects.size();
+			const int numPairs = (int) interactionPairs.size();
+
+			interactionStart.assign( numObjects + 1, 0 );
+			interactions.resize( numPairs * 2 );
+
+			for ( int i = 0; i < numPairs; ++i )
+			{
+				interactionStart[interactionPairs[i].a + 1]++;
+				interactionStart[interactionPairs[i].b + 1]++;
+			}
+
+			for ( int i = 0; i < numObjects; ++i )
+				interactionStart[i+1] += interactionStart[i];
+
+			int * cursor = &interactionStart[0];
+
+			for ( int i = 0; i < numPairs; ++i )
+			{
+				const InteractionPair & pair = interactionPairs[i];
+				interactions[cursor[pair.a]++] = pair.b;
+				interactions[cursor[pair.b]++] = pair.a;
+			}
+
+			// the scatter advanced each start to the next object's start. shift back down by one object
+
+			for ( int i = numObjects; i > 0; --i )
+				interactionStart[i] = interactionStart[i-1];
+			interactionStart[0] = 0;
+		}
+
+		// contact cache for warm starting. contact joints are recreated every frame, so the impulses
+		// quickstep solved for are read back after the step and matched to next frame's contacts by
+		// body pair and position. last frame's contacts are kept sorted by key for binary search
+
+		struct CachedContact
+		{
+			uint32_t key;
+			float position[3];
+			dReal lambda[ContactLambdaRows];
+
+			bool operator < ( const CachedContact & other ) const
+			{
+				return key < other.key;
+			}
+		};
+
+		std::vector<CachedContact> contactCache;
+		std::vector<CachedContact> frameContacts;
+		std::vector<dJointID> frameContactJoints;
+
+		// deterministic mode. the order pairs come out of dSpaceCollide depends on the broadphase and on
+		// the history of adds and removes, not just the current state. so contacts are buffered per pair,
+		// sorted by the ids of the two geoms, then turned into joints (and interactions) in that order.
+		// note: this does not make the step independent of history. quickstep randomly reorders constraints
+		// per island, and islands are found walking ode's body list, whose order depends on which bodies
+		// were created and reused from the pool. two simulations stay in sync only if they also add and
+		// remove the same objects in the same order, like lockstep peers do
+
+		struct PendingPair
+		{
+			uint64_t key;
+			dBodyID b1;
+			dBodyID b2;
+			int firstContact;
+			int numContacts;
+
+			bool operator < ( const PendingPair & other ) const
+			{
+				return key < other.key;
+			}
+		};
+
+		std::vector<PendingPair> pendingPairs;
+		std::vector<dContactGeom> pendingContacts;
+
+		static uint32_t GetContactKey( dBodyID b1, dBodyID b2 )
+		{
+			// note: static geometry (eg. planes) has no body and keys as StaticContactId
+
+			const uint32_t id1 = b1 ? (uint32_t) reinterpret_cast<uint64_t>( dBodyGetData( b1 ) ) : StaticContactId;
+			const uint32_t id2 = b2 ? (uint32_t) reinterpret_cast<uint64_t>( dBodyGetData( b2 ) ) : StaticContactId;
+
+			return ( id1 << 16 ) | id2;
+		}
+
+		const CachedContact * FindCachedContact( uint32_t key, const dReal * position ) const
+		{
+			CachedContact search;
+			search.key = key;
+
+			std::vector<CachedContact>::const_iterator itor = std::lower_bound( contactCache.begin(), contactCache.end(), search );
+
+			const CachedContact * nearest = NULL;
+			float nearestDistanceSquared = config.WarmStartDistance * config.WarmStartDistance;
+
+			for ( ; itor != contactCache.end() && itor->key == key; ++itor )
+			{
+				const float dx = itor->position[0] - position[0];
+				const float dy = itor->position[1] - position[1];
+				const float dz = itor->position[2] - position[2];
+				const float distanceSquared = dx*dx + dy*dy + dz*dz;
+				if ( distanceSquared < nearestDistanceSquared )
+				{
+					nearest = &(*itor);
+					nearestDistanceSquared = distanceSquared;
+				}
+			}
+
+			return nearest;
+		}
+
+		void UpdateContactCache()
+		{
+			const int numContacts = (int) frameContacts.size();
+
+			for ( int i = 0; i < numContacts; ++i )
+			{
+				dReal lambda[6];
+				dJointGetLambda( frameContactJoints[i], lambda );
+				for ( int j = 0; j < ContactLambdaRows; ++j )
+					frameContacts[i].lambda[j] = lambda[j];
+			}
+
+			std::sort( frameContacts.begin(), frameContacts.end() );
+
+			contactCache.swap( frameContacts );
+
+			frameContacts.clear();
+			frameContactJoints.clear();
+		}
+
+		void WakeObject( int id )
+		{
+			ObjectData & object = objects[id];
+			assert( object.sleeping );
+			object.sleeping = false;
+			object.sleepHead = -1;
+			object.sleepNext = -1;
+			object.timeAtRest = 0.0f;
+			dSpaceRemove( sleepSpace, object.geom );
+			dSpaceAdd( space, object.geom );
+			dBodyEnable( object.body );
+		}
+
+		void SleepObject( int id, int head )
+		{
+			ObjectData & object = objects[id];
+			assert( !object.sleeping );
+			object.sleeping = true;
+			object.sleepHead = head;
+			dSpaceRemove( space, object.geom );
+			dSpaceAdd( sleepSpace, object.geom );
+			dBodyDisable( object.body );
+		}
+
+		// the same test as time at rest in the pre-step. a sleeping object given a velocity above it wakes
+		// its island, like it would have on the next update before objects slept out of the collision space
+
+		bool IsMoving( const math::Vector & linearVelocity, const math::Vector & angularVelocity ) const
+		{
+			return !( linearVelocity.lengthSquared() < config.LinearRestThresholdSquared && angularVelocity.lengthSquared() < config.AngularRestThresholdSquared );
+		}
+
+		void WakeIsland( int id )
+		{
+			// note: awake objects are enabled too, since a body reused from the pool comes back disabled
+
+			if ( !objects[id].sleeping )
+			{
+				dBodyEnable( objects[id].body );
+				return;
+			}
+
+			int member = objects[id].sleepHead;
+			while ( member != -1 )
+			{
+				const int next = objects[member].sleepNext;
+				WakeObject( member );
+				member = next;
+			}
+		}
+
+		int FindIsland( int id )
+		{
+			while ( islandParent[id] != id )
+			{
+				islandParent[id] = islandParent[islandParent[id]];
+				id = islandParent[id];
+			}
+			return id;
+		}
+
+		void SleepIslands()
+		{
+			// union the objects that touched this frame into islands. an island goes to sleep
+			// only once every object in it has been at rest for long enough
+
+			const int numObjects = (int) objects.size();
+			const int numPairs = (int) interactionPairs.size();
+
+			islandParent.resize( numObjects );
+			islandAtRest.resize( numObjects );
+
+			for ( int i = 0; i < numObjects; ++i )
+			{
+				islandParent[i] = i;
+				islandAtRest[i] = 1;
+			}
+
+			for ( int i = 0; i < numPairs; ++i )
+			{
+				const int a = FindIsland( interactionPairs[i].a );
+				const int b = FindIsland( interactionPairs[i].b );
+				if ( a != b )
+					islandParent[a] = b;
+			}
+
+			for ( int i = 0; i < numObjects; ++i )
+			{
+				if ( objects[i].exists() && !objects[i].sleeping && objects[i].timeAtRest < config.RestTime )
+					islandAtRest[FindIsland( i )] = 0;
+			}
+
+			// the island root heads the list, other members are linked in after it
+
+			for ( int i = 0; i < numObjects; ++i )
+			{
+				if ( !objects[i].exists() || objects[i].sleeping )
+					continue;
+
+				const int root = FindIsland( i );
+				if ( !islandAtRest[root] )
+					continue;
+
+				if ( i != root )
+				{
+					objects[i].sleepNext = objects[root].sleepNext;
+					objects[root].sleepNext = i;
+				}
+
+				SleepObject( i, root );
+			}
+		}
+
+		static void WakeCallback( void * data, dGeomID o1, dGeomID o2 )
 		{
+			// an awake geom overlaps a sleeping geom. wake the sleeping island if they actually touch
+
 			SimulationImpl * simulation = (SimulationImpl*) data;
 
 			assert( simulation );
 
-		    dBodyID b1 = dGeomGetBody( o1 );
-		    dBodyID b2 = dGeomGetBody( o2 );
+			dContactGeom contact;
+			if ( !dCollide( o1, o2, 1, &contact, sizeof(dContactGeom) ) )
+				return;
 
-			if ( int numc = dCollide( o1, o2, MaxContacts, &simulation->contact[0].geom, sizeof(dContact) ) )
+			const int id1 = (int) reinterpret_cast<uint64_t>( dBodyGetData( dGeomGetBody( o1 ) ) );
+			const int id2 = (int) reinterpret_cast<uint64_t>( dBodyGetData( dGeomGetBody( o2 ) ) );
+
+			simulation->wakeObjects.push_back( simulation->objects[id1].sleeping ? id1 : id2 );
+		}
+
+		static uint32_t GetGeomId( dGeomID geom )
+		{
+			// note: objects are keyed by object id, planes by their index (see AddPlane)
+
+			dBodyID body = dGeomGetBody( geom );
+			if ( body )
+				return (uint32_t) reinterpret_cast<uint64_t>( dBodyGetData( body ) );
+			else
+				return StaticGeomId + (uint32_t) reinterpret_cast<uint64_t>( dGeomGetData( geom ) );
+		}
+
+		void CreateContacts( dBodyID b1, dBodyID b2, int numc )
+		{
+			const bool warmStarting = config.WarmStarting;
+			const uint32_t key = warmStarting ? GetContactKey( b1, b2 ) : 0;
+
+	        for ( int i = 0; i < numc; i++ )
+	        {
+	            dJointID c = dJointCreateContact( world, contacts, contact+i );
+	            dJointAttach( c, b1, b2 );
+
+				if ( warmStarting )
+				{
+					const dReal * position = contact[i].geom.pos;
+
+					const CachedContact * cached = FindCachedContact( key, position );
+					if ( cached )
+						dJointSetLambda( c, cached->lambda, ContactLambdaRows );
+
+					CachedContact contact;
+					contact.key = key;
+					contact.position[0] = position[0];
+					contact.position[1] = position[1];
+					contact.position[2] = position[2];
+					frameContacts.push_back( contact );
+					frameContactJoints.push_back( c );
+				}
+	        }
+
+			UpdateInteractionPairs( b1, b2 );
+		}
+
+		void AddPendingContacts( dGeomID o1, dGeomID o2 )
+		{
+			// collide in canonical order too, since box-box contact generation depends on which geom is first
+
+			uint32_t id1 = GetGeomId( o1 );
+			uint32_t id2 = GetGeomId( o2 );
+
+			if ( id1 > id2 )
 			{
-		        for ( int i = 0; i < numc; i++ )
-		        {
-		            dJointID c = dJointCreateContact( simulation->world, simulation->contacts, simulation->contact+i );
-		            dJointAttach( c, b1, b2 );
-		        }
-		
-				simulation->UpdateInteractionPairs( b1, b2 );
+				std::swap( o1, o2 );
+				std::swap( id1, id2 );
 			}
+
+			const int numc = dCollide( o1, o2, MaxContacts, &contact[0].geom, sizeof(dContact) );
+			if ( !numc )
+				return;
+
+			PendingPair pair;
+			pair.key = ( uint64_t( id1 ) << 32 ) | id2;
+			pair.b1 = dGeomGetBody( o1 );
+			pair.b2 = dGeomGetBody( o2 );
+			pair.firstContact = (int) pendingContacts.size();
+			pair.numContacts = numc;
+			pendingPairs.push_back( pair );
+
+			for ( int i = 0; i < numc; ++i )
+				pendingContacts.push_back( contact[i].geom );
+		}
+
+		void CreatePendingContacts()
+		{
+			std::sort( pendingPairs.begin(), pendingPairs.end() );
+
+			for ( int i = 0; i < (int) pendingPairs.size(); ++i )
+			{
+				const PendingPair & pair = pendingPairs[i];
+				for ( int j = 0; j < pair.numContacts; ++j )
+					contact[j].geom = pendingContacts[pair.firstContact + j];
+				CreateContacts( pair.b1, pair.b2, pair.numContacts );
+			}
+
+			pendingPairs.clear();
+			pendingContacts.clear();
+		}
+
+		static void NearCallback( void * data, dGeomID o1, dGeomID o2 )
+		{
+			SimulationImpl * simulation = (SimulationImpl*) data;
+
+			assert( simulation );
+
+			if ( simulation->config.Deterministic )
+			{
+				simulation->AddPendingContacts( o1, o2 );
+				return;
+			}
+
+			if ( int numc = dCollide( o1, o2, MaxContacts, &simulation->contact[0].geom, sizeof(dContact) ) )
+				simulation->CreateContacts( dGeomGetBody( o1 ), dGeomGetBody( o2 ), numc );
 		}
 	};
 
 	// ------------------------------------------
 	
-	int * Simulation::GetInitCount()
+	static std::mutex odeMutex;
+	static int odeReferences = 0;
+
+	void Simulation::AddODEReference()
+	{
+		std::lock_guard<std::mutex> lock( odeMutex );
+		if ( odeReferences == 0 )
+			dInitODE();
+		odeReferences++;
+	}
+
+	void Simulation::RemoveODEReference()
 	{
-		static int initCount = 0;
-		return &initCount;
+		std::lock_guard<std::mutex> lock( odeMutex );
+		assert( odeReferences > 0 );
+		odeReferences--;
+		if ( odeReferences == 0 )
+			dCloseODE();
 	}
 
 	Simulation::Simulation()
 	{
-		int * initCount = GetInitCount();
-		if ( *initCount == 0 )
-			dInitODE();
-		(*initCount)++;
+		AddODEReference();
 		impl = new SimulationImpl();
 	}
 	
@@ -124,10 +554,7 @@ namespace cubes
 	{
 		delete impl;
 		impl = NULL;
-		int * initCount = GetInitCount();
-		(*initCount)--;
-		if ( *initCount == 0 )
-			dCloseODE();
+		RemoveODEReference();
 	}
 
 	void Simulation::Initialize( const SimulationConfig & config )
@@ -138,21 +565,84 @@ namespace cubes
 
 		impl->world = dWorldCreate();
 	    impl->contacts = dJointGroupCreate( 0 );
-	    dVector3 center = { 0,0,0 };
-	    dVector3 extents = { 100,100,100 };
-	    impl->space = dQuadTreeSpaceCreate( 0, center, extents, 10 );
+
+		switch ( config.Broadphase )
+		{
+			case BROADPHASE_Hash:
+			{
+				impl->space = dHashSpaceCreate( 0 );
+				dHashSpaceSetLevels( impl->space, config.HashMinLevel, config.HashMaxLevel );
+			}
+			break;
+
+			case BROADPHASE_SweepAndPrune:
+			{
+				static const int axes[] = { dSAP_AXES_XYZ, dSAP_AXES_XZY, dSAP_AXES_YXZ, dSAP_AXES_YZX, dSAP_AXES_ZXY, dSAP_AXES_ZYX };
+				assert( config.SweepAxes >= 0 && config.SweepAxes < (int) ( sizeof( axes ) / sizeof( axes[0] ) ) );
+				impl->space = dSweepAndPruneSpaceCreate( 0, axes[config.SweepAxes] );
+			}
+			break;
+
+			case BROADPHASE_Simple:
+			{
+				impl->space = dSimpleSpaceCreate( 0 );
+			}
+			break;
+
+			default:
+			{
+				dVector3 center = { config.QuadTreeCenter.x, config.QuadTreeCenter.y, config.QuadTreeCenter.z };
+				dVector3 extents = { config.QuadTreeExtents.x, config.QuadTreeExtents.y, config.QuadTreeExtents.z };
+				impl->space = dQuadTreeSpaceCreate( 0, center, extents, config.QuadTreeDepth );
+			}
+			break;
+		}
+
+		// sleeping geoms are only ever queried against, so they go in a quad tree which accelerates that
+
+		{
+			dVector3 center = { config.QuadTreeCenter.x, config.QuadTreeCenter.y, config.QuadTreeCenter.z };
+			dVector3 extents = { config.QuadTreeExtents.x, config.QuadTreeExtents.y, config.QuadTreeExtents.z };
+			impl->sleepSpace = dQuadTreeSpaceCreate( 0, center, extents, config.QuadTreeDepth );
+		}
 
 		// configure world
 
 		dWorldSetERP( impl->world, config.ERP );
 		dWorldSetCFM( impl->world, config.CFM );
 		dWorldSetQuickStepNumIterations( impl->world, config.MaxIterations );
+		dWorldSetQuickStepWarmStarting( impl->world, config.WarmStarting ? config.WarmStartFactor : 0.0f );
 		dWorldSetGravity( impl->world, 0, 0, -config.Gravity );
 		dWorldSetContactSurfaceLayer( impl->world, config.ContactSurfaceLayer );
 		dWorldSetContactMaxCorrectingVel( impl->world, config.MaximumCorrectingVelocity );
 		dWorldSetLinearDamping( impl->world, 0.01f );
 		dWorldSetAngularDamping( impl->world, 0.01f );
 
+		// optionally step islands in parallel on a pool of worker threads.
+		// falls back to single threaded if ode was built without the builtin threading implementation.
+		// not in deterministic mode: quickstep draws from the per thread random seed to reorder
+		// constraints, so which thread steps an island would change the result
+
+		if ( config.NumThreads > 1 && !config.Deterministic )
+		{
+			impl->threading = dThreadingAllocateMultiThreadedImplementation();
+			if ( impl->threading )
+			{
+				impl->threadPool = dThreadingAllocateThreadPool( config.NumThreads, 0, dAllocateFlagBasicData, NULL );
+				if ( impl->threadPool )
+				{
+					dThreadingThreadPoolServeMultiThreadedImplementation( impl->threadPool, impl->threading );
+					dWorldSetStepThreadingImplementation( impl->world, dThreadingImplementationGetFunctions( impl->threading ), impl->threading );
+					dWorldSetStepIslandsProcessingMaxThreadCount( impl->world, config.NumThreads );
+				}
+				else
+				{
+					dThreadingFreeImplementation( impl->threading );
+					impl->threading = 0;
+				}
+			}
+		}
+
 		// setup contacts
 
 	    for ( int i = 0; i < MaxContacts; i++ ) 
@@ -163,23 +653,35 @@ namespace cubes
 			impl->contact[i].surface.bounce_vel = 0.001f;
 	    }
 	
-		impl->objects.resize( 1024 );
+		const int initialObjects = 1024;
+
+		impl->objects.resize( initialObjects );
+
+		// note: pushed in reverse so the lowest ids are handed out first, keeping active ids compact
+
+		impl->freeObjects.reserve( initialObjects );
+		for ( int i = initialObjects - 1; i >= 0; --i )
+			impl->freeObjects.push_back( i );
 	}
 
 	void Simulation::Update( float deltaTime, bool paused )
 	{		
-		impl->interactions.clear();
-		
-		impl->interactions.resize( impl->objects.size() );
+		impl->interactionPairs.clear();
 
 		if ( paused )
+		{
+			impl->BuildInteractions();
+			impl->collideTime = 0.0;
+			impl->stepTime = 0.0;
 			return;
+		}
 
 		// IMPORTANT: do this *first* before updating simulation then at rest calculations
 		// will work properly with rough quantization (quantized state is fed in prior to update)
+
 		for ( int i = 0; i < (int) impl->objects.size(); ++i )
 		{
-			if ( impl->objects[i].exists() )
+			if ( impl->objects[i].exists() && !impl->objects[i].sleeping )
 			{
 				const dReal * linearVelocity = dBodyGetLinearVel( impl->objects[i].body );
 				const dReal * angularVelocity = dBodyGetAngularVel( impl->objects[i].body );
@@ -225,61 +727,112 @@ namespace cubes
 					impl->objects[i].timeAtRest += deltaTime;
 				else
 					impl->objects[i].timeAtRest = 0.0f;
-
-				if ( impl->objects[i].timeAtRest >= impl->config.RestTime )
-					dBodyDisable( impl->objects[i].body );
-				else
-					dBodyEnable( impl->objects[i].body );
 			}
 		}
 
 		dJointGroupEmpty( impl->contacts );
 
+		const double collideStart = core::time();
+
+		// wake sleeping islands touched by awake objects before colliding, so woken islands get their
+		// contacts this frame. each awake geom queries the sleep space, so this scales with awake objects
+
+		if ( dSpaceGetNumGeoms( impl->sleepSpace ) > 0 )
+		{
+			impl->wakeObjects.clear();
+
+			for ( int i = 0; i < (int) impl->objects.size(); ++i )
+			{
+				if ( impl->objects[i].exists() && !impl->objects[i].sleeping )
+					dSpaceCollide2( impl->objects[i].geom, (dGeomID) impl->sleepSpace, impl, SimulationImpl::WakeCallback );
+			}
+
+			for ( int i = 0; i < (int) impl->wakeObjects.size(); ++i )
+				impl->WakeIsland( impl->wakeObjects[i] );
+		}
+
 		dSpaceCollide( impl->space, impl, SimulationImpl::NearCallback );
 
+		if ( impl->config.Deterministic )
+			impl->CreatePendingContacts();
+
+		impl->BuildInteractions();
+
+		impl->SleepIslands();
+
+		const double stepStart = core::time();
+
 		if ( impl->config.QuickStep )
 			dWorldQuickStep( impl->world, deltaTime );
 		else
 			dWorldStep( impl->world, deltaTime );
+
+		if ( impl->config.WarmStarting )
+			impl->UpdateContactCache();
+
+		impl->collideTime = stepStart - collideStart;
+		impl->stepTime = core::time() - stepStart;
 	}
 	
 	int Simulation::AddObject( const SimulationObjectState & initialObjectState )
 	{
-		// find free object slot
+		// pop a free object slot, growing the object array if there are none left
 
-		uint64_t id = -1;
-		for ( int i = 0; i < (int) impl->objects.size(); ++i )
-		{
-			if ( !impl->objects[i].exists() )
-			{
-				id = i;
-				break;
-			}
-		}
-		if ( id == -1 )
+		uint64_t id;
+		if ( impl->freeObjects.empty() )
 		{
 			id = impl->objects.size();
 			impl->objects.resize( id + 1 );
 		}
+		else
+		{
+			id = impl->freeObjects.back();
+			impl->freeObjects.pop_back();
+		}
 
-		// setup object body
+		SimulationImpl::ObjectData & object = impl->objects[id];
+
+		assert( !object.exists() );
+
+		// reuse a body and geom from the pool if possible. otherwise create them
+
+		if ( !impl->bodyPool.empty() )
+		{
+			object.body = impl->bodyPool.back().body;
+			object.geom = impl->bodyPool.back().geom;
+			impl->bodyPool.pop_back();
+
+			dGeomBoxSetLengths( object.geom, initialObjectState.scale, initialObjectState.scale, initialObjectState.scale );
+			dGeomEnable( object.geom );
+			dSpaceAdd( impl->space, object.geom );
+
+			// pooled bodies are disabled. if the new object starts disabled, SetObjectState below puts it to sleep again
+
+			dBodyEnable( object.body );
+		}
+		else
+		{
+			object.body = dBodyCreate( impl->world );
+			object.geom = dCreateBox( impl->space, initialObjectState.scale, initialObjectState.scale, initialObjectState.scale );
+			dGeomSetBody( object.geom, object.body );
+		}
 
-		impl->objects[id].body = dBodyCreate( impl->world );
+		assert( object.body );
+		assert( object.geom );
 
-		assert( impl->objects[id].body );
+		// setup object body
 
 		dMass mass;
 		const float density = 1.0f;
 		dMassSetBox( &mass, density, initialObjectState.scale, initialObjectState.scale, initialObjectState.scale );
-		dBodySetMass( impl->objects[id].body, &mass );
-		dBodySetData( impl->objects[id].body, (void*) id );
-
-		// setup geom and attach to body
+		dBodySetMass( object.body, &mass );
+		dBodySetData( object.body, (void*) id );
 
-		impl->objects[id].scale = initialObjectState.scale;
-		impl->objects[id].geom = dCreateBox( impl->space, initialObjectState.scale, initialObjectState.scale, initialObjectState.scale );
-
-		dGeomSetBody( impl->objects[id].geom, impl->objects[id].body );	
+		object.scale = initialObjectState.scale;
+		object.timeAtRest = 0.0f;
+		object.sleeping = false;
+		object.sleepHead = -1;
+		object.sleepNext = -1;
 
 		// set object state
 
@@ -310,10 +863,30 @@ namespace cubes
 		assert( id >= 0 && id < (int) impl->objects.size() );
 		assert( impl->objects[id].exists() );
 
-		dBodyDestroy( impl->objects[id].body );
-		dGeomDestroy( impl->objects[id].geom );
-		impl->objects[id].body = 0;
-		impl->objects[id].geom = 0;
+		// removing an object from a sleeping island may leave the rest unsupported, so wake them
+
+		impl->WakeIsland( id );
+
+		// park the body and geom in the pool instead of destroying them. pooled geoms are taken out
+		// of the space and disabled bodies are not stepped, so pooled objects cost nothing per frame
+
+		SimulationImpl::ObjectData & object = impl->objects[id];
+
+		dSpaceRemove( impl->space, object.geom );
+		dBodySetForce( object.body, 0, 0, 0 );
+		dBodySetTorque( object.body, 0, 0, 0 );
+		dBodyDisable( object.body );
+		dGeomDisable( object.geom );
+
+		SimulationImpl::PooledBody pooledBody;
+		pooledBody.body = object.body;
+		pooledBody.geom = object.geom;
+		impl->bodyPool.push_back( pooledBody );
+
+		object.body = 0;
+		object.geom = 0;
+
+		impl->freeObjects.push_back( id );
 	}
 
 	void Simulation::GetObjectState( int id, SimulationObjectState & objectState )
@@ -333,7 +906,7 @@ namespace cubes
 		objectState.linearVelocity = math::Vector( linearVelocity[0], linearVelocity[1], linearVelocity[2] );
 		objectState.angularVelocity = math::Vector( angularVelocity[0], angularVelocity[1], angularVelocity[2] );
 
-		objectState.enabled = impl->objects[id].timeAtRest < impl->config.RestTime;
+		objectState.enabled = !impl->objects[id].sleeping;
 	}
 
 	void Simulation::SetObjectState( int id, const SimulationObjectState & objectState, bool ignoreEnabledFlag )
@@ -358,22 +931,165 @@ namespace cubes
 		{
 			if ( objectState.enabled )
 			{
+				impl->WakeIsland( id );
 				impl->objects[id].timeAtRest = 0.0f;
-				dBodyEnable( impl->objects[id].body );
 			}
-			else
+			else if ( !impl->objects[id].sleeping )
 			{
+				// note: sleeps as an island of one. it wakes again if it is touching anything awake
 				impl->objects[id].timeAtRest = impl->config.RestTime;
-				dBodyDisable( impl->objects[id].body );
+				impl->SleepObject( id, id );
 			}
 		}
+
+		if ( impl->IsMoving( objectState.linearVelocity, objectState.angularVelocity ) )
+			impl->WakeIsland( id );
+	}
+
+	void Simulation::GetObjectStates( SimulationObjectStates & objectStates )
+	{
+		const int count = objectStates.count;
+		const int numObjects = (int) impl->objects.size();
+		const SimulationImpl::ObjectData * objects = count > 0 ? &impl->objects[0] : NULL;
+
+		for ( int i = 0; i < count; ++i )
+		{
+			const int id = objectStates.id[i];
+			assert( id >= 0 );
+			assert( id < numObjects );
+			assert( objects[id].exists() );
+
+			dBodyID body = objects[id].body;
+
+			const dReal * position = dBodyGetPosition( body );
+			const dReal * orientation = dBodyGetQuaternion( body );
+			const dReal * linearVelocity = dBodyGetLinearVel( body );
+			const dReal * angularVelocity = dBodyGetAngularVel( body );
+
+			objectStates.position[i] = math::Vector( position[0], position[1], position[2] );
+			objectStates.orientation[i] = math::Quaternion( orientation[0], orientation[1], orientation[2], orientation[3] );
+			objectStates.linearVelocity[i] = math::Vector( linearVelocity[0], linearVelocity[1], linearVelocity[2] );
+			objectStates.angularVelocity[i] = math::Vector( angularVelocity[0], angularVelocity[1], angularVelocity[2] );
+			objectStates.enabled[i] = !objects[id].sleeping;
+		}
 	}
 
-	const std::vector<uint16_t> & Simulation::GetObjectInteractions( int id ) const
+	void Simulation::SetObjectStates( const SimulationObjectStates & objectStates, bool ignoreEnabledFlag )
+	{
+		const int count = objectStates.count;
+		const int numObjects = (int) impl->objects.size();
+		SimulationImpl::ObjectData * objects = count > 0 ? &impl->objects[0] : NULL;
+		const float restTime = impl->config.RestTime;
+
+		for ( int i = 0; i < count; ++i )
+		{
+			const int id = objectStates.id[i];
+			assert( id >= 0 );
+			assert( id < numObjects );
+			assert( objects[id].exists() );
+
+			dBodyID body = objects[id].body;
+
+			const math::Vector & position = objectStates.position[i];
+			const math::Quaternion & orientation = objectStates.orientation[i];
+			const math::Vector & linearVelocity = objectStates.linearVelocity[i];
+			const math::Vector & angularVelocity = objectStates.angularVelocity[i];
+
+			dQuaternion quaternion;
+			quaternion[0] = orientation.w;
+			quaternion[1] = orientation.x;
+			quaternion[2] = orientation.y;
+			quaternion[3] = orientation.z;
+
+			dBodySetPosition( body, position.x, position.y, position.z );
+			dBodySetQuaternion( body, quaternion );
+			dBodySetLinearVel( body, linearVelocity.x, linearVelocity.y, linearVelocity.z );
+			dBodySetAngularVel( body, angularVelocity.x, angularVelocity.y, angularVelocity.z );
+
+			if ( !ignoreEnabledFlag )
+			{
+				if ( objectStates.enabled[i] )
+				{
+					impl->WakeIsland( id );
+					objects[id].timeAtRest = 0.0f;
+				}
+				else if ( !objects[id].sleeping )
+				{
+					objects[id].timeAtRest = restTime;
+					impl->SleepObject( id, id );
+				}
+			}
+
+			if ( impl->IsMoving( linearVelocity, angularVelocity ) )
+				impl->WakeIsland( id );
+		}
+	}
+
+	SimulationInteractions Simulation::GetObjectInteractions( int id ) const
 	{
 		assert( id >= 0 );
-		assert( id < (int) impl->interactions.size() );
-		return impl->interactions[id];
+		assert( id + 1 < (int) impl->interactionStart.size() );
+		const int start = impl->interactionStart[id];
+		const int count = impl->interactionStart[id+1] - start;
+		return SimulationInteractions( count ? &impl->interactions[start] : NULL, count );
+	}
+
+	int Simulation::GetNumInteractionPairs() const
+	{
+		return (int) impl->interactionPairs.size();
+	}
+
+	double Simulation::GetCollideTime() const
+	{
+		return impl->collideTime;
+	}
+
+	double Simulation::GetStepTime() const
+	{
+		return impl->stepTime;
+	}
+
+	uint64_t Simulation::GetStateHash() const
+	{
+		struct ObjectHashState
+		{
+			uint32_t id;
+			uint32_t enabled;
+			float position[3];
+			float orientation[4];
+			float linearVelocity[3];
+			float angularVelocity[3];
+		};
+
+		uint64_t hash = 0;
+
+		for ( int i = 0; i < (int) impl->objects.size(); ++i )
+		{
+			const SimulationImpl::ObjectData & object = impl->objects[i];
+			if ( !object.exists() )
+				continue;
+
+			const dReal * position = dBodyGetPosition( object.body );
+			const dReal * orientation = dBodyGetQuaternion( object.body );
+			const dReal * linearVelocity = dBodyGetLinearVel( object.body );
+			const dReal * angularVelocity = dBodyGetAngularVel( object.body );
+
+			ObjectHashState state;
+			state.id = i;
+			state.enabled = object.sleeping ? 0 : 1;
+			for ( int j = 0; j < 3; ++j )
+			{
+				state.position[j] = position[j];
+				state.linearVelocity[j] = linearVelocity[j];
+				state.angularVelocity[j] = angularVelocity[j];
+			}
+			for ( int j = 0; j < 4; ++j )
+				state.orientation[j] = orientation[j];
+
+			hash = core::murmur_hash_64( &state, sizeof( state ), hash );
+		}
+
+		return hash;
 	}
 
 	void Simulation::ApplyForce( int id, const math::Vector & force )
@@ -383,8 +1099,8 @@ namespace cubes
 		assert( impl->objects[id].exists() );
 		if ( force.length() > 0.001f )
 		{
+			impl->WakeIsland( id );
 			impl->objects[id].timeAtRest = 0.0f;
-			dBodyEnable( impl->objects[id].body );
 			dBodyAddForce( impl->objects[id].body, force.x, force.y, force.z );
 		}
 	}
@@ -396,15 +1112,17 @@ namespace cubes
 		assert( impl->objects[id].exists() );
 		if ( torque.length() > 0.001f )
 		{
+			impl->WakeIsland( id );
 			impl->objects[id].timeAtRest = 0.0f;
-			dBodyEnable( impl->objects[id].body );
 			dBodyAddTorque( impl->objects[id].body, torque.x, torque.y, torque.z );
 		}
 	}
 
 	void Simulation::AddPlane( const math::Vector & normal, float d )
 	{
-		impl->planes.push_back( dCreatePlane( impl->space, normal.x, normal.y, normal.z, d ) );
+		dGeomID plane = dCreatePlane( impl->space, normal.x, normal.y, normal.z, d );
+		dGeomSetData( plane, reinterpret_cast<void*>( (uint64_t) impl->planes.size() ) );
+		impl->planes.push_back( plane );
 	}
 
 	void Simulation::Reset()
@@ -419,5 +1137,7 @@ namespace cubes
 			dGeomDestroy( impl->planes[i] );
 
 		impl->planes.clear();
+
+		impl->contactCache.clear();
 	}
 }
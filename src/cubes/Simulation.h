@@ -14,6 +14,29 @@
 
 namespace cubes
 {	
+	// broadphase collision structure. quad tree is the default, but cubes mostly lie
+	// in a dense grid on a plane, where sweep and prune or hash space can be faster
+
+	enum SimulationBroadphase
+	{
+		BROADPHASE_QuadTree,
+		BROADPHASE_Hash,
+		BROADPHASE_SweepAndPrune,
+		BROADPHASE_Simple
+	};
+
+	// axis sort order for sweep and prune. first axis is swept, so put the longest extent first
+
+	enum SimulationSweepAxes
+	{
+		SWEEP_AXES_XYZ,
+		SWEEP_AXES_XZY,
+		SWEEP_AXES_YXZ,
+		SWEEP_AXES_YZX,
+		SWEEP_AXES_ZXY,
+		SWEEP_AXES_ZYX
+	};
+
 	// simulation config
 
 	struct SimulationConfig
@@ -32,6 +55,18 @@ namespace cubes
 		float RestTime;
 		float LinearRestThresholdSquared;
 		float AngularRestThresholdSquared;
+		int NumThreads;
+		SimulationBroadphase Broadphase;
+		math::Vector QuadTreeCenter;
+		math::Vector QuadTreeExtents;
+		int QuadTreeDepth;
+		int HashMinLevel;
+		int HashMaxLevel;
+		SimulationSweepAxes SweepAxes;
+		bool WarmStarting;
+		float WarmStartFactor;
+		float WarmStartDistance;
+		bool Deterministic;
 
 		SimulationConfig()
 		{
@@ -49,6 +84,18 @@ namespace cubes
 			RestTime = 0.1f;
 			LinearRestThresholdSquared = 0.25f * 0.25f;
 			AngularRestThresholdSquared = 0.25f * 0.25f;
+			NumThreads = 1;
+			Broadphase = BROADPHASE_QuadTree;
+			QuadTreeCenter = math::Vector(0,0,0);
+			QuadTreeExtents = math::Vector(100,100,100);
+			QuadTreeDepth = 10;
+			HashMinLevel = -2;
+			HashMaxLevel = 2;
+			SweepAxes = SWEEP_AXES_XYZ;
+			WarmStarting = false;
+			WarmStartFactor = 0.9f;
+			WarmStartDistance = 0.1f;
+			Deterministic = false;
 		}  
 	};
 
@@ -64,14 +111,74 @@ namespace cubes
 		math::Vector angularVelocity;
 	};
 
+	// structure of arrays over many objects for batch state get/set
+
+	struct SimulationObjectStates
+	{
+		int count;
+		std::vector<int> id;
+		std::vector<uint8_t> enabled;
+		std::vector<math::Vector> position;
+		std::vector<math::Quaternion> orientation;
+		std::vector<math::Vector> linearVelocity;
+		std::vector<math::Vector> angularVelocity;
+
+		SimulationObjectStates()
+		{
+			count = 0;
+		}
+
+		void Resize( int count )
+		{
+			// note: vectors never shrink, so resizing each frame does not allocate once warmed up
+			this->count = count;
+			id.resize( count );
+			enabled.resize( count );
+			position.resize( count );
+			orientation.resize( count );
+			linearVelocity.resize( count );
+			angularVelocity.resize( count );
+		}
+	};
+
+	// span over the objects an object touched during the last update. valid until the next update
+
+	struct SimulationInteractions
+	{
+		const uint16_t * data;
+		int count;
+
+		SimulationInteractions( const uint16_t * data, int count )
+		{
+			this->data = data;
+			this->count = count;
+		}
+
+		int size() const
+		{
+			return count;
+		}
+
+		uint16_t operator [] ( int index ) const
+		{
+			assert( index >= 0 );
+			assert( index < count );
+			return data[index];
+		}
+	};
+
 	// simulation class with dynamic object allocation
 
 	class Simulation
 	{	
-		static int * GetInitCount();
-
 	public:
 
+		// ode is initialized while any simulation (or anything else holding a reference) exists.
+		// reference counted and safe to call from any thread
+
+		static void AddODEReference();
+		static void RemoveODEReference();
+
 		Simulation();
 		~Simulation();
 
@@ -91,10 +198,24 @@ namespace cubes
 
 		void SetObjectState( int id, const SimulationObjectState & objectState, bool ignoreEnabledFlag = false );
 
-		const std::vector<uint16_t> & GetObjectInteractions( int id ) const;
+		void GetObjectStates( SimulationObjectStates & objectStates );
+
+		void SetObjectStates( const SimulationObjectStates & objectStates, bool ignoreEnabledFlag = false );
+
+		SimulationInteractions GetObjectInteractions( int id ) const;
 
 		int GetNumInteractionPairs() const;
 
+		double GetCollideTime() const;
+
+		double GetStepTime() const;
+
+		// hash of every object's id, position, orientation, velocities and enabled flag. two simulations in
+		// deterministic mode that add and remove the same objects in the same order and are fed the same inputs
+		// hash the same each frame, so comparing hashes detects desync
+
+		uint64_t GetStateHash() const;
+
 		void ApplyForce( int id, const math::Vector & force );
 
 		void ApplyTorque( int id, const math::Vector & torque );
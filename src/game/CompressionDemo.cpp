@@ -7,6 +7,7 @@
 #include "Snapshot.h"
 #include "Font.h"
 #include "FontManager.h"
+#include "Console.h"
 #include "protocol/Stream.h"
 #include "protocol/SlidingWindow.h"
 #include "protocol/SequenceBuffer.h"
@@ -17,6 +18,7 @@ static const int LeftPort = 1000;
 static const int RightPort = 1001;
 static const int MaxSnapshots = 256;
 static const int MaxPacketSize = 64 * 1024;         // this has to be really large for the worst case!
+static const int MaxQueueSize = 4 * MaxPacketSize;  // bottleneck queue size when the link rate is capped
 
 enum Context
 {
@@ -265,6 +267,7 @@ struct CompressionInternal
         snapshot_sequence_buffer = CORE_NEW( allocator, SnapshotSequenceBuffer, allocator, MaxSnapshots );
         networkSimulatorConfig.packetFactory = &packet_factory;
         networkSimulatorConfig.maxPacketSize = MaxPacketSize;
+        networkSimulatorConfig.queueSize = MaxQueueSize;
         network_simulator = CORE_NEW( allocator, network::Simulator, networkSimulatorConfig );
         context[0] = snapshot_sliding_window;
         context[1] = snapshot_sequence_buffer;
@@ -289,7 +292,10 @@ struct CompressionInternal
         interpolation_buffer.Reset();
         network_simulator->Reset();
         network_simulator->ClearStates();
-        network_simulator->AddState( { mode_data.latency, mode_data.jitter, mode_data.packet_loss } );
+        network::SimulatorState state( mode_data.latency, mode_data.jitter, mode_data.packet_loss );
+        state.bandwidth = mode_data.bandwidth;
+        network_simulator->AddState( state );
+        bandwidth = mode_data.bandwidth;
         snapshot_sliding_window->Reset();
         snapshot_sequence_buffer->Reset();
         send_sequence = 0;
@@ -303,6 +309,7 @@ struct CompressionInternal
     uint16_t recv_sequence;
     bool received_ack;
     float send_accumulator;
+    float bandwidth;
     const void * context[2];
     network::Simulator * network_simulator;
     SnapshotSlidingWindow * snapshot_sliding_window;
@@ -367,6 +374,11 @@ void CompressionDemo::Shutdown()
 
 void CompressionDemo::Update()
 {
+    // pick up a change in link rate from the console
+
+    if ( m_compression->bandwidth != compression_mode_data[GetMode()].bandwidth )
+        m_compression->Reset( compression_mode_data[GetMode()] );
+
     CubesUpdateConfig update_config;
 
     auto local_input = m_internal->GetLocalInput();
@@ -494,6 +506,13 @@ void CompressionDemo::Render()
     else
         snprintf( bandwidth_string, (int) sizeof( bandwidth_string ), "Bandwidth: %.2f mbps", bandwidth / 1000 );
 
+    if ( m_compression->bandwidth > 0.0f )
+    {
+        const int length = strlen( bandwidth_string );
+        snprintf( bandwidth_string + length, (int) sizeof( bandwidth_string ) - length, " (limit %d kbps) - Queue delay: %d ms",
+            (int) m_compression->bandwidth, (int) ( m_compression->network_simulator->GetQueueDelay() * 1000 ) );
+    }
+
     Font * font = global.fontManager->GetFont( "FPS" );
     if ( font )
     {
@@ -527,4 +546,14 @@ const char * CompressionDemo::GetModeDescription( int mode ) const
     return compression_mode_descriptions[mode];
 }
 
+CONSOLE_FUNCTION( compression_bandwidth )
+{
+    // cap the link rate in kbps for all compression modes. 0 = unlimited
+
+    const float bandwidth = core::max( (float) atof( args ), 0.0f );
+
+    for ( int i = 0; i < COMPRESSION_NUM_MODES; ++i )
+        compression_mode_data[i].bandwidth = bandwidth;
+}
+
 #endif // #ifdef CLIENT
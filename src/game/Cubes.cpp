@@ -29,13 +29,15 @@ void CubesInternal::Initialize( core::Allocator & allocator, const CubesConfig &
 
         game_config.simConfig.ERP = config.soften_simulation ? 0.5f : 0.25f;
         game_config.simConfig.CFM = config.soften_simulation ? 0.01f : 0.001f;
-        game_config.simConfig.MaxIterations = 64;
+        game_config.simConfig.MaxIterations = 32;
+        game_config.simConfig.WarmStarting = true;
         game_config.simConfig.MaximumCorrectingVelocity = config.soften_simulation ? 5.0f : 250.0f;
         game_config.simConfig.ContactSurfaceLayer = 0.01f;
         game_config.simConfig.Elasticity = 0.0f;
         game_config.simConfig.LinearDrag = 0.001f;
         game_config.simConfig.AngularDrag = 0.001f;
         game_config.simConfig.Friction = 200.0f;
+        game_config.simConfig.Deterministic = settings->deterministic;
 
         for ( int i = 0; i < config.num_simulations; ++i )
         {
@@ -69,6 +71,21 @@ void CubesInternal::Initialize( core::Allocator & allocator, const CubesConfig &
         simulation = nullptr;
     }
 
+    // create scheduler to step simulations in parallel
+
+    CORE_ASSERT( config.num_threads >= 1 );
+
+    if ( config.num_threads > 1 && config.num_simulations > 1 )
+    {
+        scheduler = CORE_NEW( allocator, CubesScheduler, core::min( config.num_threads, config.num_simulations ) );
+    }
+    else
+    {
+        scheduler = nullptr;
+    }
+
+    update_config = nullptr;
+
 #ifdef CLIENT
 
     // create views
@@ -90,6 +107,12 @@ void CubesInternal::Initialize( core::Allocator & allocator, const CubesConfig &
 
 void CubesInternal::Free( core::Allocator & allocator )
 {
+    if ( scheduler )
+    {
+        CORE_DELETE( allocator, CubesScheduler, scheduler );
+        scheduler = nullptr;
+    }
+
     if ( simulation )
     {
         for ( int i = 0; i < config.num_simulations; ++i )
@@ -133,10 +156,39 @@ extern "C"
     extern void dRandSetSeed( unsigned int seed );
 }
 
-void CubesInternal::Update( const CubesUpdateConfig & update_config )
+void CubesInternal::UpdateSimulation( int simulation_index )
 {
+    // note: may run on a scheduler worker thread. only touch this simulation
+
     const float deltaTime = global.timeBase.deltaTime;
 
+    const CubesUpdateConfigPerSim & sim_config = update_config->sim[simulation_index];
+
+    CubesSimulation & sim = simulation[simulation_index];
+
+    for ( int i = 0; i < sim_config.num_frames; ++i )
+    { 
+        sim.game_instance->SetPlayerInput( 0, sim_config.frame_input[i] );
+
+        if ( settings->deterministic )
+            dRandSetSeed( sim.frame );
+
+        sim.game_instance->Update( deltaTime );
+
+        sim.frame_hash[sim.frame % MaxFrameHashes] = sim.game_instance->GetStateHash();
+
+        sim.frame++;
+    }
+}
+
+void CubesInternal::UpdateSimulationJob( void * data, int simulation_index )
+{
+    CubesInternal * cubes = (CubesInternal*) data;
+    cubes->UpdateSimulation( simulation_index );
+}
+
+void CubesInternal::Update( const CubesUpdateConfig & update_config )
+{
 #ifdef CLIENT
     if ( global.console->IsActive() )
         input = game::Input();
@@ -144,24 +196,25 @@ void CubesInternal::Update( const CubesUpdateConfig & update_config )
 
     if ( simulation )
     {
-        for ( int i = 0; i < config.num_simulations; ++i )
-        {
-            for ( int j = 0; j < update_config.sim[i].num_frames; ++j )
-            { 
-                simulation[i].game_instance->SetPlayerInput( 0, update_config.sim[i].frame_input[j] );
+        this->update_config = &update_config;
 
-                if ( settings->deterministic )
-                    dRandSetSeed( simulation[i].frame );
-
-                simulation[i].game_instance->Update( deltaTime );
-
-                simulation[i].frame++;
-            }
+        if ( scheduler )
+        {
+            scheduler->Run( UpdateSimulationJob, this, config.num_simulations );
         }
+        else
+        {
+            for ( int i = 0; i < config.num_simulations; ++i )
+                UpdateSimulation( i );
+        }
+
+        this->update_config = nullptr;
     }
 
 #ifdef CLIENT
 
+    const float deltaTime = global.timeBase.deltaTime;
+
     if ( view )
     {
         for ( int i = 0; i < config.num_views; ++i )
@@ -5,15 +5,19 @@
 #include "cubes/Game.h"
 #include "cubes/View.h"
 #include "cubes/Hypercube.h"
+#include "cubes/Scheduler.h"
 
 const int CubeSteps = 30;
 const int MaxCubes = 1024;
 const int MaxViews = 4;
 const int MaxSimulations = 4;
 const int MaxSimFrames = 4;
+const int MaxFrameHashes = 1024;
 
 typedef game::Instance<hypercube::DatabaseObject, hypercube::ActiveObject> GameInstance;
 
+typedef cubes::Scheduler CubesScheduler;
+
 struct CubeInstance
 {
     float r,g,b,a;
@@ -94,6 +98,7 @@ struct CubesConfig
 {
     int num_simulations = 1;
     int num_views = 1;
+    int num_threads = 1;                    // simulations are stepped in parallel when > 1
     bool soften_simulation = false;
 };
 
@@ -101,6 +106,7 @@ struct CubesSimulation
 {
     uint32_t frame = 0;
     GameInstance * game_instance = nullptr;
+    uint64_t frame_hash[MaxFrameHashes];        // state hash after each frame, indexed by frame % MaxFrameHashes
 };
 
 struct CubesUpdateConfigPerSim
@@ -169,6 +175,10 @@ struct CubesInternal
 
     CubesSimulation * simulation;
 
+    CubesScheduler * scheduler;
+
+    const CubesUpdateConfig * update_config;
+
 #ifdef CLIENT
 
     CubesView * view;
@@ -185,6 +195,10 @@ struct CubesInternal
 
     void Update( const CubesUpdateConfig & update_config );
 
+    void UpdateSimulation( int simulation_index );
+
+    static void UpdateSimulationJob( void * data, int simulation_index );
+
 #ifdef CLIENT
 
     bool Clear();
@@ -9,6 +9,7 @@
 #include "Font.h"
 #include "FontManager.h"
 #include "protocol/Stream.h"
+#include "protocol/RangeStream.h"
 #include "protocol/SlidingWindow.h"
 #include "protocol/SequenceBuffer.h"
 #include "protocol/PacketFactory.h"
@@ -97,6 +98,7 @@ enum DeltaMode
     DELTA_MODE_RELATIVE_INDEX,
     DELTA_MODE_RELATIVE_POSITION,
     DELTA_MODE_RELATIVE_ORIENTATION,
+    DELTA_MODE_RANGE_CODED,
     DELTA_NUM_MODES
 };
 
@@ -107,6 +109,7 @@ const char * delta_mode_descriptions[]
     "Relative index",
     "Relative position",
     "Relative orientation",
+    "Range coded",
 };
 
 struct DeltaModeData : public SnapshotModeData
@@ -162,6 +165,8 @@ template <typename Stream> void serialize_cube_changed( Stream & stream, Quantiz
 
     if ( position_changed )
     {
+        serialize_scope( stream, "position" );
+
         serialize_int( stream, cube.position_x, -QuantizedPositionBoundXY, +QuantizedPositionBoundXY - 1 );
         serialize_int( stream, cube.position_y, -QuantizedPositionBoundXY, +QuantizedPositionBoundXY - 1 );
         serialize_int( stream, cube.position_z, 0, +QuantizedPositionBoundZ - 1 );
@@ -174,9 +179,15 @@ template <typename Stream> void serialize_cube_changed( Stream & stream, Quantiz
     }
 
     if ( orientation_changed )
+    {
+        serialize_scope( stream, "orientation" );
+
         serialize_object( stream, cube.orientation );
+    }
     else
+    {
         cube.orientation = base.orientation;
+    }
 }
 
 template <typename Stream> void serialize_offset( Stream & stream, int & offset, int small_bound, int large_bound )
@@ -327,6 +338,8 @@ template <typename Stream> void serialize_cube_relative_position( Stream & strea
 
     if ( position_changed )
     {
+        serialize_scope( stream, "position" );
+
         serialize_relative_position( stream, cube.position_x, cube.position_y, cube.position_z, base.position_x, base.position_y, base.position_z );
     }
     else if ( Stream::IsReading )
@@ -338,6 +351,8 @@ template <typename Stream> void serialize_cube_relative_position( Stream & strea
 
     if ( orientation_changed )
     {
+        serialize_scope( stream, "orientation" );
+
         serialize_object( stream, cube.orientation );
     }
     else
@@ -454,6 +469,8 @@ template <typename Stream> void serialize_cube_relative_orientation( Stream & st
 
     if ( position_changed )
     {
+        serialize_scope( stream, "position" );
+
         serialize_relative_position( stream, cube.position_x, cube.position_y, cube.position_z, base.position_x, base.position_y, base.position_z );
     }
     else if ( Stream::IsReading )
@@ -465,6 +482,8 @@ template <typename Stream> void serialize_cube_relative_orientation( Stream & st
 
     if ( orientation_changed )
     {
+        serialize_scope( stream, "orientation" );
+
         serialize_relative_orientation( stream, cube.orientation, base.orientation );
     }
     else
@@ -473,6 +492,235 @@ template <typename Stream> void serialize_cube_relative_orientation( Stream & st
     }
 }
 
+/*
+    Range coded delta. Same information as relative orientation mode, but every
+    field is range coded instead of using fixed bucket encodings, so the common
+    cases (cube unchanged, small position and orientation deltas) cost a fraction
+    of a bit.
+
+    Flags are coded with adaptive models, reset per-packet so each packet decodes
+    on its own regardless of packet loss. Only a handful of cubes change per packet,
+    too few for a 64 symbol model to adapt, so position and orientation deltas use
+    static models built from measured delta histograms instead.
+*/
+
+static const int RangePositionSymbols = 64;
+static const int RangeOrientationSymbols = 64;
+static const int RangeDeltaHistogramSize = 33;
+static const int MaxRangeCodedBytes = 32 * 1024;
+
+/*
+    Delta histograms measured the same way as delta_position_accum_* and delta_smallest_three_accum_*
+    with DELTA_STATS: absolute delta per changed cube, against a base snapshot three frames old, over
+    one minute of the player cube pushing through the grid. Entry i counts deltas of i units and the
+    last entry counts all larger deltas, which are sent with the escape symbol.
+*/
+
+static const uint64_t measured_delta_position_x[RangeDeltaHistogramSize] =
+{
+    1662, 1998, 1153, 900, 785, 614, 544, 498, 422, 390, 314,
+    305, 291, 243, 206, 196, 168, 185, 148, 166, 147, 133,
+    141, 135, 114, 128, 117, 97, 104, 88, 83, 76, 7397
+};
+
+static const uint64_t measured_delta_position_y[RangeDeltaHistogramSize] =
+{
+    1864, 2019, 1127, 876, 699, 620, 495, 422, 412, 329, 284,
+    273, 302, 231, 234, 217, 186, 179, 180, 147, 172, 138,
+    155, 146, 134, 98, 117, 94, 97, 71, 93, 100, 7437
+};
+
+static const uint64_t measured_delta_position_z[RangeDeltaHistogramSize] =
+{
+    1467, 2212, 1504, 1244, 1068, 908, 900, 825, 579, 470, 500,
+    353, 317, 253, 285, 230, 222, 218, 184, 189, 145, 174,
+    151, 165, 125, 136, 119, 113, 100, 131, 135, 121, 4405
+};
+
+static const uint64_t measured_delta_orientation_a[RangeDeltaHistogramSize] =
+{
+    2114, 2393, 1553, 1465, 1247, 923, 629, 494, 414, 458, 373,
+    328, 265, 254, 238, 214, 217, 218, 190, 166, 144, 129,
+    128, 105, 130, 96, 118, 109, 111, 114, 115, 99, 2658
+};
+
+static const uint64_t measured_delta_orientation_b[RangeDeltaHistogramSize] =
+{
+    1933, 2686, 1701, 1335, 1059, 781, 596, 511, 416, 400, 378,
+    350, 347, 254, 269, 266, 220, 209, 222, 192, 175, 167,
+    158, 142, 145, 133, 135, 117, 113, 119, 115, 84, 2481
+};
+
+static const uint64_t measured_delta_orientation_c[RangeDeltaHistogramSize] =
+{
+    3403, 3156, 1631, 1178, 903, 589, 398, 353, 311, 311, 267,
+    258, 226, 222, 222, 175, 149, 149, 140, 127, 141, 118,
+    138, 112, 124, 112, 83, 87, 88, 87, 97, 75, 2779
+};
+
+template <int N> void build_delta_model( protocol::StaticModel<N> & model, const uint64_t * histogram )
+{
+    // zigzag symbols: 0, -1, +1, -2, +2 ... so each sign of a delta gets half of its measured count. the last symbol is the escape
+
+    CORE_ASSERT( N == ( RangeDeltaHistogramSize - 1 ) * 2 );
+
+    uint64_t frequency[N];
+    frequency[0] = histogram[0] * 2;
+    for ( int i = 1; i < N - 1; ++i )
+        frequency[i] = histogram[(i+1)/2];
+    frequency[N-1] = histogram[RangeDeltaHistogramSize-1] * 2;
+
+    model.Reset( frequency );
+}
+
+struct DeltaRangeStaticModels
+{
+    protocol::StaticModel<RangePositionSymbols> position_x;
+    protocol::StaticModel<RangePositionSymbols> position_y;
+    protocol::StaticModel<RangePositionSymbols> position_z;
+    protocol::StaticModel<RangeOrientationSymbols> orientation_a;
+    protocol::StaticModel<RangeOrientationSymbols> orientation_b;
+    protocol::StaticModel<RangeOrientationSymbols> orientation_c;
+
+    DeltaRangeStaticModels()
+    {
+        build_delta_model( position_x, measured_delta_position_x );
+        build_delta_model( position_y, measured_delta_position_y );
+        build_delta_model( position_z, measured_delta_position_z );
+        build_delta_model( orientation_a, measured_delta_orientation_a );
+        build_delta_model( orientation_b, measured_delta_orientation_b );
+        build_delta_model( orientation_c, measured_delta_orientation_c );
+    }
+};
+
+static DeltaRangeStaticModels delta_range_static_models;
+
+struct DeltaRangeModels
+{
+    protocol::AdaptiveModel<2> changed;
+    protocol::AdaptiveModel<2> interacting;
+    protocol::AdaptiveModel<4> changed_flags;
+    protocol::AdaptiveModel<2> same_largest;
+};
+
+template <typename Stream> void serialize_cube_range_coded( Stream & stream, QuantizedCubeState & cube, const QuantizedCubeState & base, DeltaRangeModels & models )
+{
+    const int MaxDeltaXY = 2 * QuantizedPositionBoundXY - 1;
+    const int MaxDeltaZ = QuantizedPositionBoundZ - 1;
+    const int MaxDeltaOrientation = compressed_quaternion<OrientationBits>::max_value;
+
+    int interacting;
+    int flags;
+
+    if ( Stream::IsWriting )
+    {
+        interacting = cube.interacting ? 1 : 0;
+
+        const bool position_changed = cube.position_x != base.position_x || cube.position_y != base.position_y || cube.position_z != base.position_z;
+        const bool orientation_changed = cube.orientation != base.orientation;
+
+        flags = ( position_changed ? 1 : 0 ) | ( orientation_changed ? 2 : 0 );
+    }
+
+    serialize_symbol( stream, interacting, models.interacting );
+    serialize_symbol( stream, flags, models.changed_flags );
+
+    if ( Stream::IsReading )
+        cube.interacting = interacting != 0;
+
+    if ( flags & 1 )
+    {
+        int dx, dy, dz;
+
+        if ( Stream::IsWriting )
+        {
+            dx = cube.position_x - base.position_x;
+            dy = cube.position_y - base.position_y;
+            dz = cube.position_z - base.position_z;
+        }
+
+        serialize_signed_symbol( stream, dx, -MaxDeltaXY, +MaxDeltaXY, delta_range_static_models.position_x );
+        serialize_signed_symbol( stream, dy, -MaxDeltaXY, +MaxDeltaXY, delta_range_static_models.position_y );
+        serialize_signed_symbol( stream, dz, -MaxDeltaZ, +MaxDeltaZ, delta_range_static_models.position_z );
+
+        if ( Stream::IsReading )
+        {
+            cube.position_x = base.position_x + dx;
+            cube.position_y = base.position_y + dy;
+            cube.position_z = base.position_z + dz;
+        }
+    }
+    else if ( Stream::IsReading )
+    {
+        cube.position_x = base.position_x;
+        cube.position_y = base.position_y;
+        cube.position_z = base.position_z;
+    }
+
+    if ( flags & 2 )
+    {
+        int same_largest;
+        if ( Stream::IsWriting )
+            same_largest = cube.orientation.largest == base.orientation.largest ? 1 : 0;
+
+        serialize_symbol( stream, same_largest, models.same_largest );
+
+        if ( same_largest )
+        {
+            int da, db, dc;
+
+            if ( Stream::IsWriting )
+            {
+                da = int( cube.orientation.integer_a ) - int( base.orientation.integer_a );
+                db = int( cube.orientation.integer_b ) - int( base.orientation.integer_b );
+                dc = int( cube.orientation.integer_c ) - int( base.orientation.integer_c );
+            }
+
+            serialize_signed_symbol( stream, da, -MaxDeltaOrientation, +MaxDeltaOrientation, delta_range_static_models.orientation_a );
+            serialize_signed_symbol( stream, db, -MaxDeltaOrientation, +MaxDeltaOrientation, delta_range_static_models.orientation_b );
+            serialize_signed_symbol( stream, dc, -MaxDeltaOrientation, +MaxDeltaOrientation, delta_range_static_models.orientation_c );
+
+            if ( Stream::IsReading )
+            {
+                cube.orientation.largest = base.orientation.largest;
+                cube.orientation.integer_a = base.orientation.integer_a + da;
+                cube.orientation.integer_b = base.orientation.integer_b + db;
+                cube.orientation.integer_c = base.orientation.integer_c + dc;
+            }
+        }
+        else
+        {
+            serialize_bits( stream, cube.orientation.largest, 2 );
+            serialize_int( stream, cube.orientation.integer_a, 0, MaxDeltaOrientation );
+            serialize_int( stream, cube.orientation.integer_b, 0, MaxDeltaOrientation );
+            serialize_int( stream, cube.orientation.integer_c, 0, MaxDeltaOrientation );
+        }
+    }
+    else if ( Stream::IsReading )
+    {
+        cube.orientation = base.orientation;
+    }
+}
+
+template <typename Stream> void serialize_snapshot_range_coded( Stream & stream, QuantizedCubeState * cubes, const QuantizedCubeState * base_cubes )
+{
+    DeltaRangeModels models;
+
+    for ( int i = 0; i < NumCubes; ++i )
+    {
+        int changed;
+        if ( Stream::IsWriting )
+            changed = cubes[i] != base_cubes[i] ? 1 : 0;
+
+        serialize_symbol( stream, changed, models.changed );
+
+        if ( changed )
+            serialize_cube_range_coded( stream, cubes[i], base_cubes[i], models );
+        else if ( Stream::IsReading )
+            memcpy( &cubes[i], &base_cubes[i], sizeof( QuantizedCubeState ) );
+    }
+}
+
 #if DELTA_STATS
 
 void UpdateDeltaStats( const QuantizedCubeState & cube, const QuantizedCubeState & base )
@@ -1290,6 +1538,64 @@ struct DeltaSnapshotPacket : public protocol::Packet
             }
             break;
 
+            case DELTA_MODE_RANGE_CODED:
+            {
+                CORE_ASSERT( quantized_initial_snapshot );
+
+                QuantizedCubeState * quantized_base_cubes = nullptr;
+
+                if ( initial )
+                {
+                    quantized_base_cubes = quantized_initial_snapshot->cubes;
+                }
+                else
+                {
+                    if ( Stream::IsWriting )
+                    {
+                        CORE_ASSERT( quantized_snapshot_sliding_window );
+                        auto & entry = quantized_snapshot_sliding_window->Get( base_sequence );
+                        quantized_base_cubes = (QuantizedCubeState*) &entry.cubes[0];
+                    }
+                    else
+                    {
+                        CORE_ASSERT( quantized_snapshot_sequence_buffer );
+                        auto entry = quantized_snapshot_sequence_buffer->Find( base_sequence );
+                        CORE_ASSERT( entry );
+                        quantized_base_cubes = (QuantizedCubeState*) &entry->cubes[0];
+                    }
+                }
+
+                // the cubes are range coded into a side buffer, which is then embedded in the packet as bytes
+
+                uint8_t range_buffer[MaxRangeCodedBytes];
+
+                int range_bytes = 0;
+
+                if ( Stream::IsWriting )
+                {
+                    protocol::RangeWriteStream range_stream( range_buffer, MaxRangeCodedBytes );
+                    serialize_snapshot_range_coded( range_stream, quantized_cubes, quantized_base_cubes );
+                    range_stream.Flush();
+                    CORE_ASSERT( !range_stream.IsOverflow() );
+                    range_bytes = range_stream.GetBytesProcessed();
+                }
+
+                serialize_int( stream, range_bytes, 1, MaxRangeCodedBytes );
+                serialize_bytes( stream, range_buffer, range_bytes );
+
+                if ( Stream::IsReading )
+                {
+                    protocol::RangeReadStream range_stream( range_buffer, range_bytes );
+                    serialize_snapshot_range_coded( range_stream, quantized_cubes, quantized_base_cubes );
+                    if ( range_stream.IsOverflow() )
+                    {
+                        stream.Abort();
+                        return;
+                    }
+                }
+            }
+            break;
+
             default:
                 break;
         }
@@ -1348,6 +1654,7 @@ struct DeltaInternal
         quantized_snapshot_sequence_buffer = CORE_NEW( allocator, QuantizedSnapshotSequenceBuffer, allocator, MaxSnapshots );
         networkSimulatorConfig.packetFactory = &packet_factory;
         networkSimulatorConfig.maxPacketSize = MaxPacketSize;
+        networkSimulatorConfig.compressPackets = true;
         network_simulator = CORE_NEW( allocator, network::Simulator, networkSimulatorConfig );
         context[0] = quantized_snapshot_sliding_window;
         context[1] = quantized_snapshot_sequence_buffer;
@@ -1769,12 +2076,13 @@ void DeltaDemo::Render()
     m_internal->Render( render_config );
 
     const float bandwidth = m_delta->network_simulator->GetBandwidth();
+    const float savings = m_delta->network_simulator->GetBandwidthSavings();
 
     char bandwidth_string[256];
     if ( bandwidth < 1024 )
-        snprintf( bandwidth_string, (int) sizeof( bandwidth_string ), "Bandwidth: %d kbps", (int) bandwidth );
+        snprintf( bandwidth_string, (int) sizeof( bandwidth_string ), "Bandwidth: %d kbps (LZ saves %d%%)", (int) bandwidth, (int) savings );
     else
-        snprintf( bandwidth_string, (int) sizeof( bandwidth_string ), "Bandwidth: %.2f mbps", bandwidth / 1000 );
+        snprintf( bandwidth_string, (int) sizeof( bandwidth_string ), "Bandwidth: %.2f mbps (LZ saves %d%%)", bandwidth / 1000, (int) savings );
 
     Font * font = global.fontManager->GetFont( "Bandwidth" );
     if ( font )
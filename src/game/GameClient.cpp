@@ -82,6 +82,7 @@ GameClient * CreateGameClient( core::Allocator & allocator, int clientPort )
     bsdSocketConfig.port = clientPort;
     bsdSocketConfig.maxPacketSize = 1200;
     bsdSocketConfig.packetFactory = packetFactory;
+    bsdSocketConfig.coalescePackets = true;
     auto networkInterface = CORE_NEW( allocator, network::BSDSocket, bsdSocketConfig );
 
     network::SimulatorConfig networkSimulatorConfig;
@@ -10,6 +10,10 @@ enum PacketTypes
 {
     PACKET_CONNECTION = clientServer::CLIENT_SERVER_PACKET_CONNECTION,
 
+    // IMPORTANT: game packet types must come after the client/server packet types
+
+    PACKET_CLIENT_SERVER_LAST = clientServer::NUM_CLIENT_SERVER_NUM_PACKETS - 1,
+
     // ...
 
     NUM_PACKET_TYPES
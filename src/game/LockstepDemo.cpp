@@ -289,6 +289,28 @@ struct LockstepInternal
         network_simulator->ClearStates();
         network_simulator->AddState( { mode_data.latency, mode_data.jitter, mode_data.packet_loss } );
         network_simulator->SetTCPMode( mode_data.tcp );
+        hash_frame = 0;
+        desync = false;
+        desync_frame = 0;
+    }
+
+    void CheckDesync( const CubesSimulation & left, const CubesSimulation & right )
+    {
+        // the right simulation plays the same inputs behind the left, so each frame it catches up on
+        // must hash the same as the left did for that frame. frames older than the hash history are skipped
+
+        while ( hash_frame < right.frame )
+        {
+            const int index = hash_frame % MaxFrameHashes;
+
+            if ( !desync && left.frame - hash_frame <= (uint32_t) MaxFrameHashes && left.frame_hash[index] != right.frame_hash[index] )
+            {
+                desync = true;
+                desync_frame = hash_frame;
+            }
+
+            hash_frame++;
+        }
     }
 
     core::Allocator * allocator;
@@ -296,6 +318,9 @@ struct LockstepInternal
     LockstepInputSlidingWindow input_sliding_window;
     LockstepPlayoutDelayBuffer playout_delay_buffer;
     network::Simulator * network_simulator;
+    uint32_t hash_frame;
+    bool desync;
+    uint32_t desync_frame;
 };
 
 LockstepDemo::LockstepDemo( core::Allocator & allocator )
@@ -328,12 +353,15 @@ bool LockstepDemo::Initialize()
     
     config.num_simulations = 2;
     config.num_views = 2;
+    config.num_threads = 2;
     config.soften_simulation = true;
 
-    m_internal->Initialize( *m_allocator, config, m_settings );
+    // note: set before initialize, it selects the simulation's deterministic mode
 
     m_settings->deterministic = lockstep_mode_data[GetMode()].deterministic;
 
+    m_internal->Initialize( *m_allocator, config, m_settings );
+
     return true;
 }
 
@@ -454,6 +482,9 @@ void LockstepDemo::Update()
 
     // run the simulation(s)
     m_internal->Update( update_config );
+
+    // detect desync between the left and right simulations
+    m_lockstep->CheckDesync( m_internal->simulation[0], m_internal->simulation[1] );
 }
 
 bool LockstepDemo::Clear()
@@ -478,6 +509,16 @@ void LockstepDemo::Render()
         const float text_y = 5;
         font->Begin();
         font->DrawText(text_x, text_y, bandwidth_string, Color(0.27f, 0.81f, 1.0f));
+
+        if (m_lockstep->desync)
+        {
+            char desync_string[256];
+            snprintf(desync_string, (int) sizeof(desync_string), "Desync at frame %d", (int)m_lockstep->desync_frame);
+            const float desync_x = (global.displayWidth - font->GetTextWidth(desync_string)) / 2;
+            const float desync_y = text_y + font->GetLineHeight();
+            font->DrawText(desync_x, desync_y, desync_string, Color(1.0f, 0.27f, 0.27f));
+        }
+
         font->End();
     }
 
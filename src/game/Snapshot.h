@@ -1185,6 +1185,7 @@ struct SnapshotModeData
     float latency = 0.0f;
     float packet_loss = 0.0f;
     float jitter = 0.0f;
+    float bandwidth = 0.0f;                 // bottleneck link rate in kbps. 0 = unlimited
     float extrapolation = 0.2f;
     SnapshotInterpolation interpolation = SNAPSHOT_INTERPOLATION_NONE;
 };
@@ -147,6 +147,7 @@ struct SnapshotInternal
         network::SimulatorConfig networkSimulatorConfig;
         networkSimulatorConfig.packetFactory = &packet_factory;
         networkSimulatorConfig.maxPacketSize = MaxPacketSize;
+        networkSimulatorConfig.queueSize = 4 * MaxPacketSize;
         network_simulator = CORE_NEW( allocator, network::Simulator, networkSimulatorConfig );
         Reset( mode_data );
     }
@@ -164,7 +165,9 @@ struct SnapshotInternal
         interpolation_buffer.Reset();
         network_simulator->Reset();
         network_simulator->ClearStates();
-        network_simulator->AddState( { mode_data.latency, mode_data.jitter, mode_data.packet_loss } );
+        network::SimulatorState state( mode_data.latency, mode_data.jitter, mode_data.packet_loss );
+        state.bandwidth = mode_data.bandwidth;
+        network_simulator->AddState( state );
         send_sequence = 0;
         recv_sequence = 0;
         send_accumulator = 1.0f;
@@ -15,15 +15,18 @@ namespace network
 
     Address::Address( uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint16_t port )
     {
-        m_type = ADDRESS_IPV4;
-        m_address4 = uint32_t(a) | (uint32_t(b)<<8) | (uint32_t(c)<<16) | (uint32_t(d)<<24);
+        Clear();
+        const uint8_t address[] = { a, b, c, d };
+        uint32_t address4;
+        memcpy( &address4, address, 4 );
+        SetAddress4( address4 );
         m_port = port;
     }
 
     Address::Address( uint32_t address, int16_t port )
     {
-        m_type = ADDRESS_IPV4;
-        m_address4 = htonl( address );        // IMPORTANT: stored in network byte order. eg. big endian!
+        Clear();
+        SetAddress4( htonl( address ) );        // IMPORTANT: stored in network byte order. eg. big endian!
         m_port = port;
     }
 
@@ -31,6 +34,7 @@ namespace network
                       uint16_t e, uint16_t f, uint16_t g, uint16_t h,
                       uint16_t port )
     {
+        Clear();
         m_type = ADDRESS_IPV6;
         m_address6[0] = htons( a );
         m_address6[1] = htons( b );
@@ -45,6 +49,7 @@ namespace network
 
     Address::Address( const uint16_t address[], uint16_t port )
     {
+        Clear();
         m_type = ADDRESS_IPV6;
         for ( int i = 0; i < 8; ++i )
             m_address6[i] = htons( address[i] );
@@ -53,11 +58,11 @@ namespace network
 
     Address::Address( const sockaddr_storage & addr )
     {
+        Clear();
         if ( addr.ss_family == AF_INET )
         {
             const sockaddr_in & addr_ipv4 = reinterpret_cast<const sockaddr_in&>( addr );
-            m_type = ADDRESS_IPV4;
-            m_address4 = addr_ipv4.sin_addr.s_addr;
+            SetAddress4( addr_ipv4.sin_addr.s_addr );
             m_port = ntohs( addr_ipv4.sin_port );
         }
         else if ( addr.ss_family == AF_INET6 )
@@ -70,12 +75,12 @@ namespace network
         else
         {
             CORE_ASSERT( false );
-            Clear();
         }
     }
 
     Address::Address( const sockaddr_in6 & addr_ipv6 )
     {
+        Clear();
         m_type = ADDRESS_IPV6;
         memcpy( m_address6, &addr_ipv6.sin6_addr, 16 );
         m_port = ntohs( addr_ipv6.sin6_port );
@@ -83,12 +88,11 @@ namespace network
 
     Address::Address( addrinfo * p )
     {
-        m_port = 0;
+        Clear();
         if ( p->ai_family == AF_INET )
         { 
-            m_type = ADDRESS_IPV4;
             struct sockaddr_in * ipv4 = (struct sockaddr_in *)p->ai_addr;
-            m_address4 = ipv4->sin_addr.s_addr;
+            SetAddress4( ipv4->sin_addr.s_addr );
             m_port = ntohs( ipv4->sin_port );
         } 
         else if ( p->ai_family == AF_INET6 )
@@ -98,10 +102,6 @@ namespace network
             memcpy( m_address6, &ipv6->sin6_addr, 16 );
             m_port = ntohs( ipv6->sin6_port );
         }
-        else
-        {
-            Clear();
-        }
     }
 
     Address::Address( const char * address )
@@ -128,8 +128,9 @@ namespace network
         strncpy( address, address_in, 255 );
         address[255] = '\0';
 
+        Clear();
+
         int addressLength = strlen( address );
-        m_port = 0;
         if ( address[0] == '[' )
         {
             const int base_index = addressLength - 1;
@@ -175,8 +176,7 @@ namespace network
         struct sockaddr_in sockaddr4;
         if ( inet_pton( AF_INET, address, &sockaddr4.sin_addr ) == 1 )
         {
-            m_type = ADDRESS_IPV4;
-            m_address4 = sockaddr4.sin_addr.s_addr;
+            SetAddress4( sockaddr4.sin_addr.s_addr );
         }
         else
         {
@@ -185,17 +185,29 @@ namespace network
         }
     }
 
+    void Address::SetAddress4( uint32_t address )
+    {
+        m_type = ADDRESS_IPV4;
+        memset( m_address, 0, 10 );
+        m_address[10] = 0xff;
+        m_address[11] = 0xff;
+        memcpy( m_address + 12, &address, 4 );
+    }
+
     void Address::Clear()
     {
         m_type = ADDRESS_UNDEFINED;
-        memset( m_address6, 0, sizeof( m_address6 ) );
+        memset( m_address, 0, sizeof( m_address ) );
         m_port = 0;
+        m_padding = 0;
     }
 
     uint32_t Address::GetAddress4() const
     {
         CORE_ASSERT( m_type == ADDRESS_IPV4 );
-        return m_address4;
+        uint32_t address4;
+        memcpy( &address4, m_address + 12, 4 );
+        return address4;
     }
 
     const uint16_t * Address::GetAddress6() const
@@ -216,17 +228,17 @@ namespace network
 
     AddressType Address::GetType() const
     {
-        return m_type;
+        return (AddressType) m_type;
     }
 
     const char * Address::ToString( char buffer[], int bufferSize ) const
     {
         if ( m_type == ADDRESS_IPV4 )
         {
-            const uint8_t a =   m_address4 & 0xff;
-            const uint8_t b = ( m_address4 >> 8  ) & 0xff;
-            const uint8_t c = ( m_address4 >> 16 ) & 0xff;
-            const uint8_t d = ( m_address4 >> 24 ) & 0xff;
+            const uint8_t a = m_address[12];
+            const uint8_t b = m_address[13];
+            const uint8_t c = m_address[14];
+            const uint8_t d = m_address[15];
             if ( m_port != 0 )
                 snprintf( buffer, bufferSize, "%d.%d.%d.%d:%d", a, b, c, d, m_port );
             else
@@ -259,22 +271,10 @@ namespace network
         return m_type != ADDRESS_UNDEFINED;
     }
 
-    bool Address::operator ==( const Address & other ) const
+    uint64_t Address::Hash() const
     {
-        if ( m_type != other.m_type )
-            return false;
-        if ( m_port != other.m_port )
-            return false;
-        if ( m_type == ADDRESS_IPV4 && m_address4 == other.m_address4 )
-            return true;
-        else if ( m_type == ADDRESS_IPV6 && memcmp( m_address6, other.m_address6, sizeof( m_address6 ) ) == 0 )
-            return true;
-        else
-            return false;
+        return core::murmur_hash_64( this, sizeof( Address ), 0 );
     }
 
-    bool Address::operator !=( const Address & other ) const
-    {
-        return !( *this == other );
-    }
+    static_assert( sizeof( Address ) == 20, "address packed form must be 20 bytes with no padding" );
 }
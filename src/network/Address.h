@@ -5,6 +5,7 @@
 
 #include "core/Core.h"
 #include "network/Enums.h"
+#include <string.h>
 
 struct addrinfo;
 struct sockaddr_in6;
@@ -12,17 +13,27 @@ struct sockaddr_storage;
 
 namespace network
 {    
+    /*
+        Addresses are stored in a canonical packed form: 16 bytes of IPv6
+        address in network byte order (IPv4 is mapped in as ::ffff:a.b.c.d),
+        then the port, the type and a zero pad byte. That is exactly 20 bytes
+        with no uninitialized padding, so compare and hash work on raw words.
+
+        IMPORTANT: the type is part of the packed form, so an IPv4 address is
+        never equal to the same address written as v4 mapped IPv6.
+    */
+
     class Address
     {
-        AddressType m_type;
-
         union
         {
-            uint32_t m_address4;
+            uint8_t m_address[16];
             uint16_t m_address6[8];
         };
 
         uint16_t m_port;
+        uint8_t m_type;
+        uint8_t m_padding;
 
    public:
 
@@ -64,13 +75,31 @@ namespace network
 
         bool IsValid() const;
 
-        bool operator ==( const Address & other ) const;
+        uint64_t Hash() const;
 
-        bool operator !=( const Address & other ) const;
+        bool operator ==( const Address & other ) const
+        {
+            // IMPORTANT: compares the packed form as two 64 bit words and one 32 bit word, without branches.
+
+            uint64_t a[2], b[2];
+            uint32_t c, d;
+            memcpy( a, this, 16 );
+            memcpy( b, &other, 16 );
+            memcpy( &c, &m_port, 4 );
+            memcpy( &d, &other.m_port, 4 );
+            return ( ( a[0] ^ b[0] ) | ( a[1] ^ b[1] ) | uint64_t( c ^ d ) ) == 0;
+        }
+
+        bool operator !=( const Address & other ) const
+        {
+            return !( *this == other );
+        }
 
     protected:
 
         void Parse( const char * address );
+
+        void SetAddress4( uint32_t address );
     };
 }
 
@@ -2,6 +2,7 @@
 
 #include "network/Network.h"
 #include "network/BSDSocket.h"
+#include "network/Compressor.h"
 #include "core/Memory.h"
 #include "core/Queue.h"
 #include <string.h>
@@ -31,6 +32,10 @@
 
 namespace network
 {     
+    const int ProtocolIdBytes = 8;
+    const int CompressionHeaderBytes = 1;
+    const int CoalescedPacketHeaderBytes = 4;
+
     BSDSocket::BSDSocket( const BSDSocketConfig & config )
         : m_config( config ), 
           m_send_queue( config.allocator ? *config.allocator : core::memory::default_allocator() ),
@@ -50,10 +55,29 @@ namespace network
 
         m_receiveBuffer = (uint8_t*) m_allocator->Allocate( m_config.maxPacketSize );
 
+        m_compressBuffer = nullptr;
+        m_compressor = nullptr;
+        m_captureFile = nullptr;
+
+        if ( m_config.compressPackets )
+        {
+            m_compressBuffer = (uint8_t*) m_allocator->Allocate( m_config.maxPacketSize + CompressionHeaderBytes );
+            m_compressor = CORE_NEW( *m_allocator, Compressor, *m_allocator, m_config.compressionDictionary, m_config.compressionDictionarySize );
+        }
+
+        if ( m_config.captureFile )
+        {
+            m_captureFile = fopen( m_config.captureFile, "ab" );
+            if ( !m_captureFile )
+                printf( "failed to open packet capture file: %s\n", m_config.captureFile );
+        }
+
         m_error = BSD_SOCKET_ERROR_NONE;
 
         m_context = nullptr;
 
+        memset( m_counters, 0, sizeof( m_counters ) );
+
         // create socket
 
         m_socket = socket( m_config.ipv6 ? AF_INET6 : AF_INET, SOCK_DGRAM, IPPROTO_UDP );
@@ -163,6 +187,24 @@ namespace network
             m_receiveBuffer = nullptr;
         }
 
+        if ( m_compressBuffer )
+        {
+            m_allocator->Free( m_compressBuffer );
+            m_compressBuffer = nullptr;
+        }
+
+        if ( m_compressor )
+        {
+            CORE_DELETE( *m_allocator, Compressor, m_compressor );
+            m_compressor = nullptr;
+        }
+
+        if ( m_captureFile )
+        {
+            fclose( m_captureFile );
+            m_captureFile = nullptr;
+        }
+
         if ( m_socket != 0 )
         {
             #if CORE_PLATFORM == CORE_PLATFORM_MAC || CORE_PLATFORM == CORE_PLATFORM_UNIX
@@ -252,7 +294,9 @@ namespace network
 
     uint32_t BSDSocket::GetMaxPacketSize() const
     {
-        return m_config.maxPacketSize;
+        // coalesced packets are each prefixed with their size, so reserve it here so callers size packets to fit
+
+        return m_config.coalescePackets ? m_config.maxPacketSize - CoalescedPacketHeaderBytes : m_config.maxPacketSize;
     }
 
     protocol::PacketFactory & BSDSocket::GetPacketFactory() const
@@ -280,6 +324,12 @@ namespace network
 
     void BSDSocket::SendPackets()
     {
+        if ( m_config.coalescePackets )
+        {
+            SendCoalescedPackets();
+            return;
+        }
+
         while ( core::queue::size( m_send_queue ) )
         {
             auto packet = m_send_queue[0];
@@ -297,17 +347,7 @@ namespace network
             uint64_t protocolId = m_config.protocolId;
             serialize_uint64( stream, protocolId );
 
-            const int maxPacketType = m_config.packetFactory->GetNumTypes() - 1;
-            
-            int packetType = packet->GetType();
-            
-            serialize_int( stream, packetType, 0, maxPacketType );
-            
-            stream.Align();
-
-            packet->SerializeWrite( stream );
-
-            stream.Check( 0x51246234 );
+            WritePacket( packet, stream );
 
             stream.Flush();
 
@@ -331,12 +371,117 @@ namespace network
                 continue;
             }
 
-            SendPacketInternal( packet->GetAddress(), data, bytes );
+            SendDatagram( packet->GetAddress(), data, bytes );
 
             m_config.packetFactory->Destroy( packet );
         }
     }
 
+    void BSDSocket::SendCoalescedPackets()
+    {
+        /*
+            Coalesced datagram layout:
+
+                [protocol id: 64 bits]
+                [packet bytes: 32 bits][packet data: type, align, packet, check]
+                [packet bytes: 32 bits][packet data: type, align, packet, check]
+                ...
+
+            Serialized packet data is always a whole number of words, so every
+            packet starts word aligned and can be read in place on receive.
+        */
+
+        const int numPackets = core::queue::size( m_send_queue );
+        if ( numPackets == 0 )
+            return;
+
+        protocol::Packet * packets[numPackets];
+        for ( int i = 0; i < numPackets; ++i )
+            packets[i] = m_send_queue[i];
+
+        core::queue::consume( m_send_queue, numPackets );
+
+        uint8_t datagram[m_config.maxPacketSize];
+        uint8_t buffer[m_config.maxPacketSize];
+
+        const int HeaderBytes = ProtocolIdBytes;
+        const int PacketHeaderBytes = CoalescedPacketHeaderBytes;
+
+        {
+            protocol::WriteStream stream( datagram, m_config.maxPacketSize );
+            uint64_t protocolId = m_config.protocolId;
+            serialize_uint64( stream, protocolId );
+            stream.Flush();
+            CORE_ASSERT( stream.GetBytesProcessed() == HeaderBytes );
+        }
+
+        for ( int i = 0; i < numPackets; ++i )
+        {
+            if ( !packets[i] )
+                continue;
+
+            const Address address = packets[i]->GetAddress();
+
+            int datagramBytes = HeaderBytes;
+
+            for ( int j = i; j < numPackets; ++j )
+            {
+                auto packet = packets[j];
+
+                if ( !packet || packet->GetAddress() != address )
+                    continue;
+
+                packets[j] = nullptr;
+
+                protocol::WriteStream stream( buffer, m_config.maxPacketSize );
+
+                stream.SetContext( m_context );
+
+                WritePacket( packet, stream );
+
+                stream.Flush();
+
+                m_config.packetFactory->Destroy( packet );
+
+                CORE_ASSERT( !stream.IsOverflow() );
+
+                if ( stream.IsOverflow() )
+                {
+                    m_counters[BSD_SOCKET_COUNTER_SERIALIZE_WRITE_OVERFLOW]++;
+                    continue;
+                }
+
+                const uint32_t bytes = stream.GetBytesProcessed();
+
+                CORE_ASSERT( bytes % 4 == 0 );
+
+                if ( HeaderBytes + PacketHeaderBytes + bytes > m_config.maxPacketSize )
+                {
+                    m_counters[BSD_SOCKET_COUNTER_PACKET_TOO_LARGE_TO_SEND]++;
+                    continue;
+                }
+
+                if ( datagramBytes + PacketHeaderBytes + bytes > m_config.maxPacketSize )
+                {
+                    SendDatagram( address, datagram, datagramBytes );
+                    datagramBytes = HeaderBytes;
+                }
+
+                if ( datagramBytes > HeaderBytes )
+                    m_counters[BSD_SOCKET_COUNTER_PACKETS_COALESCED]++;
+
+                *( (uint32_t*) ( datagram + datagramBytes ) ) = core::host_to_network( bytes );
+                datagramBytes += PacketHeaderBytes;
+
+                memcpy( datagram + datagramBytes, stream.GetData(), bytes );
+                datagramBytes += bytes;
+            }
+
+            if ( datagramBytes > HeaderBytes )
+                SendDatagram( address, datagram, datagramBytes );
+        }
+    }
+
     void BSDSocket::ReceivePackets()
     {
         while ( true )
@@ -345,7 +490,9 @@ namespace network
                 break;
 
             Address address;
-            int received_bytes = ReceivePacketInternal( address, m_receiveBuffer, m_config.maxPacketSize );
+            int received_bytes = ReceiveDatagram( address );
+            if ( received_bytes < 0 )
+                continue;
             if ( !received_bytes )
                 break;
 
@@ -363,50 +510,228 @@ namespace network
                 continue;
             }
 
-            const int maxPacketType = m_config.packetFactory->GetNumTypes() - 1;
-            int packetType = 0;
-            serialize_int( stream, packetType, 0, maxPacketType );
+            if ( !m_config.coalescePackets )
+            {
+                auto packet = ReadPacket( stream );
+                if ( !packet )
+                    continue;
 
-            stream.Align();
+                packet->SetAddress( address );
+
+                core::queue::push_back( m_receive_queue, packet );
 
-            auto packet = m_config.packetFactory->Create( packetType );
-            CORE_ASSERT( packet );
-            CORE_ASSERT( packet->GetType() == packetType );
-            if ( !packet )
-            {
-//                printf( "failed to create packet of type %d\n", packetType );
-                m_counters[BSD_SOCKET_COUNTER_CREATE_PACKET_FAILURES]++;
                 continue;
             }
 
-            packet->SerializeRead( stream );
+            // split coalesced datagram. see SendCoalescedPackets for the layout
 
-            // IMPORTANT: packet read was aborted. intentionally ignore this packet
-            if ( stream.Aborted() )
-            {
-                m_counters[BSD_SOCKET_COUNTER_ABORTED_PACKET_READS]++;
-                m_config.packetFactory->Destroy( packet );
-                continue;
-            }
+            int offset = stream.GetBytesProcessed();
 
-            CORE_ASSERT( !stream.IsOverflow() );
-            if ( stream.IsOverflow() )
+            while ( offset + CoalescedPacketHeaderBytes <= received_bytes )
             {
-                m_counters[BSD_SOCKET_COUNTER_SERIALIZE_READ_OVERFLOW]++;
-                m_config.packetFactory->Destroy( packet );
-                continue;
+                if ( core::queue::size( m_receive_queue ) == m_config.receiveQueueSize )
+                    break;
+
+                const int bytes = core::network_to_host( *( (const uint32_t*) ( m_receiveBuffer + offset ) ) );
+
+                offset += CoalescedPacketHeaderBytes;
+
+                if ( bytes <= 0 || bytes % 4 != 0 || offset + bytes > received_bytes )
+                {
+                    m_counters[BSD_SOCKET_COUNTER_SERIALIZE_READ_OVERFLOW]++;
+                    break;
+                }
+
+                // IMPORTANT: read each packet only from its own bytes, so a malformed packet can't read into the next one
+
+                Stream packetStream( m_receiveBuffer + offset, bytes );
+
+                packetStream.SetContext( m_context );
+
+                offset += bytes;
+
+                auto packet = ReadPacket( packetStream );
+                if ( !packet )
+                    continue;
+
+                // serialized packets are padded to a whole word, so the read must end in the packet's last word
+
+                if ( packetStream.GetBytesProcessed() <= bytes - 4 )
+                {
+                    m_counters[BSD_SOCKET_COUNTER_SERIALIZE_READ_OVERFLOW]++;
+                    m_config.packetFactory->Destroy( packet );
+                    continue;
+                }
+
+                packet->SetAddress( address );
+
+                core::queue::push_back( m_receive_queue, packet );
             }
+        }
+    }
+
+    void BSDSocket::WritePacket( protocol::Packet * packet, protocol::WriteStream & stream )
+    {
+        typedef protocol::WriteStream Stream;
+
+        const int maxPacketType = m_config.packetFactory->GetNumTypes() - 1;
+
+        int packetType = packet->GetType();
+
+        serialize_scope_id( stream, "packet", packetType );
+
+        serialize_int( stream, packetType, 0, maxPacketType );
+
+        stream.Align();
+
+        packet->SerializeWrite( stream );
+
+        stream.Check( 0x51246234 );
+    }
+
+    protocol::Packet * BSDSocket::ReadPacket( protocol::ReadStream & stream )
+    {
+        typedef protocol::ReadStream Stream;
+
+        const int maxPacketType = m_config.packetFactory->GetNumTypes() - 1;
+        int packetType = 0;
+        serialize_int( stream, packetType, 0, maxPacketType );
+
+        stream.Align();
+
+        auto packet = m_config.packetFactory->Create( packetType );
+        CORE_ASSERT( packet );
+        CORE_ASSERT( packet->GetType() == packetType );
+        if ( !packet )
+        {
+//            printf( "failed to create packet of type %d\n", packetType );
+            m_counters[BSD_SOCKET_COUNTER_CREATE_PACKET_FAILURES]++;
+            return nullptr;
+        }
+
+        packet->SerializeRead( stream );
+
+        // IMPORTANT: packet read was aborted. intentionally ignore this packet
+        if ( stream.Aborted() )
+        {
+            m_counters[BSD_SOCKET_COUNTER_ABORTED_PACKET_READS]++;
+            m_config.packetFactory->Destroy( packet );
+            return nullptr;
+        }
+
+        CORE_ASSERT( !stream.IsOverflow() );
+        if ( stream.IsOverflow() )
+        {
+            m_counters[BSD_SOCKET_COUNTER_SERIALIZE_READ_OVERFLOW]++;
+            m_config.packetFactory->Destroy( packet );
+            return nullptr;
+        }
+
+        if ( !stream.Check( 0x51246234 ) )
+        {
+            m_config.packetFactory->Destroy( packet );
+            return nullptr;
+        }
+
+        return packet;
+    }
+
+    void BSDSocket::SendDatagram( const Address & address, const uint8_t * data, int bytes )
+    {
+        /*
+            Compressed datagram layout:
+
+                [protocol id: 64 bits][compression flag: 8 bits][payload]
+
+            The protocol id stays uncompressed so foreign packets are still rejected cheaply.
+            If the payload doesn't get smaller it is sent as is with the flag cleared.
+        */
+
+        CORE_ASSERT( bytes >= ProtocolIdBytes );
+
+        if ( m_captureFile )
+            write_capture_record( m_captureFile, data + ProtocolIdBytes, bytes - ProtocolIdBytes );
+
+        if ( !m_compressor )
+        {
+            SendPacketInternal( address, data, bytes );
+            return;
+        }
+
+        const int payloadBytes = bytes - ProtocolIdBytes;
+
+        memcpy( m_compressBuffer, data, ProtocolIdBytes );
+
+        const int compressedBytes = m_compressor->Compress( data + ProtocolIdBytes, payloadBytes, 
+                                                            m_compressBuffer + ProtocolIdBytes + CompressionHeaderBytes, 
+                                                            payloadBytes - 1 );
+
+        if ( compressedBytes > 0 )
+        {
+            m_compressBuffer[ProtocolIdBytes] = 1;
+            m_counters[BSD_SOCKET_COUNTER_PACKETS_COMPRESSED]++;
+            m_counters[BSD_SOCKET_COUNTER_BYTES_AFTER_COMPRESSION] += compressedBytes;
+        }
+        else
+        {
+            m_compressBuffer[ProtocolIdBytes] = 0;
+            memcpy( m_compressBuffer + ProtocolIdBytes + CompressionHeaderBytes, data + ProtocolIdBytes, payloadBytes );
+            m_counters[BSD_SOCKET_COUNTER_BYTES_AFTER_COMPRESSION] += payloadBytes;
+        }
+
+        m_counters[BSD_SOCKET_COUNTER_BYTES_BEFORE_COMPRESSION] += payloadBytes;
 
-            if ( !stream.Check( 0x51246234 ) )
+        const int datagramBytes = ProtocolIdBytes + CompressionHeaderBytes + ( compressedBytes > 0 ? compressedBytes : payloadBytes );
+
+        SendPacketInternal( address, m_compressBuffer, datagramBytes );
+    }
+
+    int BSDSocket::ReceiveDatagram( Address & sender )
+    {
+        if ( !m_compressor )
+            return ReceivePacketInternal( sender, m_receiveBuffer, m_config.maxPacketSize );
+
+        const int received_bytes = ReceivePacketInternal( sender, m_compressBuffer, m_config.maxPacketSize + CompressionHeaderBytes );
+        if ( !received_bytes )
+            return 0;
+
+        if ( received_bytes < ProtocolIdBytes + CompressionHeaderBytes )
+        {
+            m_counters[BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES]++;
+            return -1;
+        }
+
+        memcpy( m_receiveBuffer, m_compressBuffer, ProtocolIdBytes );
+
+        const uint8_t * payload = m_compressBuffer + ProtocolIdBytes + CompressionHeaderBytes;
+        const int payloadBytes = received_bytes - ProtocolIdBytes - CompressionHeaderBytes;
+
+        // IMPORTANT: must match the largest payload SendDatagram sends, or packets near max packet size are dropped
+
+        const int maxPayloadBytes = m_config.maxPacketSize - ProtocolIdBytes;
+
+        if ( m_compressBuffer[ProtocolIdBytes] == 0 )
+        {
+            if ( payloadBytes > maxPayloadBytes )
             {
-                m_config.packetFactory->Destroy( packet );
-                continue;
+                m_counters[BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES]++;
+                return -1;
             }
 
-            packet->SetAddress( address );
+            memcpy( m_receiveBuffer + ProtocolIdBytes, payload, payloadBytes );
 
-            core::queue::push_back( m_receive_queue, packet );
+            return ProtocolIdBytes + payloadBytes;
         }
+
+        const int decompressedBytes = m_compressor->Decompress( payload, payloadBytes, m_receiveBuffer + ProtocolIdBytes, maxPayloadBytes );
+
+        if ( decompressedBytes < 0 )
+        {
+            m_counters[BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES]++;
+            return -1;
+        }
+
+        return ProtocolIdBytes + decompressedBytes;
     }
 
     bool BSDSocket::SendPacketInternal( const Address & address, const uint8_t * data, size_t bytes )
@@ -414,7 +739,7 @@ namespace network
         CORE_ASSERT( m_socket );
         CORE_ASSERT( address.IsValid() );
         CORE_ASSERT( bytes > 0 );
-        CORE_ASSERT( bytes <= m_config.maxPacketSize );
+        CORE_ASSERT( bytes <= m_config.maxPacketSize + ( m_compressor ? CompressionHeaderBytes : 0 ) );
 
         bool result = false;
 
@@ -6,11 +6,14 @@
 #include "core/Types.h"
 #include "network/Interface.h"
 #include "protocol/PacketFactory.h"
+#include <stdio.h>
 
 namespace core { class Allocator; }
 
 namespace network 
 {     
+    class Compressor;
+
     struct BSDSocketConfig
     {
         BSDSocketConfig()
@@ -23,6 +26,11 @@ namespace network
             packetFactory = nullptr;
             sendQueueSize = 256;
             receiveQueueSize = 256;
+            coalescePackets = false;
+            compressPackets = false;
+            compressionDictionary = nullptr;
+            compressionDictionarySize = 0;
+            captureFile = nullptr;
         }
 
         core::Allocator * allocator;                // allocator for long term allocations matching object life cycle. if nullptr then the default allocator is used.
@@ -32,6 +40,11 @@ namespace network
         int maxPacketSize;                          // maximum packet size
         int sendQueueSize;                          // send queue size between "SendPacket" and sendto. additional sent packets will be dropped.
         int receiveQueueSize;                       // send queue size between "recvfrom" and "ReceivePacket" function. additional received packets will be dropped.
+        bool coalescePackets;                       // if true, all packets queued for the same address are sent in one datagram per update (split up to max packet size). each packet costs a 4 byte size prefix, taken off GetMaxPacketSize. both sides must agree.
+        bool compressPackets;                       // if true, datagrams are LZ compressed after the protocol id (sent uncompressed if they don't shrink). both sides must agree.
+        const uint8_t * compressionDictionary;      // optional static dictionary for packet compression. both sides must use the same dictionary. see tools/TrainDictionary.
+        int compressionDictionarySize;              // size of the compression dictionary in bytes
+        const char * captureFile;                   // if set, uncompressed datagram payloads sent are appended to this file for dictionary training.
         protocol::PacketFactory * packetFactory;    // packet factory (required)
     };
 
@@ -67,12 +80,22 @@ namespace network
 
         void SendPackets();
 
+        void SendCoalescedPackets();
+
         void ReceivePackets();
 
+        void WritePacket( protocol::Packet * packet, protocol::WriteStream & stream );
+
+        protocol::Packet * ReadPacket( protocol::ReadStream & stream );
+
         bool SendPacketInternal( const Address & address, const uint8_t * data, size_t bytes );
     
         int ReceivePacketInternal( Address & sender, void * data, int size );
 
+        void SendDatagram( const Address & address, const uint8_t * data, int bytes );
+
+        int ReceiveDatagram( Address & sender );           // returns 0 when there is nothing left to receive, -1 if the datagram received was discarded
+
     private:
 
         const BSDSocketConfig m_config;
@@ -85,6 +108,9 @@ namespace network
         core::Queue<protocol::Packet*> m_send_queue;
         core::Queue<protocol::Packet*> m_receive_queue;
         uint8_t * m_receiveBuffer;
+        uint8_t * m_compressBuffer;
+        Compressor * m_compressor;
+        FILE * m_captureFile;
         const void ** m_context;
         uint64_t m_counters[BSD_SOCKET_COUNTER_NUM_COUNTERS];
 
@@ -0,0 +1,455 @@
+// Network Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#include "network/Compressor.h"
+#include "core/Memory.h"
+#include <string.h>
+#include <stdlib.h>
+
+namespace network
+{
+    const int MinMatch = 4;
+    const int MaxOffset = 65535;
+    const int HashBits = 12;
+    const int HashSize = 1 << HashBits;
+
+    static inline uint32_t read_uint32( const uint8_t * p )
+    {
+        uint32_t value;
+        memcpy( &value, p, 4 );
+        return value;
+    }
+
+    static inline uint32_t hash_sequence( uint32_t sequence )
+    {
+        return ( sequence * 2654435761U ) >> ( 32 - HashBits );
+    }
+
+    static inline bool write_length( uint8_t *& op, const uint8_t * oend, int length )
+    {
+        while ( length >= 255 )
+        {
+            if ( op >= oend )
+                return false;
+            *op++ = 255;
+            length -= 255;
+        }
+        if ( op >= oend )
+            return false;
+        *op++ = (uint8_t) length;
+        return true;
+    }
+
+    static inline bool read_length( const uint8_t *& ip, const uint8_t * iend, int & length )
+    {
+        while ( true )
+        {
+            if ( ip >= iend )
+                return false;
+            const uint8_t value = *ip++;
+            length += value;
+            if ( value != 255 )
+                return true;
+        }
+    }
+
+    static bool write_sequence( uint8_t *& op,
+                                const uint8_t * oend,
+                                const uint8_t * literals,
+                                int numLiterals,
+                                int offset,
+                                int matchLength )
+    {
+        // IMPORTANT: offset of zero means this is the last sequence and has literals only.
+
+        const int matchCode = offset ? matchLength - MinMatch : 0;
+
+        if ( op >= oend )
+            return false;
+
+        uint8_t * token = op++;
+
+        *token = (uint8_t) ( ( core::min( numLiterals, 15 ) << 4 ) | core::min( matchCode, 15 ) );
+
+        if ( numLiterals >= 15 && !write_length( op, oend, numLiterals - 15 ) )
+            return false;
+
+        if ( op + numLiterals > oend )
+            return false;
+
+        memcpy( op, literals, numLiterals );
+        op += numLiterals;
+
+        if ( !offset )
+            return true;
+
+        if ( op + 2 > oend )
+            return false;
+
+        *op++ = (uint8_t) ( offset & 0xFF );
+        *op++ = (uint8_t) ( offset >> 8 );
+
+        if ( matchCode >= 15 && !write_length( op, oend, matchCode - 15 ) )
+            return false;
+
+        return true;
+    }
+
+    Compressor::Compressor( core::Allocator & allocator, const uint8_t * dictionary, int dictionarySize )
+    {
+        CORE_ASSERT( dictionarySize >= 0 );
+        CORE_ASSERT( dictionarySize <= MaxCompressorDictionarySize );
+        CORE_ASSERT( dictionary || dictionarySize == 0 );
+
+        m_allocator = &allocator;
+        m_dictionary = dictionary;
+        m_dictionarySize = dictionarySize;
+        m_dictionaryTable = nullptr;
+
+        if ( m_dictionarySize < MinMatch )
+        {
+            m_dictionarySize = 0;
+            return;
+        }
+
+        m_dictionaryTable = (int32_t*) m_allocator->Allocate( sizeof( int32_t ) * HashSize );
+
+        for ( int i = 0; i < HashSize; ++i )
+            m_dictionaryTable[i] = -1;
+
+        // later positions overwrite earlier ones, so matches prefer the end of the dictionary (short offsets)
+
+        for ( int i = 0; i <= m_dictionarySize - MinMatch; ++i )
+            m_dictionaryTable[ hash_sequence( read_uint32( m_dictionary + i ) ) ] = i;
+    }
+
+    Compressor::~Compressor()
+    {
+        if ( m_dictionaryTable )
+        {
+            m_allocator->Free( m_dictionaryTable );
+            m_dictionaryTable = nullptr;
+        }
+    }
+
+    int Compressor::Compress( const uint8_t * input, int inputBytes, uint8_t * output, int maxOutputBytes ) const
+    {
+        CORE_ASSERT( input );
+        CORE_ASSERT( inputBytes >= 0 );
+        CORE_ASSERT( output );
+
+        // IMPORTANT: positions below are in the combined space of dictionary followed by input.
+        // position p < dictionary size is in the dictionary, otherwise it is input[p - dictionary size].
+
+        const int D = m_dictionarySize;
+
+        int32_t inputTable[HashSize];
+        for ( int i = 0; i < HashSize; ++i )
+            inputTable[i] = -1;
+
+        uint8_t * op = output;
+        const uint8_t * oend = output + maxOutputBytes;
+
+        int anchor = 0;
+        int i = 0;
+
+        while ( i <= inputBytes - MinMatch )
+        {
+            const uint32_t sequence = read_uint32( input + i );
+            const uint32_t hash = hash_sequence( sequence );
+
+            int candidate = -1;
+
+            const int previous = inputTable[hash];
+            inputTable[hash] = i;
+
+            if ( previous >= 0 && i - previous <= MaxOffset && read_uint32( input + previous ) == sequence )
+            {
+                candidate = D + previous;
+            }
+            else if ( m_dictionaryTable )
+            {
+                const int entry = m_dictionaryTable[hash];
+                if ( entry >= 0 && D + i - entry <= MaxOffset && read_uint32( m_dictionary + entry ) == sequence )
+                    candidate = entry;
+            }
+
+            if ( candidate < 0 )
+            {
+                i++;
+                continue;
+            }
+
+            // extend the match. dictionary matches run on into the start of the input.
+
+            int source = candidate + MinMatch;
+            int dest = i + MinMatch;
+
+            while ( dest < inputBytes )
+            {
+                const uint8_t value = source < D ? m_dictionary[source] : input[source - D];
+                if ( value != input[dest] )
+                    break;
+                source++;
+                dest++;
+            }
+
+            if ( !write_sequence( op, oend, input + anchor, i - anchor, D + i - candidate, dest - i ) )
+                return 0;
+
+            i = dest;
+            anchor = i;
+        }
+
+        if ( !write_sequence( op, oend, input + anchor, inputBytes - anchor, 0, 0 ) )
+            return 0;
+
+        return op - output;
+    }
+
+    int Compressor::Decompress( const uint8_t * input, int inputBytes, uint8_t * output, int maxOutputBytes ) const
+    {
+        CORE_ASSERT( input );
+        CORE_ASSERT( output );
+
+        const int D = m_dictionarySize;
+
+        const uint8_t * ip = input;
+        const uint8_t * iend = input + inputBytes;
+
+        int op = 0;
+
+        while ( true )
+        {
+            if ( ip >= iend )
+                return -1;
+
+            const uint8_t token = *ip++;
+
+            int numLiterals = token >> 4;
+            if ( numLiterals == 15 && !read_length( ip, iend, numLiterals ) )
+                return -1;
+
+            if ( numLiterals > iend - ip || numLiterals > maxOutputBytes - op )
+                return -1;
+
+            memcpy( output + op, ip, numLiterals );
+            ip += numLiterals;
+            op += numLiterals;
+
+            if ( ip == iend )
+                break;
+
+            if ( iend - ip < 2 )
+                return -1;
+
+            const int offset = ip[0] | ( ip[1] << 8 );
+            ip += 2;
+
+            if ( offset == 0 || offset > op + D )
+                return -1;
+
+            int matchLength = token & 0xF;
+            if ( matchLength == 15 && !read_length( ip, iend, matchLength ) )
+                return -1;
+            matchLength += MinMatch;
+
+            if ( matchLength > maxOutputBytes - op )
+                return -1;
+
+            // IMPORTANT: byte by byte copy. matches may overlap the bytes they produce.
+
+            for ( int j = 0; j < matchLength; ++j )
+            {
+                const int source = op - offset;
+                output[op] = source >= 0 ? output[source] : m_dictionary[D + source];
+                op++;
+            }
+        }
+
+        return op;
+    }
+
+    // ---------------------------------------------------------------------------
+
+    const int TrainKmerSize = 8;
+    const int TrainSegmentSize = 32;
+    const int TrainHashBits = 20;
+
+    struct TrainSegment
+    {
+        int offset;
+        uint64_t score;
+    };
+
+    static inline uint32_t hash_kmer( const uint8_t * p )
+    {
+        uint64_t value;
+        memcpy( &value, p, 8 );
+        return (uint32_t) ( ( value * 0x9E3779B97F4A7C15ULL ) >> ( 64 - TrainHashBits ) );
+    }
+
+    static int compare_segments( const void * a, const void * b )
+    {
+        const TrainSegment * sa = (const TrainSegment*) a;
+        const TrainSegment * sb = (const TrainSegment*) b;
+        if ( sa->score < sb->score )
+            return -1;
+        if ( sa->score > sb->score )
+            return +1;
+        return sa->offset - sb->offset;
+    }
+
+    int train_dictionary( core::Allocator & allocator,
+                          const uint8_t * data,
+                          const int * sizes,
+                          int numSamples,
+                          uint8_t * dictionary,
+                          int maxDictionarySize )
+    {
+        CORE_ASSERT( data );
+        CORE_ASSERT( sizes );
+        CORE_ASSERT( dictionary );
+
+        maxDictionarySize = core::min( maxDictionarySize, MaxCompressorDictionarySize );
+
+        int totalBytes = 0;
+        for ( int i = 0; i < numSamples; ++i )
+            totalBytes += sizes[i];
+
+        if ( totalBytes < TrainSegmentSize || maxDictionarySize < TrainSegmentSize )
+            return 0;
+
+        // count how often each kmer occurs across all samples
+
+        const int numCounts = 1 << TrainHashBits;
+
+        uint32_t * counts = (uint32_t*) allocator.Allocate( sizeof( uint32_t ) * numCounts );
+
+        memset( counts, 0, sizeof( uint32_t ) * numCounts );
+
+        {
+            int start = 0;
+            for ( int i = 0; i < numSamples; ++i )
+            {
+                for ( int j = 0; j <= sizes[i] - TrainKmerSize; ++j )
+                    counts[ hash_kmer( data + start + j ) ]++;
+                start += sizes[i];
+            }
+        }
+
+        // split the samples into one epoch per dictionary segment and pick the best scoring segment from each.
+        // a segment scores the sum of the counts of its kmers. counts of picked kmers are cleared so they are
+        // not picked again by later epochs.
+
+        const int numEpochs = maxDictionarySize / TrainSegmentSize;
+        const int epochSize = core::max( TrainSegmentSize, totalBytes / numEpochs );
+        const int kmersPerSegment = TrainSegmentSize - TrainKmerSize + 1;
+
+        TrainSegment * segments = (TrainSegment*) allocator.Allocate( sizeof( TrainSegment ) * numEpochs );
+
+        int numSegments = 0;
+
+        for ( int epoch = 0; epoch < numEpochs; ++epoch )
+        {
+            const int epochBegin = epoch * epochSize;
+            const int epochEnd = core::min( epochBegin + epochSize, totalBytes );
+
+            if ( epochBegin >= totalBytes )
+                break;
+
+            TrainSegment best;
+            best.offset = -1;
+            best.score = 0;
+
+            int start = 0;
+            for ( int i = 0; i < numSamples; start += sizes[i++] )
+            {
+                const int sampleEnd = start + sizes[i];
+
+                const int begin = core::max( epochBegin, start );
+                const int end = core::min( epochEnd, sampleEnd - TrainSegmentSize + 1 );
+
+                if ( begin >= end )
+                    continue;
+
+                uint64_t score = 0;
+                for ( int k = 0; k < kmersPerSegment; ++k )
+                    score += counts[ hash_kmer( data + begin + k ) ];
+
+                for ( int offset = begin; offset < end; ++offset )
+                {
+                    if ( offset > begin )
+                    {
+                        score -= counts[ hash_kmer( data + offset - 1 ) ];
+                        score += counts[ hash_kmer( data + offset + kmersPerSegment - 1 ) ];
+                    }
+
+                    if ( score > best.score )
+                    {
+                        best.offset = offset;
+                        best.score = score;
+                    }
+                }
+            }
+
+            if ( best.offset < 0 )
+                continue;
+
+            for ( int k = 0; k < kmersPerSegment; ++k )
+                counts[ hash_kmer( data + best.offset + k ) ] = 0;
+
+            segments[numSegments++] = best;
+        }
+
+        // most valuable segments go last, closest to the packet data so they get the shortest offsets
+
+        qsort( segments, numSegments, sizeof( TrainSegment ), compare_segments );
+
+        int dictionarySize = 0;
+
+        for ( int i = 0; i < numSegments; ++i )
+        {
+            memcpy( dictionary + dictionarySize, data + segments[i].offset, TrainSegmentSize );
+            dictionarySize += TrainSegmentSize;
+        }
+
+        allocator.Free( segments );
+        allocator.Free( counts );
+
+        return dictionarySize;
+    }
+
+    // ---------------------------------------------------------------------------
+
+    void write_capture_record( FILE * file, const uint8_t * data, int bytes )
+    {
+        CORE_ASSERT( file );
+        CORE_ASSERT( data );
+        CORE_ASSERT( bytes >= 0 );
+
+        const uint32_t size = core::host_to_network( (uint32_t) bytes );
+
+        fwrite( &size, sizeof( size ), 1, file );
+        fwrite( data, bytes, 1, file );
+    }
+
+    int read_capture_record( FILE * file, uint8_t * data, int maxBytes )
+    {
+        CORE_ASSERT( file );
+        CORE_ASSERT( data );
+
+        uint32_t size;
+        if ( fread( &size, sizeof( size ), 1, file ) != 1 )
+            return 0;
+
+        size = core::network_to_host( size );
+
+        if ( size > (uint32_t) maxBytes )
+            return -1;
+
+        if ( size > 0 && fread( data, size, 1, file ) != 1 )
+            return -1;
+
+        return (int) size;
+    }
+}
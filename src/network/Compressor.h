@@ -0,0 +1,87 @@
+// Network Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#ifndef NETWORK_COMPRESSOR_H
+#define NETWORK_COMPRESSOR_H
+
+#include "core/Core.h"
+#include <stdio.h>
+
+namespace core { class Allocator; }
+
+namespace network
+{
+    const int MaxCompressorDictionarySize = 65535;
+
+    /*
+        LZ4-style packet compressor with an optional static dictionary.
+
+        Each sequence is a token byte (literal length in the high nibble,
+        match length - 4 in the low nibble, 15 means extra length bytes
+        follow), the literals, then a 16 bit little endian match offset.
+        The final sequence has literals only.
+
+        Match offsets reach back through the packet into the dictionary,
+        so the dictionary acts as if it were prepended to every packet.
+        Both sides must use exactly the same dictionary. The dictionary
+        hash table is built once on construction, so per-packet cost is
+        proportional to packet size only.
+    */
+
+    class Compressor
+    {
+    public:
+
+        Compressor( core::Allocator & allocator, const uint8_t * dictionary = nullptr, int dictionarySize = 0 );
+
+        ~Compressor();
+
+        // returns compressed size in bytes, or zero if the packet does not compress to fewer than maxOutputBytes.
+
+        int Compress( const uint8_t * input, int inputBytes, uint8_t * output, int maxOutputBytes ) const;
+
+        // returns decompressed size in bytes, or -1 if the compressed data is malformed or does not fit.
+
+        int Decompress( const uint8_t * input, int inputBytes, uint8_t * output, int maxOutputBytes ) const;
+
+        int GetDictionarySize() const { return m_dictionarySize; }
+
+    private:
+
+        core::Allocator * m_allocator;
+
+        const uint8_t * m_dictionary;
+        int m_dictionarySize;
+        int32_t * m_dictionaryTable;
+
+        Compressor( const Compressor & other );
+        Compressor & operator = ( const Compressor & other );
+    };
+
+    /*
+        Trains a static dictionary from samples of uncompressed packet data.
+
+        Samples are concatenated in the data buffer with their sizes in the
+        sizes array. Byte sequences that recur most often across the samples
+        are selected and packed into the dictionary, most valuable last so
+        they sit at the shortest match offsets. Returns the dictionary size.
+    */
+
+    int train_dictionary( core::Allocator & allocator,
+                          const uint8_t * data,
+                          const int * sizes,
+                          int numSamples,
+                          uint8_t * dictionary,
+                          int maxDictionarySize );
+
+    /*
+        Packet capture files are a sequence of [uint32 size][data] records.
+        BSDSocket writes them when BSDSocketConfig::captureFile is set and
+        the dictionary training tool reads them back.
+    */
+
+    void write_capture_record( FILE * file, const uint8_t * data, int bytes );
+
+    int read_capture_record( FILE * file, uint8_t * data, int maxBytes );
+}
+
+#endif
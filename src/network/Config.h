@@ -3,6 +3,8 @@
 #ifndef NETWORK_CONFIG_H
 #define NETWORK_CONFIG_H
 
-#define NETWORK_USE_RESOLVER 0
+#ifndef NETWORK_USE_RESOLVER
+#define NETWORK_USE_RESOLVER 1
+#endif
 
 #endif
@@ -7,6 +7,7 @@ namespace network
 {
     const int MaxSimulatorStates = 32;
     const int MaxResolveAddresses = 8;
+    const int MaxResolveName = 256;
 }
 
 #endif
@@ -2,37 +2,65 @@
 
 #include "network/DNSResolver.h"
 
-#if CORE_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
 
+#include "core/Memory.h"
+#include "core/Queue.h"
+#include "core/Hash.h"
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace network
 {
-    ResolveResult DNSResolve_Blocking( std::string name, bool ipv6 = true )
+    static uint16_t split_port( const char * name, char * host, int hostSize )
     {
-        const int family = ipv6 ? AF_INET6 : AF_INET;
-        const int socktype = SOCK_DGRAM;
+        // "host:port" -> host and port. names with more than one ':' are ipv6 and have no port suffix
 
-        struct addrinfo hints, *res, *p;
-        memset( &hints, 0, sizeof hints );
-        hints.ai_family = family;
-        hints.ai_socktype = socktype;
+        strncpy( host, name, hostSize - 1 );
+        host[hostSize-1] = '\0';
+
+        char * colon = strchr( host, ':' );
+        if ( !colon || strchr( colon + 1, ':' ) )
+            return 0;
 
-        uint16_t port = 0;
-        char * hostname = const_cast<char*>( name.c_str() );
-        for ( int i = 0; i < name.size(); ++i )
+        *colon = '\0';
+        return (uint16_t) atoi( colon + 1 );
+    }
+
+    static bool hostname_equal( const char * a, const char * b )
+    {
+        while ( *a && *b )
         {
-            if ( hostname[i] == ':' )
-            {
-                hostname[i] = '\0';
-                port = atoi( &hostname[i+1] );
-                break;
-            }
+            if ( tolower( *a ) != tolower( *b ) )
+                return false;
+            ++a;
+            ++b;
         }
+        return *a == *b;
+    }
+
+    ResolveResult DNSResolve_Blocking( const char * name, bool ipv6 )
+    {
+        CORE_ASSERT( name );
+
+        char hostname[MaxResolveName];
+        const uint16_t port = split_port( name, hostname, sizeof( hostname ) );
+
+        struct addrinfo hints, *res, *p;
+        memset( &hints, 0, sizeof hints );
+        hints.ai_family = ipv6 ? AF_INET6 : AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
 
         if ( getaddrinfo( hostname, nullptr, &hints, &res ) != 0 )
             return ResolveResult();
@@ -40,7 +68,7 @@ namespace network
         ResolveResult result;
         for ( p = res; p != nullptr; p = p->ai_next )
         {
-            if ( result.numAddresses >= MaxResolveAddresses - 1 )
+            if ( result.numAddresses >= MaxResolveAddresses )
                 break;
             auto address = Address( p );
             if ( address.IsValid() )
@@ -56,66 +84,472 @@ namespace network
         return result;
     }
 
-    DNSResolver::DNSResolver( bool ipv6 )
+    struct DNSResolver::Entry
+    {
+        ResolveEntry entry;
+        char name[MaxResolveName];
+        uint64_t key = 0;
+        double expireTime = 0.0;
+        bool used = false;
+        bool orphaned = false;                  // cleared while the lookup was in flight. freed when the lookup completes.
+    };
+
+    struct DNSResolver::HostsEntry
+    {
+        char name[MaxResolveName];
+        Address address;
+    };
+
+    struct DNSResolver::Request
+    {
+        int index;
+        ResolveResult result;
+    };
+
+    /*
+        Each worker owns a single producer, single consumer ring of completed
+        lookups. The worker pushes, the game thread pops in Update. An entry
+        has at most one lookup in flight, so a ring of maxEntries never fills.
+    */
+
+    struct DNSResolver::Worker
     {
-        m_ipv6 = ipv6;
+        std::thread thread;
+        Request * completions = nullptr;
+        uint32_t mask = 0;
+        std::atomic<uint32_t> head;
+        std::atomic<uint32_t> tail;
+
+        Worker() : head( 0 ), tail( 0 ) {}
+
+        void Push( const Request & request )
+        {
+            const uint32_t t = tail.load( std::memory_order_relaxed );
+            CORE_ASSERT( t - head.load( std::memory_order_acquire ) <= mask );
+            completions[t & mask] = request;
+            tail.store( t + 1, std::memory_order_release );
+        }
+
+        bool Pop( Request & request )
+        {
+            const uint32_t h = head.load( std::memory_order_relaxed );
+            if ( h == tail.load( std::memory_order_acquire ) )
+                return false;
+            request = completions[h & mask];
+            head.store( h + 1, std::memory_order_release );
+            return true;
+        }
+    };
+
+    // pending lookups. workers sleep on the condition variable until there is work
+
+    struct DNSResolver::Shared
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        core::Queue<int> pending;
+        bool quit = false;
+
+        Shared( core::Allocator & allocator ) : pending( allocator ) {}
+    };
+
+    DNSResolver::DNSResolver( const DNSResolverConfig & config )
+        : m_config( config ), m_names( config.allocator ? *config.allocator : core::memory::default_allocator() )
+    {
+        CORE_ASSERT( m_config.numThreads > 0 );
+        CORE_ASSERT( m_config.maxEntries > 0 );
+
+        m_allocator = m_config.allocator ? m_config.allocator : &core::memory::default_allocator();
+
+        m_time = 0.0;
+
+        m_entries = CORE_NEW_ARRAY( *m_allocator, Entry, m_config.maxEntries );
+
+        m_hosts = nullptr;
+        m_numHosts = 0;
+        if ( m_config.hostsFile )
+            LoadHostsFile( m_config.hostsFile );
+
+        m_shared = CORE_NEW( *m_allocator, Shared, *m_allocator );
+        core::queue::reserve( m_shared->pending, m_config.maxEntries );
+
+        uint32_t ringSize = 1;
+        while ( ringSize < (uint32_t) m_config.maxEntries )
+            ringSize <<= 1;
+
+        m_workers = CORE_NEW_ARRAY( *m_allocator, Worker, m_config.numThreads );
+        for ( int i = 0; i < m_config.numThreads; ++i )
+        {
+            m_workers[i].completions = (Request*) m_allocator->Allocate( sizeof( Request ) * ringSize, alignof( Request ) );
+            m_workers[i].mask = ringSize - 1;
+        }
+
+        // IMPORTANT: start threads only once everything they touch is set up
+
+        for ( int i = 0; i < m_config.numThreads; ++i )
+            m_workers[i].thread = std::thread( [this, i] { WorkerThread( i ); } );
+
+        memset( m_counters, 0, sizeof( m_counters ) );
     }
 
-    void DNSResolver::Resolve( const std::string & name )
+    DNSResolver::~DNSResolver()
     {
-        auto itor = map.find( name );
-        if ( itor != map.end() )
-            return;
+        // IMPORTANT: a worker blocked in getaddrinfo finishes its lookup before it can exit
+
+        {
+            std::lock_guard<std::mutex> lock( m_shared->mutex );
+            m_shared->quit = true;
+        }
+        m_shared->condition.notify_all();
 
-        auto entry = new ResolveEntry();
-        entry->status = RESOLVE_IN_PROGRESS;
-        const int ipv6 = m_ipv6;
-        entry->future = async( std::launch::async, [name, ipv6, entry] () -> ResolveResult
-        { 
-            return DNSResolve_Blocking( name, ipv6 );
-        } );
+        for ( int i = 0; i < m_config.numThreads; ++i )
+        {
+            m_workers[i].thread.join();
+            m_allocator->Free( m_workers[i].completions );
+        }
+
+        CORE_DELETE_ARRAY( *m_allocator, m_workers, m_config.numThreads );
 
-        map[name] = entry;
+        CORE_DELETE( *m_allocator, Shared, m_shared );
 
-        in_progress[name] = entry;
+        CORE_DELETE_ARRAY( *m_allocator, m_entries, m_config.maxEntries );
+
+        if ( m_hosts )
+            m_allocator->Free( m_hosts );
+
+        m_workers = nullptr;
+        m_shared = nullptr;
+        m_entries = nullptr;
+        m_hosts = nullptr;
     }
 
-    void DNSResolver::Update( const TimeBase & timeBase )
+    void DNSResolver::Resolve( const char * name )
     {
-        for ( auto itor = in_progress.begin(); itor != in_progress.end(); )
+        CORE_ASSERT( name );
+
+        const int length = strlen( name );
+        if ( length == 0 || length >= MaxResolveName )
+            return;
+
+        const uint64_t key = core::murmur_hash_64( name, length, 0 );
+
+        int index = FindEntry( name, key );
+        if ( index != -1 )
         {
-            auto name = itor->first;
-            auto entry = itor->second;
+            Entry & entry = m_entries[index];
 
-            if ( entry->future.wait_for( std::chrono::seconds(0) ) == std::future_status::ready )
+            if ( entry.entry.status == RESOLVE_IN_PROGRESS )
             {
-                entry->result = entry->future.get();
-                entry->status = entry->result.numAddresses ? RESOLVE_SUCCEEDED : RESOLVE_FAILED;
-                in_progress.erase( itor++ );
+                m_counters[DNS_RESOLVER_COUNTER_LOOKUPS_COALESCED]++;
+            }
+            else if ( m_time < entry.expireTime )
+            {
+                m_counters[DNS_RESOLVER_COUNTER_CACHE_HITS]++;
             }
             else
-                ++itor;
+            {
+                m_counters[DNS_RESOLVER_COUNTER_CACHE_EXPIRED]++;
+                StartLookup( index );
+            }
+
+            return;
+        }
+
+        index = AllocateEntry();
+        if ( index == -1 )
+        {
+            m_counters[DNS_RESOLVER_COUNTER_CACHE_FULL]++;
+            return;
+        }
+
+        Entry & entry = m_entries[index];
+        memcpy( entry.name, name, length + 1 );
+        entry.key = key;
+        entry.entry.result = ResolveResult();
+
+        core::multi_hash::insert( m_names, key, index );
+
+        StartLookup( index );
+    }
+
+    void DNSResolver::Update( const core::TimeBase & timeBase )
+    {
+        m_time = timeBase.time;
+
+        for ( int i = 0; i < m_config.numThreads; ++i )
+        {
+            Request request;
+            while ( m_workers[i].Pop( request ) )
+            {
+                CORE_ASSERT( request.index >= 0 );
+                CORE_ASSERT( request.index < m_config.maxEntries );
+
+                Entry & entry = m_entries[request.index];
+
+                CORE_ASSERT( entry.used );
+                CORE_ASSERT( entry.entry.status == RESOLVE_IN_PROGRESS );
+
+                if ( entry.orphaned )
+                {
+                    FreeEntry( request.index );
+                    continue;
+                }
+
+                entry.entry.result = request.result;
+
+                if ( request.result.numAddresses > 0 )
+                {
+                    entry.entry.status = RESOLVE_SUCCEEDED;
+                    entry.expireTime = m_time + m_config.cacheTime;
+                    m_counters[DNS_RESOLVER_COUNTER_LOOKUPS_SUCCEEDED]++;
+                }
+                else
+                {
+                    entry.entry.status = RESOLVE_FAILED;
+                    entry.expireTime = m_time + m_config.failedCacheTime;
+                    m_counters[DNS_RESOLVER_COUNTER_LOOKUPS_FAILED]++;
+                }
+            }
         }
     }
 
     void DNSResolver::Clear()
     {
-        map.clear();
+        core::hash::clear( m_names );
+
+        for ( int i = 0; i < m_config.maxEntries; ++i )
+        {
+            Entry & entry = m_entries[i];
+            if ( !entry.used )
+                continue;
+
+            if ( entry.entry.status == RESOLVE_IN_PROGRESS )
+                entry.orphaned = true;
+            else
+                entry = Entry();
+        }
     }
 
-    ResolveEntry * DNSResolver::GetEntry( const std::string & name )
+    const ResolveEntry * DNSResolver::GetEntry( const char * name ) const
     {
-        auto itor = map.find( name );
-        if ( itor != map.end() )
-            return itor->second;
-        else
-            return nullptr;
+        CORE_ASSERT( name );
+        const uint64_t key = core::murmur_hash_64( name, strlen( name ), 0 );
+        const int index = FindEntry( name, key );
+        return index != -1 ? &m_entries[index].entry : nullptr;
+    }
+
+    uint64_t DNSResolver::GetCounter( int index ) const
+    {
+        CORE_ASSERT( index >= 0 );
+        CORE_ASSERT( index < DNS_RESOLVER_COUNTER_NUM_COUNTERS );
+        return m_counters[index];
+    }
+
+    int DNSResolver::GetNumHosts() const
+    {
+        return m_numHosts;
+    }
+
+    int DNSResolver::FindEntry( const char * name, uint64_t key ) const
+    {
+        auto item = core::multi_hash::find_first( m_names, key );
+        while ( item )
+        {
+            const Entry & entry = m_entries[item->value];
+            if ( strcmp( entry.name, name ) == 0 )
+                return item->value;
+            item = core::multi_hash::find_next( m_names, item );
+        }
+        return -1;
+    }
+
+    int DNSResolver::AllocateEntry()
+    {
+        // take a free entry, otherwise evict the completed entry closest to expiring
+
+        int evictIndex = -1;
+
+        for ( int i = 0; i < m_config.maxEntries; ++i )
+        {
+            const Entry & entry = m_entries[i];
+
+            if ( !entry.used )
+            {
+                m_entries[i].used = true;
+                return i;
+            }
+
+            if ( entry.orphaned || entry.entry.status == RESOLVE_IN_PROGRESS )
+                continue;
+
+            if ( evictIndex == -1 || entry.expireTime < m_entries[evictIndex].expireTime )
+                evictIndex = i;
+        }
+
+        if ( evictIndex == -1 )
+            return -1;
+
+        m_counters[DNS_RESOLVER_COUNTER_CACHE_EVICTIONS]++;
+
+        FreeEntry( evictIndex );
+
+        m_entries[evictIndex].used = true;
+
+        return evictIndex;
+    }
+
+    void DNSResolver::FreeEntry( int index )
+    {
+        Entry & entry = m_entries[index];
+
+        CORE_ASSERT( entry.used );
+
+        if ( !entry.orphaned )
+        {
+            auto item = core::multi_hash::find_first( m_names, entry.key );
+            while ( item )
+            {
+                if ( item->value == index )
+                {
+                    core::multi_hash::remove( m_names, item );
+                    break;
+                }
+                item = core::multi_hash::find_next( m_names, item );
+            }
+        }
+
+        entry = Entry();
+    }
+
+    void DNSResolver::StartLookup( int index )
+    {
+        m_entries[index].entry.status = RESOLVE_IN_PROGRESS;
+
+        {
+            std::lock_guard<std::mutex> lock( m_shared->mutex );
+            core::queue::push_back( m_shared->pending, index );
+        }
+
+        m_shared->condition.notify_one();
+
+        m_counters[DNS_RESOLVER_COUNTER_LOOKUPS_STARTED]++;
+    }
+
+    void DNSResolver::LoadHostsFile( const char * filename )
+    {
+        FILE * file = fopen( filename, "r" );
+        if ( !file )
+        {
+            printf( "error: failed to open hosts file %s\n", filename );
+            return;
+        }
+
+        // two passes: count the names, then fill them in
+
+        for ( int pass = 0; pass < 2; ++pass )
+        {
+            int numHosts = 0;
+
+            char line[1024];
+            while ( fgets( line, sizeof( line ), file ) )
+            {
+                char * comment = strchr( line, '#' );
+                if ( comment )
+                    *comment = '\0';
+
+                char * token = strtok( line, " \t\r\n" );
+                if ( !token )
+                    continue;
+
+                Address address( token );
+                if ( !address.IsValid() )
+                    continue;
+
+                while ( ( token = strtok( nullptr, " \t\r\n" ) ) != nullptr )
+                {
+                    if ( strlen( token ) >= (size_t) MaxResolveName )
+                        continue;
+
+                    if ( pass == 1 )
+                    {
+                        HostsEntry & host = m_hosts[numHosts];
+                        strcpy( host.name, token );
+                        host.address = address;
+                    }
+
+                    numHosts++;
+                }
+            }
+
+            if ( pass == 0 )
+            {
+                if ( numHosts == 0 )
+                    break;
+                m_hosts = (HostsEntry*) m_allocator->Allocate( sizeof( HostsEntry ) * numHosts, alignof( HostsEntry ) );
+                for ( int i = 0; i < numHosts; ++i )
+                    new ( &m_hosts[i] ) HostsEntry();
+                rewind( file );
+            }
+
+            m_numHosts = numHosts;
+        }
+
+        fclose( file );
+    }
+
+    void DNSResolver::WorkerThread( int workerIndex )
+    {
+        Worker & worker = m_workers[workerIndex];
+
+        while ( true )
+        {
+            Request request;
+
+            {
+                std::unique_lock<std::mutex> lock( m_shared->mutex );
+                m_shared->condition.wait( lock, [this] { return m_shared->quit || core::queue::size( m_shared->pending ) > 0; } );
+                if ( m_shared->quit )
+                    return;
+                request.index = m_shared->pending[0];
+                core::queue::pop_front( m_shared->pending );
+            }
+
+            // IMPORTANT: the entry name is not modified while its lookup is in flight
+
+            request.result = Lookup( m_entries[request.index].name );
+
+            worker.Push( request );
+        }
+    }
+
+    ResolveResult DNSResolver::Lookup( const char * name ) const
+    {
+        char hostname[MaxResolveName];
+        const uint16_t port = split_port( name, hostname, sizeof( hostname ) );
+
+        const AddressType type = m_config.ipv6 ? ADDRESS_IPV6 : ADDRESS_IPV4;
+
+        ResolveResult result;
+        for ( int i = 0; i < m_numHosts && result.numAddresses < MaxResolveAddresses; ++i )
+        {
+            if ( m_hosts[i].address.GetType() != type || !hostname_equal( m_hosts[i].name, hostname ) )
+                continue;
+            Address address = m_hosts[i].address;
+            if ( port != 0 )
+                address.SetPort( port );
+            result.address[result.numAddresses++] = address;
+        }
+
+        if ( result.numAddresses == 0 && m_config.useSystemResolver )
+            result = DNSResolve_Blocking( name, m_config.ipv6 );
+
+        return result;
     }
 }
 
 #else
 
-// workaround for "lib/libprotocol.a(DNSResolver.o) has no symbols" when resolver is disabled
-namespace protocol { int resolve_dummy() { return 1; } }
+// workaround for "lib/libnetwork.a(DNSResolver.o) has no symbols" when resolver is disabled
+namespace network { int resolve_dummy() { return 1; } }
 
 #endif
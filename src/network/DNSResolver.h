@@ -8,36 +8,104 @@
 #if NETWORK_USE_RESOLVER
 
 #include "network/Resolver.h"
+#include "core/Types.h"
 
-struct addrinfo;
+namespace core { class Allocator; }
 
 namespace network
 {
-    ResolveResult DNSResolve_Blocking( std::string name, bool ipv6 );
+    // blocking lookup with getaddrinfo. never call this on the game thread!
 
-    typedef std::map<std::string,ResolveEntry*> ResolveMap;
+    ResolveResult DNSResolve_Blocking( const char * name, bool ipv6 );
+
+    struct DNSResolverConfig
+    {
+        core::Allocator * allocator = nullptr;          // allocator used for allocations that match the life cycle of this object. if null then default allocator is used.
+        bool ipv6 = true;                               // resolve to ipv6 addresses if true, ipv4 otherwise.
+        int numThreads = 2;                             // number of worker threads doing blocking lookups.
+        int maxEntries = 256;                           // maximum number of names cached or in flight. when full, the completed entry closest to expiring is evicted. entries still in flight are never evicted, so if all are in flight the lookup is dropped.
+        double cacheTime = 60.0;                        // seconds a successful lookup stays cached.
+        double failedCacheTime = 5.0;                   // seconds a failed lookup stays cached, so a bad name is not looked up again every frame.
+        const char * hostsFile = nullptr;               // optional hosts file ("address name [aliases]" per line). names found here never hit DNS.
+        bool useSystemResolver = true;                  // if false, names not in the hosts file fail. lets tests run offline.
+    };
+
+    /*
+        Resolver backed by a small pool of worker threads.
+
+        Identical names are coalesced into one lookup and results are cached
+        until their TTL expires. Completed lookups come back to the game
+        thread through per-worker lock free queues and are applied in Update,
+        so Resolve, Update and GetEntry never block on getaddrinfo.
+
+        Expired entries keep their last result until resolved again.
+    */
 
     class DNSResolver : public Resolver
     {
     public:
 
-        DNSResolver( bool ipv6 = true );
+        DNSResolver( const DNSResolverConfig & config = DNSResolverConfig() );
 
         ~DNSResolver();
 
-        void Resolve( const std::string & name );
+        void Resolve( const char * name );
+
+        void Update( const core::TimeBase & timeBase );
+
+        void Clear();
+
+        const ResolveEntry * GetEntry( const char * name ) const;
+
+        uint64_t GetCounter( int index ) const;
+
+        int GetNumHosts() const;
+
+    protected:
+
+        struct Entry;
+        struct Worker;
+        struct HostsEntry;
+        struct Request;
 
-        virtual void Update( const TimeBase & timeBase );
+        int FindEntry( const char * name, uint64_t key ) const;
 
-        virtual void Clear();
+        int AllocateEntry();
 
-        virtual ResolveEntry * GetEntry( const std::string & name );
+        void FreeEntry( int index );
+
+        void StartLookup( int index );
+
+        void LoadHostsFile( const char * filename );
+
+        void WorkerThread( int workerIndex );
+
+        ResolveResult Lookup( const char * name ) const;
 
     private:
 
-        bool m_ipv6;
-        ResolveMap map;
-        ResolveMap in_progress;
+        const DNSResolverConfig m_config;
+
+        core::Allocator * m_allocator;
+
+        double m_time;
+
+        Entry * m_entries;
+
+        core::Hash<int> m_names;
+
+        HostsEntry * m_hosts;
+        int m_numHosts;
+
+        Worker * m_workers;
+
+        struct Shared;
+        Shared * m_shared;
+
+        uint64_t m_counters[DNS_RESOLVER_COUNTER_NUM_COUNTERS];
+
+        DNSResolver( const DNSResolver & other );
+        DNSResolver & operator = ( const DNSResolver & other );
     };
 }
 
@@ -35,8 +35,39 @@ namespace network
         BSD_SOCKET_COUNTER_CREATE_PACKET_FAILURES,
         BSD_SOCKET_COUNTER_PROTOCOL_ID_MISMATCH,
         BSD_SOCKET_COUNTER_ABORTED_PACKET_READS,
+        BSD_SOCKET_COUNTER_PACKETS_COALESCED,
+        BSD_SOCKET_COUNTER_PACKETS_COMPRESSED,
+        BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES,
+        BSD_SOCKET_COUNTER_BYTES_BEFORE_COMPRESSION,
+        BSD_SOCKET_COUNTER_BYTES_AFTER_COMPRESSION,
         BSD_SOCKET_COUNTER_NUM_COUNTERS
     };
+
+    enum LoopbackCounter
+    {
+        LOOPBACK_COUNTER_PACKETS_SENT,
+        LOOPBACK_COUNTER_PACKETS_RECEIVED,
+        LOOPBACK_COUNTER_NO_ENDPOINT,
+        LOOPBACK_COUNTER_RECEIVE_QUEUE_FULL,
+        LOOPBACK_COUNTER_SERIALIZE_WRITE_OVERFLOW,
+        LOOPBACK_COUNTER_SERIALIZE_READ_FAILURES,
+        LOOPBACK_COUNTER_CREATE_PACKET_FAILURES,
+        LOOPBACK_COUNTER_ABORTED_PACKET_READS,
+        LOOPBACK_COUNTER_NUM_COUNTERS
+    };
+
+    enum DNSResolverCounter
+    {
+        DNS_RESOLVER_COUNTER_LOOKUPS_STARTED,
+        DNS_RESOLVER_COUNTER_LOOKUPS_COALESCED,
+        DNS_RESOLVER_COUNTER_LOOKUPS_SUCCEEDED,
+        DNS_RESOLVER_COUNTER_LOOKUPS_FAILED,
+        DNS_RESOLVER_COUNTER_CACHE_HITS,
+        DNS_RESOLVER_COUNTER_CACHE_EXPIRED,
+        DNS_RESOLVER_COUNTER_CACHE_EVICTIONS,
+        DNS_RESOLVER_COUNTER_CACHE_FULL,
+        DNS_RESOLVER_COUNTER_NUM_COUNTERS
+    };
 }
 
 #endif
@@ -0,0 +1,306 @@
+// Network Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#include "network/Loopback.h"
+#include "core/Memory.h"
+#include "core/Queue.h"
+#include "core/Hash.h"
+#include <string.h>
+
+namespace network
+{
+    LoopbackNetwork::LoopbackNetwork( core::Allocator & allocator, int maxPacketSize )
+        : m_interfaces( allocator ), m_buffers( allocator ), m_freeBuffers( allocator )
+    {
+        CORE_ASSERT( maxPacketSize > 0 );
+
+        m_allocator = &allocator;
+        m_maxPacketSize = maxPacketSize;
+        m_bufferSize = ( maxPacketSize + 3 ) & ~3;          // write stream requires a multiple of four bytes
+        m_numInterfaces = 0;
+    }
+
+    LoopbackNetwork::~LoopbackNetwork()
+    {
+        CORE_ASSERT( m_numInterfaces == 0 );                // IMPORTANT: destroy interfaces before the network!
+
+        CORE_ASSERT( core::array::size( m_freeBuffers ) == core::array::size( m_buffers ) );
+
+        for ( int i = 0; i < (int) core::array::size( m_buffers ); ++i )
+            m_allocator->Free( m_buffers[i] );
+
+        core::array::clear( m_buffers );
+        core::array::clear( m_freeBuffers );
+    }
+
+    LoopbackInterface * LoopbackNetwork::FindInterface( const Address & address ) const
+    {
+        auto entry = core::multi_hash::find_first( m_interfaces, address.Hash() );
+        while ( entry )
+        {
+            if ( entry->value->GetAddress() == address )
+                return entry->value;
+            entry = core::multi_hash::find_next( m_interfaces, entry );
+        }
+        return nullptr;
+    }
+
+    int LoopbackNetwork::GetNumBuffers() const
+    {
+        return core::array::size( m_buffers );
+    }
+
+    void LoopbackNetwork::AddInterface( LoopbackInterface * loopbackInterface )
+    {
+        CORE_ASSERT( loopbackInterface );
+        CORE_ASSERT( loopbackInterface->GetAddress().IsValid() );
+        CORE_ASSERT( FindInterface( loopbackInterface->GetAddress() ) == nullptr );      // IMPORTANT: each interface needs its own address
+
+        core::multi_hash::insert( m_interfaces, loopbackInterface->GetAddress().Hash(), loopbackInterface );
+
+        m_numInterfaces++;
+    }
+
+    void LoopbackNetwork::RemoveInterface( LoopbackInterface * loopbackInterface )
+    {
+        CORE_ASSERT( loopbackInterface );
+
+        auto entry = core::multi_hash::find_first( m_interfaces, loopbackInterface->GetAddress().Hash() );
+        while ( entry )
+        {
+            if ( entry->value == loopbackInterface )
+            {
+                core::multi_hash::remove( m_interfaces, entry );
+                m_numInterfaces--;
+                return;
+            }
+            entry = core::multi_hash::find_next( m_interfaces, entry );
+        }
+
+        CORE_ASSERT( !"loopback interface not found" );
+    }
+
+    uint8_t * LoopbackNetwork::AllocateBuffer()
+    {
+        if ( core::array::any( m_freeBuffers ) )
+        {
+            uint8_t * buffer = core::array::back( m_freeBuffers );
+            core::array::pop_back( m_freeBuffers );
+            return buffer;
+        }
+
+        uint8_t * buffer = (uint8_t*) m_allocator->Allocate( m_bufferSize );
+        core::array::push_back( m_buffers, buffer );
+        return buffer;
+    }
+
+    void LoopbackNetwork::FreeBuffer( uint8_t * buffer )
+    {
+        CORE_ASSERT( buffer );
+        core::array::push_back( m_freeBuffers, buffer );
+    }
+
+    LoopbackInterface::LoopbackInterface( const LoopbackConfig & config )
+        : m_config( config ),
+          m_receive_queue( config.allocator ? *config.allocator : core::memory::default_allocator() )
+    {
+        CORE_ASSERT( m_config.network );
+        CORE_ASSERT( m_config.packetFactory );
+        CORE_ASSERT( m_config.receiveQueueSize > 0 );
+
+        m_allocator = m_config.allocator ? m_config.allocator : &core::memory::default_allocator();
+
+        m_context = nullptr;
+
+        memset( m_counters, 0, sizeof( m_counters ) );
+
+        core::queue::reserve( m_receive_queue, m_config.receiveQueueSize );
+
+        m_config.network->AddInterface( this );
+    }
+
+    LoopbackInterface::~LoopbackInterface()
+    {
+        m_config.network->RemoveInterface( this );
+
+        for ( int i = 0; i < (int) core::queue::size( m_receive_queue ); ++i )
+        {
+            const PacketEntry & entry = m_receive_queue[i];
+            if ( entry.packet )
+                m_config.packetFactory->Destroy( entry.packet );
+            if ( entry.buffer )
+                m_config.network->FreeBuffer( entry.buffer );
+        }
+
+        core::queue::clear( m_receive_queue );
+    }
+
+    void LoopbackInterface::SendPacket( const Address & address, protocol::Packet * packet )
+    {
+        CORE_ASSERT( packet );
+        CORE_ASSERT( address.IsValid() );
+
+        LoopbackInterface * destination = m_config.network->FindInterface( address );
+
+        if ( !destination )
+        {
+            m_counters[LOOPBACK_COUNTER_NO_ENDPOINT]++;
+            m_config.packetFactory->Destroy( packet );
+            return;
+        }
+
+        PacketEntry entry;
+        entry.from = m_config.address;
+        entry.packet = nullptr;
+        entry.buffer = nullptr;
+        entry.packetType = packet->GetType();
+
+        if ( m_config.serializePackets )
+        {
+            // serialize once with the sender's context. the receiver reads it back with its own context.
+
+            entry.buffer = m_config.network->AllocateBuffer();
+
+            typedef protocol::WriteStream Stream;
+
+            Stream stream( entry.buffer, m_config.network->m_bufferSize );
+
+            stream.SetContext( m_context );
+
+            packet->SerializeWrite( stream );
+
+            stream.Check( 0x51246234 );
+
+            stream.Flush();
+
+            m_config.packetFactory->Destroy( packet );
+
+            if ( stream.IsOverflow() || stream.GetBytesProcessed() > m_config.network->GetMaxPacketSize() )
+            {
+                m_counters[LOOPBACK_COUNTER_SERIALIZE_WRITE_OVERFLOW]++;
+                m_config.network->FreeBuffer( entry.buffer );
+                return;
+            }
+        }
+        else
+        {
+            CORE_ASSERT( &destination->GetPacketFactory() == m_config.packetFactory );      // IMPORTANT: passing packets through requires a shared packet factory
+
+            entry.packet = packet;
+        }
+
+        m_counters[LOOPBACK_COUNTER_PACKETS_SENT]++;
+
+        destination->Deliver( entry );
+    }
+
+    void LoopbackInterface::Deliver( const PacketEntry & entry )
+    {
+        if ( core::queue::size( m_receive_queue ) == (uint32_t) m_config.receiveQueueSize )
+        {
+            m_counters[LOOPBACK_COUNTER_RECEIVE_QUEUE_FULL]++;
+            if ( entry.packet )
+                m_config.packetFactory->Destroy( entry.packet );
+            if ( entry.buffer )
+                m_config.network->FreeBuffer( entry.buffer );
+            return;
+        }
+
+        core::queue::push_back( m_receive_queue, entry );
+    }
+
+    protocol::Packet * LoopbackInterface::ReceivePacket()
+    {
+        while ( core::queue::size( m_receive_queue ) )
+        {
+            const PacketEntry entry = m_receive_queue[0];
+
+            core::queue::pop_front( m_receive_queue );
+
+            protocol::Packet * packet = entry.packet;
+
+            if ( entry.buffer )
+            {
+                packet = ReadPacket( entry );
+                m_config.network->FreeBuffer( entry.buffer );
+            }
+
+            if ( !packet )
+                continue;
+
+            packet->SetAddress( entry.from );
+
+            m_counters[LOOPBACK_COUNTER_PACKETS_RECEIVED]++;
+
+            return packet;
+        }
+
+        return nullptr;
+    }
+
+    protocol::Packet * LoopbackInterface::ReadPacket( const PacketEntry & entry )
+    {
+        protocol::Packet * packet = m_config.packetFactory->Create( entry.packetType );
+
+        if ( !packet )
+        {
+            m_counters[LOOPBACK_COUNTER_CREATE_PACKET_FAILURES]++;
+            return nullptr;
+        }
+
+        typedef protocol::ReadStream Stream;
+
+        Stream stream( entry.buffer, m_config.network->m_bufferSize );
+
+        stream.SetContext( m_context );
+
+        packet->SerializeRead( stream );
+
+        // IMPORTANT: packet read was aborted. intentionally ignore this packet
+        if ( stream.Aborted() )
+        {
+            m_counters[LOOPBACK_COUNTER_ABORTED_PACKET_READS]++;
+            m_config.packetFactory->Destroy( packet );
+            return nullptr;
+        }
+
+        // verify the read ended exactly where the write did
+
+        CORE_ASSERT( !stream.IsOverflow() );
+
+        if ( stream.IsOverflow() || !stream.Check( 0x51246234 ) )
+        {
+            m_counters[LOOPBACK_COUNTER_SERIALIZE_READ_FAILURES]++;
+            m_config.packetFactory->Destroy( packet );
+            return nullptr;
+        }
+
+        return packet;
+    }
+
+    void LoopbackInterface::Update( const core::TimeBase & timeBase )
+    {
+        // ...
+    }
+
+    uint32_t LoopbackInterface::GetMaxPacketSize() const
+    {
+        return m_config.network->GetMaxPacketSize();
+    }
+
+    protocol::PacketFactory & LoopbackInterface::GetPacketFactory() const
+    {
+        return *m_config.packetFactory;
+    }
+
+    void LoopbackInterface::SetContext( const void ** context )
+    {
+        m_context = context;
+    }
+
+    uint64_t LoopbackInterface::GetCounter( int index ) const
+    {
+        CORE_ASSERT( index >= 0 );
+        CORE_ASSERT( index < LOOPBACK_COUNTER_NUM_COUNTERS );
+        return m_counters[index];
+    }
+}
@@ -0,0 +1,145 @@
+// Network Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#ifndef NETWORK_LOOPBACK_H
+#define NETWORK_LOOPBACK_H
+
+#include "core/Types.h"
+#include "network/Interface.h"
+#include "protocol/PacketFactory.h"
+
+namespace core { class Allocator; }
+
+namespace network
+{
+    class LoopbackInterface;
+
+    /*
+        In-process network that routes packets between loopback interfaces by address.
+
+        Use it to run many clients and servers in one process without sockets.
+        Every interface on the network must agree on maxPacketSize.
+
+        The network owns a pool of packet buffers shared by all interfaces,
+        so serializing packets does not allocate once the pool is warm.
+    */
+
+    class LoopbackNetwork
+    {
+    public:
+
+        LoopbackNetwork( core::Allocator & allocator, int maxPacketSize );
+
+        ~LoopbackNetwork();
+
+        LoopbackInterface * FindInterface( const Address & address ) const;
+
+        int GetMaxPacketSize() const { return m_maxPacketSize; }
+
+        int GetNumInterfaces() const { return m_numInterfaces; }
+
+        int GetNumBuffers() const;
+
+    protected:
+
+        friend class LoopbackInterface;
+
+        void AddInterface( LoopbackInterface * loopbackInterface );
+
+        void RemoveInterface( LoopbackInterface * loopbackInterface );
+
+        uint8_t * AllocateBuffer();
+
+        void FreeBuffer( uint8_t * buffer );
+
+    private:
+
+        core::Allocator * m_allocator;
+
+        int m_maxPacketSize;
+        int m_bufferSize;
+        int m_numInterfaces;
+
+        core::Hash<LoopbackInterface*> m_interfaces;
+
+        core::Array<uint8_t*> m_buffers;
+        core::Array<uint8_t*> m_freeBuffers;
+
+        LoopbackNetwork( const LoopbackNetwork & other );
+        LoopbackNetwork & operator = ( const LoopbackNetwork & other );
+    };
+
+    struct LoopbackConfig
+    {
+        LoopbackConfig()
+        {
+            network = nullptr;
+            allocator = nullptr;
+            receiveQueueSize = 256;
+            serializePackets = true;
+            packetFactory = nullptr;
+        }
+
+        LoopbackNetwork * network;                  // the network to attach to (required)
+        Address address;                            // address of this interface. packets sent to this address are received here
+        core::Allocator * allocator;                // allocator for long term allocations matching object life cycle. if nullptr then the default allocator is used.
+        int receiveQueueSize;                       // packets received and not yet dequeued with ReceivePacket. additional packets are dropped.
+        bool serializePackets;                      // if true, packets are written once on send and read back with the receiver's context, verifying the wire format. if false, packet pointers are passed through and all interfaces must share one packet factory.
+        protocol::PacketFactory * packetFactory;    // packet factory (required)
+    };
+
+    class LoopbackInterface : public Interface
+    {
+    public:
+
+        LoopbackInterface( const LoopbackConfig & config );
+
+        ~LoopbackInterface();
+
+        void SendPacket( const Address & address, protocol::Packet * packet );
+
+        protocol::Packet * ReceivePacket();
+
+        void Update( const core::TimeBase & timeBase );
+
+        uint32_t GetMaxPacketSize() const;
+
+        protocol::PacketFactory & GetPacketFactory() const;
+
+        void SetContext( const void ** context );
+
+        const Address & GetAddress() const { return m_config.address; }
+
+        uint64_t GetCounter( int index ) const;
+
+    protected:
+
+        struct PacketEntry
+        {
+            Address from;
+            protocol::Packet * packet;
+            uint8_t * buffer;
+            int packetType;
+        };
+
+        void Deliver( const PacketEntry & entry );
+
+        protocol::Packet * ReadPacket( const PacketEntry & entry );
+
+    private:
+
+        const LoopbackConfig m_config;
+
+        core::Allocator * m_allocator;
+
+        const void ** m_context;
+
+        core::Queue<PacketEntry> m_receive_queue;
+
+        uint64_t m_counters[LOOPBACK_COUNTER_NUM_COUNTERS];
+
+        LoopbackInterface( const LoopbackInterface & other );
+        LoopbackInterface & operator = ( const LoopbackInterface & other );
+    };
+}
+
+#endif
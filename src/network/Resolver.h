@@ -9,8 +9,7 @@
 
 #include "core/Core.h"
 #include "network/Address.h"
-#include <future>
-#include <string>
+#include "network/Constants.h"
 
 namespace network
 {
@@ -29,22 +28,31 @@ namespace network
 
     struct ResolveEntry
     {
-        ResolveStatus status;
+        ResolveStatus status = RESOLVE_IN_PROGRESS;
         ResolveResult result;
-        std::future<ResolveResult> future;
     };
 
+    /*
+        Resolves hostnames to addresses without blocking the caller.
+
+        Call Resolve to start a lookup, then poll GetEntry after each Update
+        until the status is no longer in progress. Names may carry a port
+        suffix, eg. "example.com:40000", which is applied to every address.
+    */
+
     class Resolver
     {
     public:
 
-        virtual void Resolve( const std::string & name ) = 0;
+        virtual ~Resolver() {}
+
+        virtual void Resolve( const char * name ) = 0;
 
-        virtual void Update( const TimeBase & timeBase ) = 0;
+        virtual void Update( const core::TimeBase & timeBase ) = 0;
 
         virtual void Clear() = 0;
 
-        virtual ResolveEntry * GetEntry( const std::string & name ) = 0;
+        virtual const ResolveEntry * GetEntry( const char * name ) const = 0;
     };
 }
 
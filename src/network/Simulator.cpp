@@ -1,13 +1,15 @@
 // Network Library - Copyright (c) 2008-2015, Glenn Fiedler
 
 #include "network/Simulator.h"
+#include "network/Compressor.h"
 #include "core/Memory.h"
 #include "protocol/PacketFactory.h"
+#include <math.h>
 
 namespace network
 {
     Simulator::Simulator( const SimulatorConfig & config ) 
-        : m_config( config ), m_bandwidthSlidingWindow( *config.allocator, config.bandwidthSize )
+        : m_config( config ), m_trace( *config.allocator ), m_bandwidthSlidingWindow( *config.allocator, config.bandwidthSize )
     {
         CORE_ASSERT( m_config.allocator );
         CORE_ASSERT( m_config.numPackets > 0 );
@@ -15,6 +17,12 @@ namespace network
 
         m_packets = CORE_NEW_ARRAY( *m_config.allocator, PacketData, config.numPackets );
 
+        m_heap = (int*) m_config.allocator->Allocate( sizeof( int ) * config.numPackets );
+        m_heapPosition = (int*) m_config.allocator->Allocate( sizeof( int ) * config.numPackets );
+        m_heapSize = 0;
+        for ( int i = 0; i < config.numPackets; ++i )
+            m_heapPosition[i] = -1;
+
         m_packetNumberSend = 0;
         m_packetNumberReceive = 0;
 
@@ -22,9 +30,22 @@ namespace network
         m_bandwidthExclude = false;
 
         m_bandwidth = 0.0f;
+        m_compressedBandwidth = 0.0f;
+
+        m_compressor = nullptr;
+        if ( m_config.compressPackets )
+            m_compressor = CORE_NEW( *m_config.allocator, Compressor, *m_config.allocator, m_config.compressionDictionary, m_config.compressionDictionarySize );
 
         m_numStates = 0;
 
+        m_burst = false;
+        m_linkTime = 0.0;
+        m_averageQueueBytes = 0.0;
+        m_queueDelay = 0.0f;
+        m_numQueueDrops = 0;
+
+        m_traceStartTime = -1.0;
+
         m_context = nullptr;
     }
 
@@ -38,6 +59,18 @@ namespace network
         CORE_DELETE_ARRAY( *m_config.allocator, m_packets, m_config.numPackets );
 
         m_packets = nullptr;
+
+        m_config.allocator->Free( m_heap );
+        m_config.allocator->Free( m_heapPosition );
+
+        m_heap = nullptr;
+        m_heapPosition = nullptr;
+
+        if ( m_compressor )
+        {
+            CORE_DELETE( *m_config.allocator, Compressor, m_compressor );
+            m_compressor = nullptr;
+        }
     }
 
     void Simulator::Reset()
@@ -54,12 +87,24 @@ namespace network
                 m_config.packetFactory->Destroy( m_packets[i].packet );
                 m_packets[i].packet = nullptr;
             }
+            m_heapPosition[i] = -1;
         }
+
+        m_heapSize = 0;
+
+        m_burst = false;
+        m_linkTime = 0.0;
+        m_averageQueueBytes = 0.0;
+        m_queueDelay = 0.0f;
+        m_numQueueDrops = 0;
+
+        m_traceStartTime = -1.0;
     }
 
     int Simulator::AddState( const SimulatorState & state )
     {
         CORE_ASSERT( m_numStates < MaxSimulatorStates - 1 );
+        CORE_ASSERT( state.duplicateChance == 0.0f || m_config.serializePackets );     // duplicates are made by reading the serialized packet twice
         const int index = m_numStates;
         m_states[m_numStates++] = state;
         if ( m_numStates == 1 )
@@ -73,21 +118,98 @@ namespace network
         m_numStates = 0;
     }
 
+    bool Simulator::LoadTrace( const char * filename )
+    {
+        CORE_ASSERT( filename );
+
+        ClearTrace();
+
+        FILE * file = fopen( filename, "r" );
+        if ( !file )
+        {
+            printf( "failed to open simulator trace file: %s\n", filename );
+            return false;
+        }
+
+        char line[256];
+        int lineNumber = 0;
+
+        while ( fgets( line, sizeof( line ), file ) )
+        {
+            lineNumber++;
+
+            const char * p = line;
+            while ( *p == ' ' || *p == '\t' )
+                p++;
+
+            if ( *p == '#' || *p == '\n' || *p == '\r' || *p == '\0' )
+                continue;
+
+            SimulatorTraceEntry entry;
+            if ( sscanf( p, "%lf %f %f %f", &entry.time, &entry.latency, &entry.jitter, &entry.packetLoss ) != 4 ||
+                 ( core::array::any( m_trace ) && entry.time < core::array::back( m_trace ).time ) )
+            {
+                printf( "bad simulator trace entry: %s:%d\n", filename, lineNumber );
+                fclose( file );
+                ClearTrace();
+                return false;
+            }
+
+            core::array::push_back( m_trace, entry );
+        }
+
+        fclose( file );
+
+        if ( core::array::empty( m_trace ) )
+        {
+            printf( "simulator trace file is empty: %s\n", filename );
+            return false;
+        }
+
+        return true;
+    }
+
+    void Simulator::ClearTrace()
+    {
+        core::array::clear( m_trace );
+        m_traceStartTime = -1.0;
+    }
+
     void Simulator::SendPacket( const Address & address, protocol::Packet * packet )
     {
         CORE_ASSERT( packet );
 
-        const int index = m_packetNumberSend % m_config.numPackets;
+        // Gilbert-Elliott loss. Bursts of heavy loss (bad state) interrupt light random loss (good state).
+
+        if ( m_burst )
+        {
+            if ( core::random_float( 0.0f, 100.0f ) < m_state.burstEndChance )
+                m_burst = false;
+        }
+        else
+        {
+            if ( core::random_float( 0.0f, 100.0f ) < m_state.burstChance )
+                m_burst = true;
+        }
 
-        const bool loss = core::random_float( 0.0f, 100.0f ) <= m_state.packetLoss;
+        const float packetLoss = m_burst ? m_state.burstPacketLoss : m_state.packetLoss;
+
+        const bool loss = core::random_float( 0.0f, 100.0f ) <= packetLoss;
 
         const float jitter = core::random_float( -m_state.jitter, +m_state.jitter );
 
+        int packetSize = 0;
+
+        protocol::Packet * duplicate = nullptr;
+
         if ( m_config.serializePackets )
         {
+            const bool duplicated = !m_tcpMode && !loss && core::random_float( 0.0f, 100.0f ) < m_state.duplicateChance;
+
             BandwidthEntry entry;
             entry.time = m_timeBase.time;
-            packet = SerializePacket( packet, entry.packetSize );
+            packet = SerializePacket( packet, entry.packetSize, entry.compressedPacketSize, duplicated ? &duplicate : nullptr );
+            packetSize = entry.packetSize;
             if ( !m_bandwidthExclude )
             {
                 if ( m_bandwidthSlidingWindow.IsFull() )
@@ -95,6 +217,10 @@ namespace network
                 m_bandwidthSlidingWindow.Insert( entry );
             }
         }
+        else if ( m_state.bandwidth > 0.0f && !m_bandwidthExclude )
+        {
+            packetSize = MeasurePacket( packet );
+        }
 
         if ( m_tcpMode )
         {
@@ -102,7 +228,12 @@ namespace network
             // by only dequeing the next expected packet and blocking until it is ready.
             // RTT * 2 latency is added to "lost" packets to simulate TCP retransmit.
 
-            const float delay = m_state.latency + jitter + ( loss ? ( 4.0f * m_state.latency ) : 0.0f );
+            float queueDelay;
+            EnqueueLink( packetSize, queueDelay );
+
+            const float delay = queueDelay + m_state.latency + jitter + ( loss ? ( 4.0f * m_state.latency ) : 0.0f );
+
+            const int index = m_packetNumberSend % m_config.numPackets;
 
             CORE_ASSERT( m_packets[index].packet == nullptr );      // In TCP mode we cannot drop any packets!
 
@@ -118,34 +249,115 @@ namespace network
         {
             // UDP mode. drop packets on send. randomly delay time of packet delivery to simulate latency and jitter.
 
-            if ( loss )
+            float queueDelay;
+
+            if ( loss || !EnqueueLink( packetSize, queueDelay ) )
             {
                 m_config.packetFactory->Destroy( packet );
+                if ( duplicate )
+                    m_config.packetFactory->Destroy( duplicate );
                 return;
             }
 
-            if ( m_packets[index].packet )
+            const bool reorder = core::random_float( 0.0f, 100.0f ) < m_state.reorderChance;
+
+            QueuePacket( address, packet, queueDelay + m_state.latency + jitter + ( reorder ? m_state.reorderDelay : 0.0f ) );
+
+            if ( duplicate )
+                QueuePacket( address, duplicate, queueDelay + m_state.latency + core::random_float( -m_state.jitter, +m_state.jitter ) );
+        }
+    }
+
+    int Simulator::MeasurePacket( protocol::Packet * packet )
+    {
+        protocol::MeasureStream stream( m_config.maxPacketSize );
+
+        stream.SetContext( m_context );
+
+        packet->SerializeMeasure( stream );
+
+        return stream.GetBytesProcessed() + m_config.packetHeaderSize;
+    }
+
+    bool Simulator::EnqueueLink( int packetSize, float & queueDelay )
+    {
+        // packets go out over the bottleneck link one after another at the link rate. the queue
+        // delay is the time spent waiting behind earlier packets plus the time to send this one.
+        // returns false if the packet is dropped because the queue is full (UDP mode only).
+
+        queueDelay = 0.0f;
+
+        if ( m_state.bandwidth <= 0.0f || m_bandwidthExclude )
+            return true;
+
+        const double bytesPerSecond = m_state.bandwidth * 1000.0 / 8.0;
+
+        if ( m_config.queueSize > 0 && !m_tcpMode )
+        {
+            const double queueBytes = core::max( m_linkTime - m_timeBase.time, 0.0 ) * bytesPerSecond;
+
+            m_averageQueueBytes += ( queueBytes - m_averageQueueBytes ) * m_config.redWeight;
+
+            bool drop = queueBytes + packetSize > m_config.queueSize;
+
+            if ( !drop && m_config.queueMode == SIMULATOR_QUEUE_RED )
             {
-                m_config.packetFactory->Destroy( m_packets[index].packet );
-                m_packets[index].packet = nullptr;
+                const double minThreshold = m_config.redMinThreshold * m_config.queueSize;
+                const double maxThreshold = m_config.redMaxThreshold * m_config.queueSize;
+
+                if ( m_averageQueueBytes >= maxThreshold )
+                {
+                    drop = true;
+                }
+                else if ( m_averageQueueBytes > minThreshold )
+                {
+                    const double dropChance = m_config.redMaxDropChance * ( m_averageQueueBytes - minThreshold ) / ( maxThreshold - minThreshold );
+                    drop = core::random_float( 0.0f, 100.0f ) < dropChance;
+                }
             }
 
-            const float delay = m_state.latency + jitter;
+            if ( drop )
+            {
+                m_numQueueDrops++;
+                return false;
+            }
+        }
 
-            m_packets[index].packet = packet;
-            m_packets[index].packetNumber = m_packetNumberSend;
-            m_packets[index].dequeueTime = m_timeBase.time + delay;
-            
-            packet->SetAddress( address );
+        m_linkTime = core::max( m_linkTime, m_timeBase.time ) + packetSize / bytesPerSecond;
 
-            m_packetNumberSend++;
+        queueDelay = float( m_linkTime - m_timeBase.time );
+
+        m_queueDelay += ( queueDelay - m_queueDelay ) * 0.1f;
+
+        return true;
+    }
+
+    void Simulator::QueuePacket( const Address & address, protocol::Packet * packet, float delay )
+    {
+        CORE_ASSERT( !m_tcpMode );
+
+        const int index = m_packetNumberSend % m_config.numPackets;
+
+        if ( m_packets[index].packet )
+        {
+            HeapRemove( m_heapPosition[index] );
+            m_config.packetFactory->Destroy( m_packets[index].packet );
+            m_packets[index].packet = nullptr;
         }
+
+        m_packets[index].packet = packet;
+        m_packets[index].packetNumber = m_packetNumberSend;
+        m_packets[index].dequeueTime = m_timeBase.time + delay;
+        
+        packet->SetAddress( address );
+
+        HeapInsert( index );
+
+        m_packetNumberSend++;
     }
 
     protocol::Packet * Simulator::ReceivePacket()
     {
-        PacketData * oldestPacket = nullptr;
-
         if ( m_tcpMode )
         {
             // TCP mode. We know the next packet number we must dequeue. 
@@ -163,33 +375,121 @@ namespace network
         }
         else
         {
-            // UDP mode. Dequeue the oldest packet we find. Don't worry about ordering at all!
+            // UDP mode. Dequeue the packet with the earliest dequeue time. Don't worry about ordering at all!
 
-            for ( int i = 0; i < m_config.numPackets; ++i )
+            if ( m_heapSize > 0 )
             {
-                if ( m_packets[i].packet == nullptr || m_packets[i].dequeueTime > m_timeBase.time )
-                    continue;
+                const int index = m_heap[0];
 
-                if ( !oldestPacket || ( oldestPacket && m_packets[i].dequeueTime < oldestPacket->dequeueTime ) )
-                    oldestPacket = &m_packets[i];
-            }
-
-            if ( oldestPacket )
-            {
-                auto packet = oldestPacket->packet;
-                oldestPacket->packet = nullptr;
-                return packet;
+                if ( m_packets[index].dequeueTime <= m_timeBase.time )
+                {
+                    HeapRemove( 0 );
+                    auto packet = m_packets[index].packet;
+                    m_packets[index].packet = nullptr;
+                    return packet;
+                }
             }
         }
 
         return nullptr;
     }
 
+    void Simulator::HeapInsert( int index )
+    {
+        CORE_ASSERT( index >= 0 );
+        CORE_ASSERT( index < m_config.numPackets );
+        CORE_ASSERT( m_heapPosition[index] == -1 );
+        CORE_ASSERT( m_heapSize < m_config.numPackets );
+
+        const int position = m_heapSize++;
+        m_heap[position] = index;
+        m_heapPosition[index] = position;
+        HeapSiftUp( position );
+    }
+
+    void Simulator::HeapRemove( int position )
+    {
+        CORE_ASSERT( position >= 0 );
+        CORE_ASSERT( position < m_heapSize );
+
+        const int last = --m_heapSize;
+
+        m_heapPosition[ m_heap[position] ] = -1;
+
+        if ( position == last )
+            return;
+
+        m_heap[position] = m_heap[last];
+        m_heapPosition[ m_heap[position] ] = position;
+
+        HeapSiftUp( position );
+        HeapSiftDown( position );
+    }
+
+    bool Simulator::HeapLess( int a, int b ) const
+    {
+        // ties go to the packet sent first
+
+        const PacketData & packetA = m_packets[ m_heap[a] ];
+        const PacketData & packetB = m_packets[ m_heap[b] ];
+
+        if ( packetA.dequeueTime != packetB.dequeueTime )
+            return packetA.dequeueTime < packetB.dequeueTime;
+
+        return packetA.packetNumber < packetB.packetNumber;
+    }
+
+    void Simulator::HeapSwap( int a, int b )
+    {
+        const int temp = m_heap[a];
+        m_heap[a] = m_heap[b];
+        m_heap[b] = temp;
+        m_heapPosition[ m_heap[a] ] = a;
+        m_heapPosition[ m_heap[b] ] = b;
+    }
+
+    void Simulator::HeapSiftUp( int position )
+    {
+        while ( position > 0 )
+        {
+            const int parent = ( position - 1 ) / 2;
+            if ( !HeapLess( position, parent ) )
+                break;
+            HeapSwap( position, parent );
+            position = parent;
+        }
+    }
+
+    void Simulator::HeapSiftDown( int position )
+    {
+        while ( true )
+        {
+            const int left = position * 2 + 1;
+            const int right = left + 1;
+
+            int smallest = position;
+            if ( left < m_heapSize && HeapLess( left, smallest ) )
+                smallest = left;
+            if ( right < m_heapSize && HeapLess( right, smallest ) )
+                smallest = right;
+
+            if ( smallest == position )
+                break;
+
+            HeapSwap( position, smallest );
+            position = smallest;
+        }
+    }
+
     void Simulator::Update( const core::TimeBase & timeBase )
     {
         m_timeBase = timeBase;
 
-        if ( m_numStates && ( rand() % m_config.stateChance ) == 0 )
+        if ( core::array::any( m_trace ) )
+        {
+            UpdateTrace();
+        }
+        else if ( m_numStates && ( rand() % m_config.stateChance ) == 0 )
         {
             const int stateIndex = rand() % m_numStates;
             m_state = m_states[stateIndex];
@@ -198,6 +498,7 @@ namespace network
         if ( !m_bandwidthSlidingWindow.IsEmpty() )
         {
             uint64_t bytes = 0;
+            uint64_t compressedBytes = 0;
             int numEntries = 0;
             uint16_t sequence = m_bandwidthSlidingWindow.GetBegin();
             while ( sequence != m_bandwidthSlidingWindow.GetEnd() )
@@ -206,15 +507,52 @@ namespace network
                 if ( entry.time >= m_timeBase.time - m_config.bandwidthTime - 0.001f )
                 {
                     bytes += entry.packetSize;
+                    compressedBytes += entry.compressedPacketSize;
                     numEntries++;
                 }
                 sequence++;
             }
             m_bandwidth = bytes * 8.0 / m_config.bandwidthTime / 1000.0;     // kilobits per-second
+            m_compressedBandwidth = compressedBytes * 8.0 / m_config.bandwidthTime / 1000.0;
         }
     }
 
-    protocol::Packet * Simulator::SerializePacket( protocol::Packet * input, int & packetSize )
+    void Simulator::UpdateTrace()
+    {
+        // replay mode. the trace overrides latency, jitter and packet loss of the current state.
+
+        if ( m_traceStartTime < 0.0 )
+            m_traceStartTime = m_timeBase.time;
+
+        const int numEntries = core::array::size( m_trace );
+
+        const double duration = m_trace[numEntries-1].time;
+
+        double time = m_timeBase.time - m_traceStartTime;
+        if ( duration > 0.0 )
+            time = fmod( time, duration );
+
+        // binary search for the last entry at or before time
+
+        int low = 0;
+        int high = numEntries - 1;
+        while ( low < high )
+        {
+            const int middle = ( low + high + 1 ) / 2;
+            if ( m_trace[middle].time <= time )
+                low = middle;
+            else
+                high = middle - 1;
+        }
+
+        const SimulatorTraceEntry & entry = m_trace[low];
+
+        m_state.latency = entry.latency;
+        m_state.jitter = entry.jitter;
+        m_state.packetLoss = entry.packetLoss;
+    }
+
+    protocol::Packet * Simulator::SerializePacket( protocol::Packet * input, int & packetSize, int & compressedPacketSize, protocol::Packet ** duplicate )
     {
         CORE_ASSERT( input );
 
@@ -261,8 +599,48 @@ namespace network
 
             CORE_ASSERT( !stream.IsOverflow() );
 
+            if ( duplicate )
+            {
+                *duplicate = m_config.packetFactory->Create( packetType );
+
+                CORE_ASSERT( *duplicate );
+
+                if ( *duplicate )
+                {
+                    (*duplicate)->SetAddress( packetAddress );
+
+                    Stream duplicateStream( buffer, m_config.maxPacketSize );
+
+                    duplicateStream.SetContext( m_context );
+
+                    (*duplicate)->SerializeRead( duplicateStream );
+
+                    CORE_ASSERT( !duplicateStream.IsOverflow() );
+
+                    if ( duplicateStream.IsOverflow() || duplicateStream.Aborted() )
+                    {
+                        m_config.packetFactory->Destroy( *duplicate );
+                        *duplicate = nullptr;
+                    }
+                }
+            }
+
             packetSize = bytes + m_config.packetHeaderSize;
 
+            compressedPacketSize = packetSize;
+
+            if ( m_compressor )
+            {
+                // measure only. the packet is delivered uncompressed.
+
+                uint8_t compressed[m_config.maxPacketSize];
+
+                const int compressedBytes = m_compressor->Compress( buffer, bytes, compressed, bytes - 1 );
+
+                if ( compressedBytes > 0 )
+                    compressedPacketSize = compressedBytes + m_config.packetHeaderSize;
+            }
+
             return packet;
         }
     }
@@ -4,6 +4,7 @@
 #define NETWORK_SIMULATOR_H
 
 #include "core/Core.h"
+#include "core/Array.h"
 #include "core/Memory.h"
 #include "network/Constants.h"
 #include "network/Interface.h"
@@ -19,6 +20,14 @@ namespace protocol
 
 namespace network
 {
+    class Compressor;
+
+    enum SimulatorQueueMode
+    {
+        SIMULATOR_QUEUE_DROP_TAIL,          // drop packets that don't fit in the queue
+        SIMULATOR_QUEUE_RED                 // random early detection: drop with increasing chance as the average queue grows
+    };
+
     struct SimulatorConfig
     {
         core::Allocator * allocator;
@@ -27,9 +36,18 @@ namespace network
         int numPackets;                     // number of packets to buffer
         int maxPacketSize;                  // maximum packet size in bytes
         int packetHeaderSize;               // packet header size in bytes (for bandwidth calculations)
-        bool serializePackets;              // if true then serialize read/writ packets
+        bool serializePackets;              // if true then serialize read/writ packets. required for duplicate packets
         int bandwidthSize;                  // number of entries in bandwidth sliding window
         float bandwidthTime;                // average bandwidth over this amount of time in the past
+        bool compressPackets;               // if true then serialized packets are also compressed to measure compressed bandwidth (requires serializePackets)
+        const uint8_t * compressionDictionary;  // optional static dictionary for compression
+        int compressionDictionarySize;      // size of the compression dictionary in bytes
+        int queueSize;                      // bottleneck queue size in bytes when the state has a bandwidth cap. 0 = unlimited (UDP mode only)
+        SimulatorQueueMode queueMode;       // what to do when the bottleneck queue fills up
+        float redMinThreshold;              // RED: start dropping when the average queue is above this fraction of the queue size
+        float redMaxThreshold;              // RED: drop everything when the average queue is above this fraction of the queue size
+        float redMaxDropChance;             // RED: drop chance (%) just below the max threshold
+        float redWeight;                    // RED: weight of each new sample in the average queue size
 
         SimulatorConfig()
         {   
@@ -42,6 +60,15 @@ namespace network
             packetHeaderSize = 28;
             bandwidthSize = 1024;
             bandwidthTime = 0.5f;
+            compressPackets = false;
+            compressionDictionary = nullptr;
+            compressionDictionarySize = 0;
+            queueSize = 0;
+            queueMode = SIMULATOR_QUEUE_DROP_TAIL;
+            redMinThreshold = 0.25f;
+            redMaxThreshold = 0.75f;
+            redMaxDropChance = 10.0f;
+            redWeight = 0.05f;
         }
     };
 
@@ -50,12 +77,20 @@ namespace network
         float latency;                      // amount of latency in seconds
         float jitter;                       // amount of jitter +/- in seconds
         float packetLoss;                   // packet loss (%)
+        float burstChance;                  // chance (%) per packet to enter a loss burst (Gilbert-Elliott bad state)
+        float burstEndChance;               // chance (%) per packet to leave a loss burst
+        float burstPacketLoss;              // packet loss (%) during a loss burst
+        float reorderChance;                // chance (%) a packet is held back by an extra reorder delay, so packets sent after it overtake it
+        float reorderDelay;                 // extra delay in seconds on top of latency and jitter for reordered packets
+        float duplicateChance;              // chance (%) a packet is delivered twice (UDP mode and serializePackets only)
+        float bandwidth;                    // link rate in kbps. packets queue behind each other when it is exceeded. 0 = unlimited
 
         SimulatorState()
         {
             latency = 0.0f;
             jitter = 0.0f;
             packetLoss = 0.0f;
+            SetDefaults();
         }
 
         SimulatorState( float _latency,
@@ -65,13 +100,44 @@ namespace network
             latency = _latency;
             jitter = _jitter;
             packetLoss = _packetLoss;
+            SetDefaults();
         }
+
+        void SetDefaults()
+        {
+            burstChance = 0.0f;
+            burstEndChance = 0.0f;
+            burstPacketLoss = 0.0f;
+            reorderChance = 0.0f;
+            reorderDelay = 0.05f;
+            duplicateChance = 0.0f;
+            bandwidth = 0.0f;
+        }
+    };
+
+    /*
+        Simulator trace files replay recorded link conditions. Each line is
+
+            <time> <latency> <jitter> <packet loss>
+
+        with time, latency and jitter in seconds and packet loss in percent.
+        Times must not decrease. Lines starting with # are comments. Each
+        entry applies until the next, and the trace loops at its last entry.
+    */
+
+    struct SimulatorTraceEntry
+    {
+        double time;
+        float latency;
+        float jitter;
+        float packetLoss;
     };
 
     struct BandwidthEntry
     {
         double time = 0.0;
         int packetSize = 0;
+        int compressedPacketSize = 0;
     };
 
     typedef protocol::SlidingWindow<BandwidthEntry> BandwidthSlidingWindow;
@@ -90,6 +156,12 @@ namespace network
 
         void ClearStates();
 
+        bool LoadTrace( const char * filename );
+
+        void ClearTrace();
+
+        const SimulatorState & GetState() const { return m_state; }
+
         void SetBandwidthExclude( bool flag ) { m_bandwidthExclude = flag; }
 
         void SendPacket( const Address & address, protocol::Packet * packet );
@@ -127,12 +199,52 @@ namespace network
             return m_bandwidth;     // kbps
         }
 
+        float GetCompressedBandwidth() const
+        {
+            return m_compressedBandwidth;     // kbps
+        }
+
+        float GetQueueDelay() const
+        {
+            return m_queueDelay;    // seconds (smoothed)
+        }
+
+        uint64_t GetNumQueueDrops() const
+        {
+            return m_numQueueDrops;
+        }
+
+        float GetBandwidthSavings() const
+        {
+            return m_bandwidth > 0.0f ? 100.0f * ( 1.0f - m_compressedBandwidth / m_bandwidth ) : 0.0f;     // %
+        }
+
     protected:
 
-        protocol::Packet * SerializePacket( protocol::Packet * input, int & packetSize );
+        protocol::Packet * SerializePacket( protocol::Packet * input, int & packetSize, int & compressedPacketSize, protocol::Packet ** duplicate = nullptr );
 
     private:
 
+        int MeasurePacket( protocol::Packet * packet );
+
+        bool EnqueueLink( int packetSize, float & queueDelay );
+
+        void QueuePacket( const Address & address, protocol::Packet * packet, float delay );
+
+        void UpdateTrace();
+
+        void HeapInsert( int index );
+
+        void HeapRemove( int position );
+
+        bool HeapLess( int a, int b ) const;
+
+        void HeapSwap( int a, int b );
+
+        void HeapSiftUp( int position );
+
+        void HeapSiftDown( int position );
+
         struct PacketData
         {
             protocol::Packet * packet = nullptr;
@@ -151,15 +263,36 @@ namespace network
 
         PacketData * m_packets;
 
+        // UDP mode: min-heap of packet indices keyed by dequeue time, so the next
+        // packet to deliver is always at the top. m_heapPosition maps each packet
+        // index back to its heap position (-1 if not in the heap) so a packet
+        // can be removed when its slot is overwritten.
+
+        int * m_heap;
+        int * m_heapPosition;
+        int m_heapSize;
+
         bool m_tcpMode;
         bool m_bandwidthExclude;
 
         float m_bandwidth;
+        float m_compressedBandwidth;
+
+        Compressor * m_compressor;
 
         int m_numStates;
         SimulatorState m_state;
         SimulatorState m_states[MaxSimulatorStates];
 
+        bool m_burst;
+        double m_linkTime;
+        double m_averageQueueBytes;
+        float m_queueDelay;
+        uint64_t m_numQueueDrops;
+
+        core::Array<SimulatorTraceEntry> m_trace;
+        double m_traceStartTime;
+
         BandwidthSlidingWindow m_bandwidthSlidingWindow;
 
         Simulator( const Simulator & other );
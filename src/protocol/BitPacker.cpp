@@ -159,11 +159,13 @@ namespace protocol
         else
         {
             m_wordIndex++;
-            CORE_ASSERT( m_wordIndex < m_numWords );
             const uint32_t a = 32 - m_bitIndex;
             const uint32_t b = bits - a;
             m_scratch <<= a;
-            m_scratch |= core::network_to_host( m_data[m_wordIndex] );
+            // note: a read ending exactly at the end of the buffer has no next word to load
+            CORE_ASSERT( m_wordIndex < m_numWords || b == 0 );
+            if ( m_wordIndex < m_numWords )
+                m_scratch |= core::network_to_host( m_data[m_wordIndex] );
             m_scratch <<= b;
             m_bitIndex = b;
         }
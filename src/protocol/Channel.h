@@ -30,7 +30,7 @@ namespace protocol
 
         virtual int GetError() const = 0;
 
-        virtual ChannelData * GetData( uint16_t sequence ) = 0;
+        virtual ChannelData * GetData( uint16_t sequence, int availableBits ) = 0;       // availableBits is what is left of the packet budget for this channel
 
         virtual bool ProcessData( uint16_t sequence, ChannelData * data ) = 0;
 
@@ -66,7 +66,7 @@ namespace protocol
 
         int GetError() const { return 0; }
 
-        ChannelData * GetData( uint16_t sequence ) { return nullptr; }
+        ChannelData * GetData( uint16_t sequence, int availableBits ) { return nullptr; }
 
         bool ProcessData( uint16_t sequence, ChannelData * data ) { return true; }
 
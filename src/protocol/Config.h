@@ -0,0 +1,13 @@
+// Protocol Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#ifndef PROTOCOL_CONFIG_H
+#define PROTOCOL_CONFIG_H
+
+// set to 1 to attribute bits written to named scopes (see serialize_scope). zero overhead when 0.
+// IMPORTANT: this must be the same for every translation unit that serializes packets.
+
+#ifndef PROTOCOL_STREAM_STATS
+#define PROTOCOL_STREAM_STATS 0
+#endif
+
+#endif
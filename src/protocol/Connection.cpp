@@ -66,6 +66,11 @@ namespace protocol
             m_channels[i]->Reset();
 
         memset( m_counters, 0, sizeof( m_counters ) );
+
+        m_rtt = 0.0f;
+        m_packetLoss = 0.0f;
+        m_lossSequence = 0;
+        m_packetSize = m_config.maxPacketSize;
     }
 
     void Connection::Update( const core::TimeBase & timeBase )
@@ -85,6 +90,8 @@ namespace protocol
                 return;
             }
         }
+
+        UpdatePacketLoss();
     }
 
     ConnectionError Connection::GetError() const
@@ -115,11 +122,26 @@ namespace protocol
 
         GenerateAckBits( *m_receivedPackets, packet->ack, packet->ack_bits );
 
+        // each channel may use what is left of the packet size after the header and the channels before it
+
+        int availableBits = ( m_packetSize - ConnectionPacketHeaderBytes ) * 8;
+
         for ( int i = 0; i < m_numChannels; ++i )
-            packet->channelData[i] = m_channels[i]->GetData( packet->sequence );
+        {
+            packet->channelData[i] = m_channels[i]->GetData( packet->sequence, availableBits );
+
+            if ( packet->channelData[i] )
+            {
+                MeasureStream measureStream( m_packetSize );
+                measureStream.SetContext( m_config.context );
+                packet->channelData[i]->SerializeMeasure( measureStream );
+                availableBits -= measureStream.GetBitsProcessed() + 7;          // note: +7 for the align before each channel's data
+            }
+        }
 
         auto entry = m_sentPackets->Insert( packet->sequence );
         CORE_ASSERT( entry );
+        entry->time = m_timeBase.time;
         entry->acked = 0;
 
         m_counters[CONNECTION_COUNTER_PACKETS_WRITTEN]++;
@@ -170,6 +192,27 @@ namespace protocol
         return m_counters[index];
     }
 
+    float Connection::GetRTT() const
+    {
+        return m_rtt;
+    }
+
+    float Connection::GetPacketLoss() const
+    {
+        return m_packetLoss;
+    }
+
+    void Connection::SetPacketSize( int bytes )
+    {
+        CORE_ASSERT( bytes > ConnectionPacketHeaderBytes );
+        m_packetSize = core::min( bytes, m_config.maxPacketSize );
+    }
+
+    int Connection::GetPacketSize() const
+    {
+        return m_packetSize;
+    }
+
     void Connection::ProcessAcks( uint16_t ack, uint32_t ack_bits )
     {
 //            printf( "process acks: %d - %x\n", (int)ack, ack_bits );
@@ -182,6 +225,13 @@ namespace protocol
                 SentPacketData * packetData = m_sentPackets->Find( sequence );
                 if ( packetData && !packetData->acked )
                 {
+                    const float rtt = (float) ( m_timeBase.time - packetData->time );
+                    CORE_ASSERT( rtt >= 0.0f );
+                    if ( m_rtt == 0.0f )
+                        m_rtt = rtt;
+                    else
+                        m_rtt += ( rtt - m_rtt ) * m_config.rttSmoothingFactor;
+
                     PacketAcked( sequence );
                     packetData->acked = 1;
                 }
@@ -190,6 +240,42 @@ namespace protocol
         }
     }
 
+    void Connection::UpdatePacketLoss()
+    {
+        /*
+            Walk sent packets in order, counting each as delivered once acked, or lost once its ack
+            is overdue: not acked within the smoothed RTT plus a timeout. Acks can arrive long after
+            32 newer packets have been sent when RTT is high, so packets are not lost just for being old.
+
+            Until there is an RTT estimate, late can't be told from lost, so packets are only counted
+            lost if they fall out of the sent packets window.
+        */
+
+        const uint16_t sequence = m_sentPackets->GetSequence();
+
+        while ( m_lossSequence != sequence )
+        {
+            const SentPacketData * entry = m_sentPackets->Find( m_lossSequence );
+
+            bool lost;
+            if ( !entry )
+                lost = true;
+            else if ( entry->acked )
+                lost = false;
+            else if ( m_rtt > 0.0f && m_timeBase.time - entry->time > m_rtt + m_config.packetLossTimeout )
+                lost = true;
+            else
+                break;
+
+            if ( lost )
+                m_counters[CONNECTION_COUNTER_PACKETS_LOST]++;
+
+            m_packetLoss += ( ( lost ? 100.0f : 0.0f ) - m_packetLoss ) * m_config.packetLossSmoothingFactor;
+
+            m_lossSequence++;
+        }
+    }
+
     void Connection::PacketAcked( uint16_t sequence )
     {
 //            printf( "packet %d acked\n", (int) sequence );
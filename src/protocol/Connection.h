@@ -20,12 +20,15 @@ namespace protocol
         int packetType = protocol::CONNECTION_PACKET;
         int maxPacketSize = 1024;
         int slidingWindowSize = 256;
+        float rttSmoothingFactor = 0.1f;                            // exponential smoothing factor applied to each new RTT sample
+        float packetLossSmoothingFactor = 0.1f;                     // exponential smoothing factor applied to each packet lost/delivered sample
+        float packetLossTimeout = 0.2f;                             // a sent packet still not acked this many seconds after the smoothed RTT is counted as lost
         PacketFactory * packetFactory = nullptr;
         ChannelStructure * channelStructure = nullptr;
         const void ** context = nullptr;
     };
 
-    struct SentPacketData { uint8_t acked; };
+    struct SentPacketData { double time; uint8_t acked; };
     struct ReceivedPacketData {};
     typedef SequenceBuffer<SentPacketData> SentPackets;
     typedef SequenceBuffer<ReceivedPacketData> ReceivedPackets;
@@ -44,6 +47,10 @@ namespace protocol
         int m_numChannels = 0;                                      // cached number of channels
         Channel * m_channels[MaxChannels];                          // array of channels created according to channel structure
         uint64_t m_counters[CONNECTION_COUNTER_NUM_COUNTERS];       // counters for unit testing, stats etc.
+        float m_rtt = 0.0f;                                         // smoothed round trip time in seconds, measured from acked packets
+        float m_packetLoss = 0.0f;                                  // smoothed packet loss (%), measured from packets whose ack is overdue
+        uint16_t m_lossSequence = 0;                                // oldest sent packet not yet counted as delivered or lost
+        int m_packetSize = 0;                                       // bytes each written packet may take. starts at max packet size
 
     public:
 
@@ -69,9 +76,21 @@ namespace protocol
 
         uint64_t GetCounter( int index ) const;
 
+        float GetRTT() const;
+
+        float GetPacketLoss() const;
+
+        void SetPacketSize( int bytes );
+
+        int GetPacketSize() const;
+
         void ProcessAcks( uint16_t ack, uint32_t ack_bits );
 
         void PacketAcked( uint16_t sequence );
+
+    private:
+
+        void UpdatePacketLoss();
     };
 }
 
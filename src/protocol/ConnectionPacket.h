@@ -46,6 +46,8 @@ namespace protocol
 
         PROTOCOL_SERIALIZE_OBJECT( stream )
         {
+            serialize_scope( stream, "ConnectionPacket" );
+
             // IMPORTANT: Channel structure must be supplied as context
             // so we know what channels are to be serialized for this packet
 
@@ -65,6 +67,8 @@ namespace protocol
 
             if ( clientServerContext )
             {
+                serialize_scope( stream, "client/server ids" );
+
                 serialize_uint16( stream, clientId );
                 serialize_uint16( stream, serverId );
 
@@ -80,18 +84,22 @@ namespace protocol
             // IMPORTANT: Insert non-frequently changing values here
             // This helps LZ dictionary based compressors do a good job!
 
-            bool perfect;
-            if ( Stream::IsWriting )
-                 perfect = ack_bits == 0xFFFFFFFF;
+            {
+                serialize_scope( stream, "ack bits" );
+
+                bool perfect;
+                if ( Stream::IsWriting )
+                     perfect = ack_bits == 0xFFFFFFFF;
 
-            serialize_bool( stream, perfect );
+                serialize_bool( stream, perfect );
 
-            if ( !perfect )
-                serialize_bits( stream, ack_bits, 32 );
-            else
-                ack_bits = 0xFFFFFFFF;
+                if ( !perfect )
+                    serialize_bits( stream, ack_bits, 32 );
+                else
+                    ack_bits = 0xFFFFFFFF;
 
-            stream.Align();
+                stream.Align();
+            }
 
             if ( Stream::IsWriting )
             {
@@ -117,33 +125,37 @@ namespace protocol
 
             // IMPORTANT: Insert frequently changing values below
 
-            serialize_bits( stream, sequence, 16 );
+            {
+                serialize_scope( stream, "sequence and ack" );
 
-            int ack_delta = 0;
-            bool ack_in_range = false;
+                serialize_bits( stream, sequence, 16 );
 
-            if ( Stream::IsWriting )
-            {
-                if ( ack < sequence )
-                    ack_delta = sequence - ack;
-                else
-                    ack_delta = (int)sequence + 65536 - ack;
+                int ack_delta = 0;
+                bool ack_in_range = false;
+
+                if ( Stream::IsWriting )
+                {
+                    if ( ack < sequence )
+                        ack_delta = sequence - ack;
+                    else
+                        ack_delta = (int)sequence + 65536 - ack;
 
-                CORE_ASSERT( ack_delta > 0 );
+                    CORE_ASSERT( ack_delta > 0 );
                 
-                ack_in_range = ack_delta <= 128;
-            }
+                    ack_in_range = ack_delta <= 128;
+                }
 
-            serialize_bool( stream, ack_in_range );
+                serialize_bool( stream, ack_in_range );
     
-            if ( ack_in_range )
-            {
-                serialize_int( stream, ack_delta, 1, 128 );
-                if ( Stream::IsReading )
-                    ack = sequence - ack_delta;
+                if ( ack_in_range )
+                {
+                    serialize_int( stream, ack_delta, 1, 128 );
+                    if ( Stream::IsReading )
+                        ack = sequence - ack_delta;
+                }
+                else
+                    serialize_bits( stream, ack, 16 );
             }
-            else
-                serialize_bits( stream, ack, 16 );
 
             // now serialize per-channel data
 
@@ -153,6 +165,8 @@ namespace protocol
                 {
                     stream.Align();
 
+                    serialize_scope_id( stream, "channel", i );
+
                     serialize_object( stream, *channelData[i] );
                 }
             }
@@ -12,6 +12,7 @@ namespace protocol
     const int MaxChannelName = 64;
     const int MaxFragmentSize = 1024;
     const int MaxContexts = 16;
+    const int ConnectionPacketHeaderBytes = 16;         // worst case connection packet header: client/server ids, ack bits, channel flags, sequence and ack
 }
 
 #endif
@@ -13,6 +13,7 @@ namespace protocol
         CONNECTION_COUNTER_PACKETS_WRITTEN,                     // number of packets written
         CONNECTION_COUNTER_PACKETS_ACKED,                       // number of packets acked
         CONNECTION_COUNTER_PACKETS_DISCARDED,                   // number of read packets that we discarded (eg. not acked)
+        CONNECTION_COUNTER_PACKETS_LOST,                        // number of written packets not acked within the smoothed RTT plus packetLossTimeout. before there is an RTT estimate, those that left the sent packets window without being acked
         CONNECTION_COUNTER_NUM_COUNTERS
     };
 
@@ -0,0 +1,143 @@
+// Protocol Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#include "RangeCoder.h"
+
+namespace protocol
+{
+    const uint32_t RangeTop = 1 << 24;
+
+    RangeEncoder::RangeEncoder( uint8_t * buffer, int bytes )
+    {
+        CORE_ASSERT( buffer );
+        CORE_ASSERT( bytes > 0 );
+        m_buffer = buffer;
+        m_totalBytes = bytes;
+        m_bytesWritten = 0;
+        m_low = 0;
+        m_range = 0xFFFFFFFF;
+        m_cache = 0;
+        m_cacheSize = 1;
+        m_overflow = false;
+    }
+
+    void RangeEncoder::Encode( uint32_t cumulativeFrequency, uint32_t frequency, uint32_t totalFrequency )
+    {
+        CORE_ASSERT( frequency > 0 );
+        CORE_ASSERT( cumulativeFrequency + frequency <= totalFrequency );
+        CORE_ASSERT( totalFrequency <= RangeCoderMaxTotal );
+
+        m_range /= totalFrequency;
+        m_low += uint64_t( cumulativeFrequency ) * m_range;
+        m_range *= frequency;
+
+        while ( m_range < RangeTop )
+        {
+            m_range <<= 8;
+            ShiftLow();
+        }
+    }
+
+    void RangeEncoder::EncodeBits( uint32_t value, int bits )
+    {
+        CORE_ASSERT( bits > 0 );
+        CORE_ASSERT( bits <= 32 );
+
+        // IMPORTANT: at most 16 bits per step so the total frequency stays within precision
+
+        while ( bits > 0 )
+        {
+            const int step = core::min( bits, 16 );
+            bits -= step;
+            const uint32_t chunk = ( value >> bits ) & ( ( 1 << step ) - 1 );
+            Encode( chunk, 1, 1 << step );
+        }
+    }
+
+    void RangeEncoder::Flush()
+    {
+        for ( int i = 0; i < 5; ++i )
+            ShiftLow();
+    }
+
+    void RangeEncoder::ShiftLow()
+    {
+        if ( uint32_t( m_low ) < 0xFF000000U || ( m_low >> 32 ) != 0 )
+        {
+            const uint8_t carry = uint8_t( m_low >> 32 );
+            uint8_t value = m_cache;
+            do
+            {
+                if ( m_bytesWritten < m_totalBytes )
+                    m_buffer[m_bytesWritten++] = uint8_t( value + carry );
+                else
+                    m_overflow = true;
+                value = 0xFF;
+            }
+            while ( --m_cacheSize != 0 );
+            m_cache = uint8_t( m_low >> 24 );
+        }
+        m_cacheSize++;
+        m_low = ( m_low & 0x00FFFFFF ) << 8;
+    }
+
+    RangeDecoder::RangeDecoder( const uint8_t * buffer, int bytes )
+    {
+        CORE_ASSERT( buffer );
+        m_buffer = buffer;
+        m_totalBytes = bytes;
+        m_bytesRead = 0;
+        m_code = 0;
+        m_range = 0xFFFFFFFF;
+        m_overflow = false;
+        for ( int i = 0; i < 5; ++i )
+            m_code = ( m_code << 8 ) | ReadByte();
+    }
+
+    uint32_t RangeDecoder::GetFrequency( uint32_t totalFrequency )
+    {
+        CORE_ASSERT( totalFrequency > 0 );
+        CORE_ASSERT( totalFrequency <= RangeCoderMaxTotal );
+        m_range /= totalFrequency;
+        const uint32_t value = m_code / m_range;
+        return core::min( value, totalFrequency - 1 );
+    }
+
+    void RangeDecoder::Decode( uint32_t cumulativeFrequency, uint32_t frequency )
+    {
+        m_code -= cumulativeFrequency * m_range;
+        m_range *= frequency;
+
+        while ( m_range < RangeTop )
+        {
+            m_code = ( m_code << 8 ) | ReadByte();
+            m_range <<= 8;
+        }
+    }
+
+    uint32_t RangeDecoder::DecodeBits( int bits )
+    {
+        CORE_ASSERT( bits > 0 );
+        CORE_ASSERT( bits <= 32 );
+
+        uint32_t value = 0;
+        while ( bits > 0 )
+        {
+            const int step = core::min( bits, 16 );
+            bits -= step;
+            const uint32_t chunk = GetFrequency( 1 << step );
+            Decode( chunk, 1 );
+            value = ( value << step ) | chunk;
+        }
+        return value;
+    }
+
+    uint8_t RangeDecoder::ReadByte()
+    {
+        if ( m_bytesRead >= m_totalBytes )
+        {
+            m_overflow = true;
+            return 0;
+        }
+        return m_buffer[m_bytesRead++];
+    }
+}
@@ -0,0 +1,262 @@
+// Protocol Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#ifndef PROTOCOL_RANGE_CODER_H
+#define PROTOCOL_RANGE_CODER_H
+
+#include "core/Core.h"
+
+namespace protocol
+{
+    const int RangeCoderMaxTotal = 1 << 16;            // IMPORTANT: model totals must not exceed this or precision is lost
+
+    /*
+        Byte-oriented range coder with carry propagation (LZMA style).
+
+        Symbols are coded as [cumulative frequency, frequency) out of a total
+        frequency. Frequencies come from a model, so the same coder encodes
+        uniform integers and symbols with measured or adaptive distributions.
+    */
+
+    class RangeEncoder
+    {
+    public:
+
+        RangeEncoder( uint8_t * buffer, int bytes );
+
+        void Encode( uint32_t cumulativeFrequency, uint32_t frequency, uint32_t totalFrequency );
+
+        void EncodeBits( uint32_t value, int bits );
+
+        void Flush();
+
+        int GetBytesWritten() const { return m_bytesWritten; }
+
+        int GetTotalBytes() const { return m_totalBytes; }
+
+        const uint8_t * GetData() const { return m_buffer; }
+
+        bool IsOverflow() const { return m_overflow; }
+
+    private:
+
+        void ShiftLow();
+
+        uint8_t * m_buffer;
+        int m_totalBytes;
+        int m_bytesWritten;
+        uint64_t m_low;
+        uint32_t m_range;
+        uint8_t m_cache;
+        uint64_t m_cacheSize;
+        bool m_overflow;
+    };
+
+    class RangeDecoder
+    {
+    public:
+
+        RangeDecoder( const uint8_t * buffer, int bytes );
+
+        uint32_t GetFrequency( uint32_t totalFrequency );
+
+        void Decode( uint32_t cumulativeFrequency, uint32_t frequency );
+
+        uint32_t DecodeBits( int bits );
+
+        int GetBytesRead() const { return m_bytesRead; }
+
+        bool IsOverflow() const { return m_overflow; }
+
+    private:
+
+        uint8_t ReadByte();
+
+        const uint8_t * m_buffer;
+        int m_totalBytes;
+        int m_bytesRead;
+        uint32_t m_code;
+        uint32_t m_range;
+        bool m_overflow;
+    };
+
+    /*
+        Adaptive frequency model. Starts flat (or from a prior histogram)
+        and adapts as symbols are coded. Encoder and decoder must start from
+        the same state and see the same symbols, so reset models at the start
+        of each packet unless the channel is reliable and ordered.
+    */
+
+    template <int N> class AdaptiveModel
+    {
+    public:
+
+        enum { NumSymbols = N };
+        enum { Increment = 32 };
+
+        AdaptiveModel()
+        {
+            Reset();
+        }
+
+        void Reset()
+        {
+            for ( int i = 0; i < N; ++i )
+                m_frequency[i] = 1;
+            m_total = N;
+        }
+
+        void Reset( const uint64_t * histogram )
+        {
+            Normalize( histogram, m_frequency, m_total, RangeCoderMaxTotal / 2 );
+        }
+
+        uint32_t GetTotal() const
+        {
+            return m_total;
+        }
+
+        void GetRange( int symbol, uint32_t & cumulativeFrequency, uint32_t & frequency ) const
+        {
+            CORE_ASSERT( symbol >= 0 );
+            CORE_ASSERT( symbol < N );
+            cumulativeFrequency = 0;
+            for ( int i = 0; i < symbol; ++i )
+                cumulativeFrequency += m_frequency[i];
+            frequency = m_frequency[symbol];
+        }
+
+        int FindSymbol( uint32_t target, uint32_t & cumulativeFrequency, uint32_t & frequency ) const
+        {
+            cumulativeFrequency = 0;
+            for ( int i = 0; i < N - 1; ++i )
+            {
+                if ( target < cumulativeFrequency + m_frequency[i] )
+                {
+                    frequency = m_frequency[i];
+                    return i;
+                }
+                cumulativeFrequency += m_frequency[i];
+            }
+            frequency = m_frequency[N-1];
+            return N - 1;
+        }
+
+        void Update( int symbol )
+        {
+            m_frequency[symbol] += Increment;
+            m_total += Increment;
+            if ( m_total > RangeCoderMaxTotal )
+            {
+                m_total = 0;
+                for ( int i = 0; i < N; ++i )
+                {
+                    m_frequency[i] = ( m_frequency[i] + 1 ) / 2;
+                    m_total += m_frequency[i];
+                }
+            }
+        }
+
+        static void Normalize( const uint64_t * histogram, uint32_t * frequency, uint32_t & total, uint32_t targetTotal )
+        {
+            // scale histogram counts to the target total, keeping every symbol codable
+
+            CORE_ASSERT( targetTotal >= (uint32_t) N );
+
+            uint64_t sum = 0;
+            for ( int i = 0; i < N; ++i )
+                sum += histogram[i];
+
+            const uint64_t available = targetTotal - N;
+
+            total = 0;
+            for ( int i = 0; i < N; ++i )
+            {
+                frequency[i] = 1 + ( sum ? uint32_t( histogram[i] * available / sum ) : 0 );
+                total += frequency[i];
+            }
+
+            CORE_ASSERT( total <= targetTotal );
+        }
+
+    private:
+
+        uint32_t m_frequency[N];
+        uint32_t m_total;
+    };
+
+    /*
+        Static frequency model built once from a measured histogram.
+        Cumulative frequencies are precomputed so coding is cheap and the
+        model never changes, so it needs no reset between packets.
+    */
+
+    template <int N> class StaticModel
+    {
+    public:
+
+        enum { NumSymbols = N };
+
+        StaticModel()
+        {
+            uint64_t histogram[N];
+            for ( int i = 0; i < N; ++i )
+                histogram[i] = 1;
+            Reset( histogram );
+        }
+
+        StaticModel( const uint64_t * histogram )
+        {
+            Reset( histogram );
+        }
+
+        void Reset( const uint64_t * histogram )
+        {
+            uint32_t frequency[N];
+            AdaptiveModel<N>::Normalize( histogram, frequency, m_total, RangeCoderMaxTotal );
+            m_cumulative[0] = 0;
+            for ( int i = 0; i < N; ++i )
+                m_cumulative[i+1] = m_cumulative[i] + frequency[i];
+        }
+
+        uint32_t GetTotal() const
+        {
+            return m_total;
+        }
+
+        void GetRange( int symbol, uint32_t & cumulativeFrequency, uint32_t & frequency ) const
+        {
+            CORE_ASSERT( symbol >= 0 );
+            CORE_ASSERT( symbol < N );
+            cumulativeFrequency = m_cumulative[symbol];
+            frequency = m_cumulative[symbol+1] - m_cumulative[symbol];
+        }
+
+        int FindSymbol( uint32_t target, uint32_t & cumulativeFrequency, uint32_t & frequency ) const
+        {
+            // binary search for the last symbol with cumulative frequency <= target
+
+            int low = 0;
+            int high = N - 1;
+            while ( low < high )
+            {
+                const int middle = ( low + high + 1 ) / 2;
+                if ( m_cumulative[middle] <= target )
+                    low = middle;
+                else
+                    high = middle - 1;
+            }
+            cumulativeFrequency = m_cumulative[low];
+            frequency = m_cumulative[low+1] - m_cumulative[low];
+            return low;
+        }
+
+        void Update( int symbol ) {}
+
+    private:
+
+        uint32_t m_cumulative[N+1];
+        uint32_t m_total;
+    };
+}
+
+#endif
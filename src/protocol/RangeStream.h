@@ -0,0 +1,304 @@
+// Protocol Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#ifndef PROTOCOL_RANGE_STREAM_H
+#define PROTOCOL_RANGE_STREAM_H
+
+#include "protocol/Stream.h"
+#include "protocol/RangeCoder.h"
+
+namespace protocol
+{
+    /*
+        Range coded streams. Drop-in for WriteStream/ReadStream in templated
+        serialize functions: serialize_int codes exactly log2(max-min+1) bits
+        instead of rounding up to whole bits, and serialize_symbol codes
+        values with an adaptive or static model so frequent values take far
+        fewer than a bit each. Align is a no-op since output is not bitwise.
+    */
+
+    class RangeWriteStream
+    {
+    public:
+
+        enum { IsWriting = 1 };
+        enum { IsReading = 0 };
+
+        RangeWriteStream( uint8_t * buffer, int bytes ) : m_encoder( buffer, bytes ), m_context( nullptr ), m_aborted( false ) {}
+
+        void SerializeInteger( int32_t value, int32_t min, int32_t max )
+        {
+            CORE_ASSERT( min < max );
+            CORE_ASSERT( value >= min );
+            CORE_ASSERT( value <= max );
+            const uint32_t range = uint32_t( max - min ) + 1;
+            const uint32_t unsigned_value = value - min;
+            if ( range != 0 && range <= (uint32_t) RangeCoderMaxTotal )
+                m_encoder.Encode( unsigned_value, 1, range );
+            else
+                m_encoder.EncodeBits( unsigned_value, core::bits_required( min, max ) );
+        }
+
+        void SerializeBits( uint32_t value, int bits )
+        {
+            CORE_ASSERT( bits > 0 );
+            CORE_ASSERT( bits <= 32 );
+            m_encoder.EncodeBits( value, bits );
+        }
+
+        void SerializeBytes( const uint8_t * data, int bytes )
+        {
+            for ( int i = 0; i < bytes; ++i )
+                m_encoder.EncodeBits( data[i], 8 );
+        }
+
+        template <typename Model> void SerializeSymbol( int value, Model & model )
+        {
+            CORE_ASSERT( value >= 0 );
+            CORE_ASSERT( value < Model::NumSymbols );
+            uint32_t cumulativeFrequency, frequency;
+            model.GetRange( value, cumulativeFrequency, frequency );
+            m_encoder.Encode( cumulativeFrequency, frequency, model.GetTotal() );
+            model.Update( value );
+        }
+
+        void Align() {}
+
+        int GetAlignBits() const
+        {
+            return 0;
+        }
+
+        bool Check( uint32_t magic )
+        {
+            SerializeBits( magic, 32 );
+            return true;
+        }
+
+        void Flush()
+        {
+            m_encoder.Flush();
+        }
+
+        const uint8_t * GetData() const
+        {
+            return m_encoder.GetData();
+        }
+
+        int GetBytesProcessed() const
+        {
+            return m_encoder.GetBytesWritten();
+        }
+
+        int GetBitsProcessed() const
+        {
+            return m_encoder.GetBytesWritten() * 8;
+        }
+
+        int GetTotalBytes() const
+        {
+            return m_encoder.GetTotalBytes();
+        }
+
+        int GetTotalBits() const
+        {
+            return m_encoder.GetTotalBytes() * 8;
+        }
+
+        bool IsOverflow() const
+        {
+            return m_encoder.IsOverflow();
+        }
+
+        void SetContext( const void ** context )
+        {
+            m_context = context;
+        }
+
+        const void * GetContext( int index ) const
+        {
+            CORE_ASSERT( index >= 0 );
+            CORE_ASSERT( index < MaxContexts );
+            return m_context ? m_context[index] : nullptr;
+        }
+
+        void Abort()
+        {
+            m_aborted = true;
+        }
+
+        bool Aborted() const
+        {
+            return m_aborted;
+        }
+
+    private:
+
+        RangeEncoder m_encoder;
+        const void ** m_context;
+        bool m_aborted;
+    };
+
+    class RangeReadStream
+    {
+    public:
+
+        enum { IsWriting = 0 };
+        enum { IsReading = 1 };
+
+        RangeReadStream( const uint8_t * buffer, int bytes ) : m_decoder( buffer, bytes ), m_context( nullptr ), m_aborted( false ) {}
+
+        void SerializeInteger( int32_t & value, int32_t min, int32_t max )
+        {
+            CORE_ASSERT( min < max );
+            const uint32_t range = uint32_t( max - min ) + 1;
+            uint32_t unsigned_value;
+            if ( range != 0 && range <= (uint32_t) RangeCoderMaxTotal )
+            {
+                unsigned_value = m_decoder.GetFrequency( range );
+                m_decoder.Decode( unsigned_value, 1 );
+            }
+            else
+            {
+                unsigned_value = m_decoder.DecodeBits( core::bits_required( min, max ) );
+            }
+            value = (int32_t) unsigned_value + min;
+        }
+
+        void SerializeBits( uint32_t & value, int bits )
+        {
+            CORE_ASSERT( bits > 0 );
+            CORE_ASSERT( bits <= 32 );
+            value = m_decoder.DecodeBits( bits );
+        }
+
+        void SerializeBytes( uint8_t * data, int bytes )
+        {
+            for ( int i = 0; i < bytes; ++i )
+                data[i] = (uint8_t) m_decoder.DecodeBits( 8 );
+        }
+
+        template <typename Model> void SerializeSymbol( int & value, Model & model )
+        {
+            uint32_t cumulativeFrequency, frequency;
+            const uint32_t target = m_decoder.GetFrequency( model.GetTotal() );
+            value = model.FindSymbol( target, cumulativeFrequency, frequency );
+            m_decoder.Decode( cumulativeFrequency, frequency );
+            model.Update( value );
+        }
+
+        void Align() {}
+
+        int GetAlignBits() const
+        {
+            return 0;
+        }
+
+        bool Check( uint32_t magic )
+        {
+            uint32_t value = 0;
+            SerializeBits( value, 32 );
+            CORE_ASSERT( value == magic );
+            return value == magic;
+        }
+
+        int GetBytesProcessed() const
+        {
+            return m_decoder.GetBytesRead();
+        }
+
+        int GetBitsProcessed() const
+        {
+            return m_decoder.GetBytesRead() * 8;
+        }
+
+        bool IsOverflow() const
+        {
+            return m_decoder.IsOverflow();
+        }
+
+        void SetContext( const void ** context )
+        {
+            m_context = context;
+        }
+
+        const void * GetContext( int index ) const
+        {
+            CORE_ASSERT( index >= 0 );
+            CORE_ASSERT( index < MaxContexts );
+            return m_context ? m_context[index] : nullptr;
+        }
+
+        void Abort()
+        {
+            m_aborted = true;
+        }
+
+        bool Aborted() const
+        {
+            return m_aborted;
+        }
+
+    private:
+
+        RangeDecoder m_decoder;
+        const void ** m_context;
+        bool m_aborted;
+    };
+}
+
+/*
+    Serialize a symbol in [0,NumSymbols-1] with a frequency model. Range coded
+    streams use the model. Bit packed streams ignore it and fall back to
+    serialize_int, so the same serialize function works with every stream.
+*/
+
+template <typename Stream, typename Model> void serialize_symbol( Stream & stream, int & value, Model & model )
+{
+    serialize_int( stream, value, 0, Model::NumSymbols - 1 );
+}
+
+template <typename Model> void serialize_symbol( protocol::RangeWriteStream & stream, int & value, Model & model )
+{
+    stream.SerializeSymbol( value, model );
+}
+
+template <typename Model> void serialize_symbol( protocol::RangeReadStream & stream, int & value, Model & model )
+{
+    stream.SerializeSymbol( value, model );
+}
+
+/*
+    Serialize a signed value in [min,max] that is usually close to zero, eg. a delta.
+    Small values are zigzag mapped to model symbols. The last symbol is an escape,
+    followed by the value in full.
+*/
+
+template <typename Stream, typename Model> void serialize_signed_symbol( Stream & stream, int & value, int min, int max, Model & model )
+{
+    CORE_ASSERT( min <= 0 );
+    CORE_ASSERT( max >= 0 );
+
+    const int Escape = Model::NumSymbols - 1;
+
+    int symbol;
+    if ( Stream::IsWriting )
+    {
+        CORE_ASSERT( value >= min );
+        CORE_ASSERT( value <= max );
+        const int zigzag = value >= 0 ? value * 2 : -value * 2 - 1;
+        symbol = core::min( zigzag, Escape );
+    }
+
+    serialize_symbol( stream, symbol, model );
+
+    if ( symbol == Escape )
+    {
+        serialize_int( stream, value, min, max );
+    }
+    else if ( Stream::IsReading )
+    {
+        value = ( symbol & 1 ) ? -( symbol + 1 ) / 2 : symbol / 2;
+    }
+}
+
+#endif
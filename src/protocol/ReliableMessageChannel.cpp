@@ -56,6 +56,8 @@ namespace protocol
                 CORE_ASSERT( fragment );
             }
 
+            serialize_scope( stream, "large block fragment" );
+
             serialize_bits( stream, blockId, 16 );
             serialize_bits( stream, fragmentId, 16 );
             serialize_bits( stream, blockSize, 32 );
@@ -148,6 +150,8 @@ namespace protocol
 
                 CORE_ASSERT( messages[i] );
 
+                serialize_scope_id( stream, "message", messageTypes[i] );
+
                 serialize_object( stream, *messages[i] );
             }
         }
@@ -387,7 +391,7 @@ namespace protocol
         return CORE_NEW( core::memory::scratch_allocator(), ReliableMessageChannelData, m_config );
     }
 
-    ChannelData * ReliableMessageChannel::GetData( uint16_t sequence )
+    ChannelData * ReliableMessageChannel::GetData( uint16_t sequence, int packetBits )
     {
         SendQueueEntry * firstEntry = m_sendQueue->Find( m_oldestUnackedMessageId );
         if ( !firstEntry )
@@ -429,6 +433,11 @@ namespace protocol
 
             CORE_ASSERT( m_sendLargeBlock.active );
 
+            // fragments are a fixed size, so if one doesn't fit in what is left of the packet wait for a bigger packet
+
+            if ( m_config.blockFragmentSize * 8 > packetBits )
+                return nullptr;
+
             int fragmentId = -1;
             for ( int i = 0; i < m_sendLargeBlock.numFragments; ++i )
             {
@@ -493,7 +502,7 @@ namespace protocol
 
             // gather messages to include in the packet
 
-            int availableBits = m_config.packetBudget * 8;
+            int availableBits = core::min( m_config.packetBudget * 8, packetBits );
             if ( m_config.align )
                 availableBits -= 3 * 8;
 
@@ -235,7 +235,7 @@ namespace protocol
 
         ChannelData * CreateData();
 
-        ChannelData * GetData( uint16_t sequence );
+        ChannelData * GetData( uint16_t sequence, int packetBits );
 
         bool ProcessData( uint16_t sequence, ChannelData * channelData );
 
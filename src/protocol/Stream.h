@@ -10,6 +10,7 @@
 #include "protocol/ProtocolEnums.h"
 #include "protocol/Block.h"
 #include "protocol/BitPacker.h"
+#include "protocol/StreamStats.h"
 
 namespace protocol
 {
@@ -0,0 +1,176 @@
+// Protocol Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#include "protocol/StreamStats.h"
+#include <string.h>
+
+namespace protocol
+{
+    namespace stream_stats
+    {
+        const int MaxDepth = 32;
+
+        static StreamStatsEntry s_entries[MaxStreamStatsScopes];
+        static int s_numEntries = 0;
+        static int s_stack[MaxDepth];
+        static int s_stackSize = 0;
+        static bool s_countMeasureStreams = false;
+
+        static int get_bucket( int bits )
+        {
+            int bucket = 0;
+            while ( bits > 0 && bucket < NumStreamStatsBuckets - 1 )
+            {
+                bits >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+
+        int begin( const char * name, int id )
+        {
+            CORE_ASSERT( name );
+
+            CORE_ASSERT( s_stackSize < MaxDepth );
+            if ( s_stackSize == MaxDepth )
+                return -1;
+
+            const int parent = s_stackSize > 0 ? s_stack[s_stackSize-1] : -1;
+
+            int index = find( name, id, parent );
+
+            if ( index < 0 )
+            {
+                CORE_ASSERT( s_numEntries < MaxStreamStatsScopes );
+                if ( s_numEntries == MaxStreamStatsScopes )
+                    return -1;
+
+                index = s_numEntries++;
+
+                StreamStatsEntry & entry = s_entries[index];
+                memset( &entry, 0, sizeof( entry ) );
+                entry.name = name;
+                entry.id = id;
+                entry.parent = parent;
+                entry.depth = parent >= 0 ? s_entries[parent].depth + 1 : 0;
+                entry.minBits = ~uint64_t(0);
+            }
+
+            s_stack[s_stackSize++] = index;
+
+            return index;
+        }
+
+        void end( int index, int bits )
+        {
+            CORE_ASSERT( index >= 0 );
+            CORE_ASSERT( index < s_numEntries );
+            CORE_ASSERT( s_stackSize > 0 );
+            CORE_ASSERT( s_stack[s_stackSize-1] == index );
+            CORE_ASSERT( bits >= 0 );
+
+            s_stackSize--;
+
+            StreamStatsEntry & entry = s_entries[index];
+            entry.count++;
+            entry.bits += bits;
+            entry.minBits = core::min( entry.minBits, uint64_t( bits ) );
+            entry.maxBits = core::max( entry.maxBits, uint64_t( bits ) );
+            entry.histogram[ get_bucket( bits ) ]++;
+        }
+
+        void reset()
+        {
+            CORE_ASSERT( s_stackSize == 0 );        // IMPORTANT: don't reset while serializing!
+            s_numEntries = 0;
+            s_stackSize = 0;
+        }
+
+        int get_num_entries()
+        {
+            return s_numEntries;
+        }
+
+        const StreamStatsEntry & get_entry( int index )
+        {
+            CORE_ASSERT( index >= 0 );
+            CORE_ASSERT( index < s_numEntries );
+            return s_entries[index];
+        }
+
+        int find( const char * name, int id, int parent )
+        {
+            for ( int i = 0; i < s_numEntries; ++i )
+            {
+                const StreamStatsEntry & entry = s_entries[i];
+                if ( entry.parent == parent && entry.id == id && ( entry.name == name || strcmp( entry.name, name ) == 0 ) )
+                    return i;
+            }
+            return -1;
+        }
+
+        void count_measure_streams( bool value )
+        {
+            s_countMeasureStreams = value;
+        }
+
+        bool is_counting_measure_streams()
+        {
+            return s_countMeasureStreams;
+        }
+
+        static void dump_entry( FILE * file, int index )
+        {
+            const StreamStatsEntry & entry = s_entries[index];
+
+            const uint64_t parentBits = entry.parent >= 0 ? s_entries[entry.parent].bits : entry.bits;
+
+            char label[256];
+            if ( entry.id >= 0 )
+                snprintf( label, sizeof( label ), "%*s%s[%d]", entry.depth * 2, "", entry.name, entry.id );
+            else
+                snprintf( label, sizeof( label ), "%*s%s", entry.depth * 2, "", entry.name );
+
+            fprintf( file, "%-48s %10llu %14llu %10.1f %6.1f%% %8llu %8llu  ",
+                label,
+                (unsigned long long) entry.count,
+                (unsigned long long) entry.bits,
+                entry.count ? double( entry.bits ) / entry.count : 0.0,
+                parentBits ? 100.0 * entry.bits / parentBits : 0.0,
+                (unsigned long long) ( entry.count ? entry.minBits : 0 ),
+                (unsigned long long) entry.maxBits );
+
+            int lastBucket = 0;
+            for ( int i = 0; i < NumStreamStatsBuckets; ++i )
+            {
+                if ( entry.histogram[i] )
+                    lastBucket = i;
+            }
+
+            for ( int i = 0; i <= lastBucket; ++i )
+                fprintf( file, "%s%llu", i ? "," : "", (unsigned long long) entry.histogram[i] );
+
+            fprintf( file, "\n" );
+
+            // children in the order they were first seen
+
+            for ( int i = index + 1; i < s_numEntries; ++i )
+            {
+                if ( s_entries[i].parent == index )
+                    dump_entry( file, i );
+            }
+        }
+
+        void dump( FILE * file )
+        {
+            CORE_ASSERT( file );
+
+            fprintf( file, "%-48s %10s %14s %10s %7s %8s %8s  %s\n", "scope", "count", "bits", "avg", "parent", "min", "max", "histogram (0,1,2-3,4-7...)" );
+
+            for ( int i = 0; i < s_numEntries; ++i )
+            {
+                if ( s_entries[i].parent < 0 )
+                    dump_entry( file, i );
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+// Protocol Library - Copyright (c) 2008-2015, Glenn Fiedler
+
+#ifndef PROTOCOL_STREAM_STATS_H
+#define PROTOCOL_STREAM_STATS_H
+
+#include "core/Core.h"
+#include "protocol/Config.h"
+#include <stdio.h>
+
+namespace protocol
+{
+    const int MaxStreamStatsScopes = 512;
+    const int NumStreamStatsBuckets = 24;
+
+    /*
+        Per-scope bit accounting. Each time a scope is entered while writing,
+        the bits written inside it are added to the scope entry for its name
+        (and id, eg. channel index or message type) under its parent scope.
+        Totals include child scopes. The histogram counts entries by bits
+        written, in power of two buckets: 0, 1, 2-3, 4-7, 8-15...
+    */
+
+    struct StreamStatsEntry
+    {
+        const char * name;
+        int id;
+        int parent;
+        int depth;
+        uint64_t count;
+        uint64_t bits;
+        uint64_t minBits;
+        uint64_t maxBits;
+        uint64_t histogram[NumStreamStatsBuckets];
+    };
+
+    namespace stream_stats
+    {
+        int begin( const char * name, int id = -1 );
+
+        void end( int index, int bits );
+
+        void reset();
+
+        int get_num_entries();
+
+        const StreamStatsEntry & get_entry( int index );
+
+        int find( const char * name, int id = -1, int parent = -1 );
+
+        void count_measure_streams( bool value );
+
+        bool is_counting_measure_streams();
+
+        void dump( FILE * file = stdout );
+    }
+
+    class WriteStream;
+    class MeasureStream;
+
+    template <typename Stream> struct StreamStatsTraits { static bool Enabled() { return false; } };
+
+    template <> struct StreamStatsTraits<WriteStream> { static bool Enabled() { return true; } };
+
+    // IMPORTANT: measure streams are used internally to budget messages, so they only count when asked to
+
+    template <> struct StreamStatsTraits<MeasureStream> { static bool Enabled() { return stream_stats::is_counting_measure_streams(); } };
+
+    template <typename Stream> class StreamScope
+    {
+    public:
+
+        StreamScope( Stream & stream, const char * name, int id = -1 ) : m_stream( stream ), m_index( -1 ), m_start( 0 )
+        {
+            if ( StreamStatsTraits<Stream>::Enabled() )
+            {
+                m_index = stream_stats::begin( name, id );
+                m_start = stream.GetBitsProcessed();
+            }
+        }
+
+        ~StreamScope()
+        {
+            if ( m_index >= 0 )
+                stream_stats::end( m_index, m_stream.GetBitsProcessed() - m_start );
+        }
+
+    private:
+
+        Stream & m_stream;
+        int m_index;
+        int m_start;
+
+        StreamScope( const StreamScope & other );
+        StreamScope & operator = ( const StreamScope & other );
+    };
+}
+
+#define PROTOCOL_STREAM_SCOPE_CONCAT2( a, b ) a##b
+#define PROTOCOL_STREAM_SCOPE_CONCAT( a, b ) PROTOCOL_STREAM_SCOPE_CONCAT2( a, b )
+
+#if PROTOCOL_STREAM_STATS
+
+#define serialize_scope( stream, name ) \
+    protocol::StreamScope<Stream> PROTOCOL_STREAM_SCOPE_CONCAT( stream_scope_, __LINE__ )( stream, name )
+
+#define serialize_scope_id( stream, name, id ) \
+    protocol::StreamScope<Stream> PROTOCOL_STREAM_SCOPE_CONCAT( stream_scope_, __LINE__ )( stream, name, id )
+
+#else // #if PROTOCOL_STREAM_STATS
+
+#define serialize_scope( stream, name ) do {} while (0)
+
+#define serialize_scope_id( stream, name, id ) do {} while (0)
+
+#endif // #if PROTOCOL_STREAM_STATS
+
+#endif
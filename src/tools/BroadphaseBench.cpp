@@ -0,0 +1,143 @@
+// Tools - Copyright (c) 2008-2015, Glenn Fiedler
+
+/*
+    Headless benchmark comparing broadphase choices for the cubes simulation.
+
+    Lays out an N x N field of cubes on a plane, one unit apart like the
+    CubesInternal scene, and measures the time spent in dSpaceCollide
+    (collision plus building interactions) for each broadphase. Runs the
+    30x30 field the game uses and a scaled up 100x100 field by default.
+
+        BroadphaseBench [frames] [field size...]
+
+    Cubes are nudged every frame so the field never settles and the
+    comparison includes moving geoms, not just a static tree.
+*/
+
+#include "core/Core.h"
+#include "cubes/Simulation.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const float DeltaTime = 1.0f / 60.0f;
+static const int WarmupFrames = 30;
+
+struct BroadphaseInfo
+{
+    const char * name;
+    cubes::SimulationBroadphase broadphase;
+};
+
+static const BroadphaseInfo Broadphases[] =
+{
+    { "quad tree",       cubes::BROADPHASE_QuadTree },
+    { "hash",            cubes::BROADPHASE_Hash },
+    { "sweep and prune", cubes::BROADPHASE_SweepAndPrune },
+};
+
+static void run( const BroadphaseInfo & info, int fieldSize, int numFrames )
+{
+    const float cubeSize = 0.4f;
+    const float origin = -fieldSize / 2.0f;
+
+    cubes::SimulationConfig config;
+    config.Broadphase = info.broadphase;
+    config.QuadTreeExtents = math::Vector( fieldSize, fieldSize, 10 );
+    config.SweepAxes = cubes::SWEEP_AXES_XYZ;
+
+    cubes::Simulation simulation;
+    simulation.Initialize( config );
+    simulation.AddPlane( math::Vector(0,0,1), 0 );
+
+    const int numCubes = fieldSize * fieldSize;
+
+    int * ids = new int[numCubes];
+
+    cubes::SimulationObjectState state;
+    state.enabled = true;
+    state.scale = cubeSize;
+    state.orientation = math::Quaternion(1,0,0,0);
+    state.linearVelocity = math::Vector(0,0,0);
+    state.angularVelocity = math::Vector(0,0,0);
+
+    for ( int y = 0; y < fieldSize; ++y )
+    {
+        for ( int x = 0; x < fieldSize; ++x )
+        {
+            state.position = math::Vector( x + origin + 0.5f, y + origin + 0.5f, cubeSize / 2.0f );
+            ids[y*fieldSize+x] = simulation.AddObject( state );
+        }
+    }
+
+    double collideTime = 0.0;
+    double maxCollideTime = 0.0;
+    double stepTime = 0.0;
+    int numPairs = 0;
+
+    for ( int i = 0; i < WarmupFrames + numFrames; ++i )
+    {
+        // nudge a rotating subset of cubes so they stay awake and knock into each other
+
+        for ( int j = i % 8; j < numCubes; j += 8 )
+            simulation.ApplyForce( ids[j], math::Vector( ( j & 1 ) ? 30.0f : -30.0f, ( j & 2 ) ? 30.0f : -30.0f, 10.0f ) );
+
+        simulation.Update( DeltaTime );
+
+        if ( i < WarmupFrames )
+            continue;
+
+        collideTime += simulation.GetCollideTime();
+        stepTime += simulation.GetStepTime();
+        numPairs += simulation.GetNumInteractionPairs();
+        if ( simulation.GetCollideTime() > maxCollideTime )
+            maxCollideTime = simulation.GetCollideTime();
+    }
+
+    printf( "%16s: collide %.3f ms avg, %.3f ms max, step %.3f ms, %d pairs/frame\n",
+        info.name,
+        collideTime * 1000.0 / numFrames,
+        maxCollideTime * 1000.0,
+        stepTime * 1000.0 / numFrames,
+        numPairs / numFrames );
+
+    delete [] ids;
+}
+
+int main( int argc, char * argv[] )
+{
+    int numFrames = 300;
+    int fieldSizes[16] = { 30, 100 };
+    int numFieldSizes = 2;
+
+    if ( argc > 1 )
+        numFrames = atoi( argv[1] );
+
+    if ( argc > 2 )
+    {
+        numFieldSizes = 0;
+        for ( int i = 2; i < argc && numFieldSizes < 16; ++i )
+            fieldSizes[numFieldSizes++] = atoi( argv[i] );
+    }
+
+    for ( int i = 0; i < numFieldSizes; ++i )
+    {
+        if ( numFrames < 1 || fieldSizes[i] < 1 || fieldSizes[i] > 200 )
+        {
+            printf( "usage: BroadphaseBench [frames] [field size...]\n" );
+            printf( "field size must be in [1,200]\n" );
+            return 1;
+        }
+    }
+
+    for ( int i = 0; i < numFieldSizes; ++i )
+    {
+        printf( "%dx%d cubes, %d frames\n", fieldSizes[i], fieldSizes[i], numFrames );
+
+        for ( int j = 0; j < (int) ( sizeof( Broadphases ) / sizeof( Broadphases[0] ) ); ++j )
+            run( Broadphases[j], fieldSizes[i], numFrames );
+
+        printf( "\n" );
+    }
+
+    return 0;
+}
@@ -0,0 +1,329 @@
+// Tools - Copyright (c) 2008-2015, Glenn Fiedler
+
+/*
+    Microbenchmark for the cubes simulation pre-step velocity clamp.
+
+    Compares the per body scalar loop used by Simulation::Update against a
+    packed simd kernel that clamps four bodies at a time, both reading from
+    and writing back to bodies laid out like ODE bodies, with time at rest
+    kept per object like the simulation does. The packed time includes the
+    gather and the write back. The kernel time is the simd pass alone over
+    already packed velocities.
+
+        ClampBench [bodies] [iterations]
+
+    A fraction of bodies are over the speed limits and a fraction are at
+    rest, like a settling pile. Results are checked to match exactly.
+
+    This is a negative result. ODE keeps velocities per body, so gathering
+    them dominates, and the packed path only breaks even past 12k-16k awake
+    bodies. The demos run around a thousand, so the simulation keeps the
+    scalar loop and the kernel lives here.
+*/
+
+#include "core/Core.h"
+#include "cubes/Config.h"
+#include "vectorial/simd4f.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+static const float DeltaTime = 1.0f / 60.0f;
+static const float RestThresholdSquared = 0.25f * 0.25f;
+
+struct Body
+{
+    float linearVelocity[4];
+    float angularVelocity[4];
+    float other[24];                // rest of the body, so bodies are spread over memory like in ode
+};
+
+struct Object
+{
+    Body * body;
+    float timeAtRest;
+    float other[6];                 // rest of the per object data kept by the simulation
+};
+
+// velocities and time at rest packed per body, padded to a multiple of four for simd
+
+struct PackedVelocities
+{
+    int count;
+    std::vector<float> linearX, linearY, linearZ;
+    std::vector<float> angularX, angularY, angularZ;
+    std::vector<float> linearScale;
+    std::vector<float> angularScale;
+    std::vector<float> timeAtRest;
+
+    PackedVelocities()
+    {
+        count = 0;
+    }
+
+    void Resize( int count )
+    {
+        this->count = count;
+        const int padded = ( count + 3 ) & ~3;
+        linearX.resize( padded );
+        linearY.resize( padded );
+        linearZ.resize( padded );
+        angularX.resize( padded );
+        angularY.resize( padded );
+        angularZ.resize( padded );
+        linearScale.resize( padded );
+        angularScale.resize( padded );
+        timeAtRest.resize( padded );
+    }
+};
+
+// clamps velocities to MaxLinearSpeed/MaxAngularSpeed in place and accumulates time at rest,
+// tested against the unclamped speeds. velocities that changed have a scale less than one
+
+static void clamp_velocities( PackedVelocities & velocities, float deltaTime, float linearRestThresholdSquared, float angularRestThresholdSquared )
+{
+    const int count = velocities.count;
+    if ( count == 0 )
+        return;
+
+    float * linearX = &velocities.linearX[0];
+    float * linearY = &velocities.linearY[0];
+    float * linearZ = &velocities.linearZ[0];
+    float * angularX = &velocities.angularX[0];
+    float * angularY = &velocities.angularY[0];
+    float * angularZ = &velocities.angularZ[0];
+    float * linearScale = &velocities.linearScale[0];
+    float * angularScale = &velocities.angularScale[0];
+    float * timeAtRest = &velocities.timeAtRest[0];
+
+    // four bodies at a time. scale is max speed / max(speed,max speed), which is exactly one
+    // for bodies under the limit, so unclamped velocities come out bit for bit unchanged
+
+    const simd4f maxLinearSpeed = simd4f_splat( MaxLinearSpeed );
+    const simd4f maxAngularSpeed = simd4f_splat( MaxAngularSpeed );
+    const simd4f linearRest = simd4f_splat( linearRestThresholdSquared );
+    const simd4f angularRest = simd4f_splat( angularRestThresholdSquared );
+    const simd4f dt = simd4f_splat( deltaTime );
+
+    for ( int i = 0; i < count; i += 4 )
+    {
+        const simd4f vx = simd4f_uload4( linearX + i );
+        const simd4f vy = simd4f_uload4( linearY + i );
+        const simd4f vz = simd4f_uload4( linearZ + i );
+        const simd4f wx = simd4f_uload4( angularX + i );
+        const simd4f wy = simd4f_uload4( angularY + i );
+        const simd4f wz = simd4f_uload4( angularZ + i );
+
+        const simd4f linearSquared = simd4f_add( simd4f_add( simd4f_mul( vx, vx ), simd4f_mul( vy, vy ) ), simd4f_mul( vz, vz ) );
+        const simd4f angularSquared = simd4f_add( simd4f_add( simd4f_mul( wx, wx ), simd4f_mul( wy, wy ) ), simd4f_mul( wz, wz ) );
+
+        const simd4f linearFactor = simd4f_div( maxLinearSpeed, simd4f_max( simd4f_sqrt( linearSquared ), maxLinearSpeed ) );
+        const simd4f angularFactor = simd4f_div( maxAngularSpeed, simd4f_max( simd4f_sqrt( angularSquared ), maxAngularSpeed ) );
+
+        simd4f_ustore4( simd4f_mul( vx, linearFactor ), linearX + i );
+        simd4f_ustore4( simd4f_mul( vy, linearFactor ), linearY + i );
+        simd4f_ustore4( simd4f_mul( vz, linearFactor ), linearZ + i );
+        simd4f_ustore4( simd4f_mul( wx, angularFactor ), angularX + i );
+        simd4f_ustore4( simd4f_mul( wy, angularFactor ), angularY + i );
+        simd4f_ustore4( simd4f_mul( wz, angularFactor ), angularZ + i );
+        simd4f_ustore4( linearFactor, linearScale + i );
+        simd4f_ustore4( angularFactor, angularScale + i );
+
+        // time at rest accumulates while both speeds are under threshold, otherwise resets to zero
+
+        const simd4f atRest = simd4f_and( simd4f_less( linearSquared, linearRest ), simd4f_less( angularSquared, angularRest ) );
+
+        simd4f_ustore4( simd4f_and( atRest, simd4f_add( simd4f_uload4( timeAtRest + i ), dt ) ), timeAtRest + i );
+    }
+}
+
+static float random_float( float min, float max )
+{
+    return min + ( max - min ) * ( rand() / (float) RAND_MAX );
+}
+
+static void init_objects( Object * objects, Body * bodies, int count )
+{
+    srand( 1 );
+
+    for ( int i = 0; i < count; ++i )
+    {
+        memset( &bodies[i], 0, sizeof( Body ) );
+        memset( &objects[i], 0, sizeof( Object ) );
+
+        // one in eight too fast, half nearly at rest, the rest moving normally
+
+        const int kind = rand() % 8;
+        const float speed = kind == 0 ? 64.0f : ( kind < 4 ? 4.0f : 0.1f );
+
+        for ( int j = 0; j < 3; ++j )
+        {
+            bodies[i].linearVelocity[j] = random_float( -speed, speed );
+            bodies[i].angularVelocity[j] = random_float( -speed, speed );
+        }
+
+        objects[i].body = &bodies[i];
+        objects[i].timeAtRest = ( i % 3 ) * DeltaTime;
+    }
+}
+
+static void clamp_scalar( Object * objects, int count )
+{
+    for ( int i = 0; i < count; ++i )
+    {
+        float * linearVelocity = objects[i].body->linearVelocity;
+        float * angularVelocity = objects[i].body->angularVelocity;
+
+        const float linearVelocityLengthSquared = linearVelocity[0]*linearVelocity[0] + linearVelocity[1]*linearVelocity[1] + linearVelocity[2]*linearVelocity[2];
+        const float angularVelocityLengthSquared = angularVelocity[0]*angularVelocity[0] + angularVelocity[1]*angularVelocity[1] + angularVelocity[2]*angularVelocity[2];
+
+        if ( linearVelocityLengthSquared > MaxLinearSpeed * MaxLinearSpeed )
+        {
+            const float scale = MaxLinearSpeed / sqrtf( linearVelocityLengthSquared );
+            linearVelocity[0] *= scale;
+            linearVelocity[1] *= scale;
+            linearVelocity[2] *= scale;
+        }
+
+        if ( angularVelocityLengthSquared > MaxAngularSpeed * MaxAngularSpeed )
+        {
+            const float scale = MaxAngularSpeed / sqrtf( angularVelocityLengthSquared );
+            angularVelocity[0] *= scale;
+            angularVelocity[1] *= scale;
+            angularVelocity[2] *= scale;
+        }
+
+        if ( linearVelocityLengthSquared < RestThresholdSquared && angularVelocityLengthSquared < RestThresholdSquared )
+            objects[i].timeAtRest += DeltaTime;
+        else
+            objects[i].timeAtRest = 0.0f;
+    }
+}
+
+static void clamp_packed( Object * objects, int count, PackedVelocities & velocities )
+{
+    velocities.Resize( count );
+
+    for ( int i = 0; i < count; ++i )
+    {
+        const Body * body = objects[i].body;
+        velocities.linearX[i] = body->linearVelocity[0];
+        velocities.linearY[i] = body->linearVelocity[1];
+        velocities.linearZ[i] = body->linearVelocity[2];
+        velocities.angularX[i] = body->angularVelocity[0];
+        velocities.angularY[i] = body->angularVelocity[1];
+        velocities.angularZ[i] = body->angularVelocity[2];
+        velocities.timeAtRest[i] = objects[i].timeAtRest;
+    }
+
+    clamp_velocities( velocities, DeltaTime, RestThresholdSquared, RestThresholdSquared );
+
+    for ( int i = 0; i < count; ++i )
+    {
+        Body * body = objects[i].body;
+
+        if ( velocities.linearScale[i] < 1.0f )
+        {
+            body->linearVelocity[0] = velocities.linearX[i];
+            body->linearVelocity[1] = velocities.linearY[i];
+            body->linearVelocity[2] = velocities.linearZ[i];
+        }
+
+        if ( velocities.angularScale[i] < 1.0f )
+        {
+            body->angularVelocity[0] = velocities.angularX[i];
+            body->angularVelocity[1] = velocities.angularY[i];
+            body->angularVelocity[2] = velocities.angularZ[i];
+        }
+
+        objects[i].timeAtRest = velocities.timeAtRest[i];
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    int numBodies = 1024;
+    int numIterations = 10000;
+
+    if ( argc > 1 )
+        numBodies = atoi( argv[1] );
+    if ( argc > 2 )
+        numIterations = atoi( argv[2] );
+
+    if ( numBodies < 1 || numIterations < 1 )
+    {
+        printf( "usage: ClampBench [bodies] [iterations]\n" );
+        return 1;
+    }
+
+    Body * scalarBodies = new Body[numBodies];
+    Body * packedBodies = new Body[numBodies];
+    Object * scalarObjects = new Object[numBodies];
+    Object * packedObjects = new Object[numBodies];
+
+    PackedVelocities velocities;
+
+    // check both versions give identical results over a few frames
+
+    init_objects( scalarObjects, scalarBodies, numBodies );
+    init_objects( packedObjects, packedBodies, numBodies );
+
+    for ( int i = 0; i < 4; ++i )
+    {
+        clamp_scalar( scalarObjects, numBodies );
+        clamp_packed( packedObjects, numBodies, velocities );
+    }
+
+    for ( int i = 0; i < numBodies; ++i )
+    {
+        if ( memcmp( scalarBodies[i].linearVelocity, packedBodies[i].linearVelocity, sizeof( float ) * 3 ) != 0 ||
+             memcmp( scalarBodies[i].angularVelocity, packedBodies[i].angularVelocity, sizeof( float ) * 3 ) != 0 ||
+             scalarObjects[i].timeAtRest != packedObjects[i].timeAtRest )
+        {
+            printf( "error: body %d differs between scalar and packed\n", i );
+            return 1;
+        }
+    }
+
+    // time them. bodies are reset each iteration so every run clamps the same velocities
+
+    double scalarTime = 0.0;
+    double packedTime = 0.0;
+    double kernelTime = 0.0;
+
+    for ( int i = 0; i < numIterations; ++i )
+    {
+        if ( ( i % 64 ) == 0 )
+        {
+            init_objects( scalarObjects, scalarBodies, numBodies );
+            init_objects( packedObjects, packedBodies, numBodies );
+        }
+
+        const double scalarStart = core::time();
+        clamp_scalar( scalarObjects, numBodies );
+        const double packedStart = core::time();
+        clamp_packed( packedObjects, numBodies, velocities );
+        const double packedFinish = core::time();
+
+        clamp_velocities( velocities, DeltaTime, RestThresholdSquared, RestThresholdSquared );
+        const double kernelFinish = core::time();
+
+        scalarTime += packedStart - scalarStart;
+        packedTime += packedFinish - packedStart;
+        kernelTime += kernelFinish - packedFinish;
+    }
+
+    printf( "%d bodies, %d iterations\n", numBodies, numIterations );
+    printf( "  scalar: %.3f us\n", scalarTime * 1000000.0 / numIterations );
+    printf( "  packed: %.3f us (%.2fx)\n", packedTime * 1000000.0 / numIterations, scalarTime / packedTime );
+    printf( "  kernel: %.3f us (%.2fx)\n", kernelTime * 1000000.0 / numIterations, scalarTime / kernelTime );
+
+    delete [] scalarBodies;
+    delete [] packedBodies;
+    delete [] scalarObjects;
+    delete [] packedObjects;
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Tools - Copyright (c) 2008-2015, Glenn Fiedler
+
+/*
+    Headless benchmark for stepping the cubes simulation.
+
+    Builds the same 30x30 cube scene as CubesInternal and runs it once for
+    each thread count from 1 to N, with the player cube pushing its way
+    around the grid. Every run sees identical input, so frame times are
+    directly comparable.
+
+        CubesBench [max threads] [frames]
+
+    Threads are handed to ODE, which steps independent islands in parallel.
+    Reports the average and worst frame time of GameInstance::Update.
+*/
+
+#include "core/Core.h"
+#include "core/Memory.h"
+#include "game/Cubes.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int WarmupFrames = 60;
+static const float DeltaTime = 1.0f / 60.0f;
+
+static void add_cube( GameInstance * game_instance, int player, const vectorial::vec3f & position )
+{
+    hypercube::DatabaseObject object;
+    cubes::CompressPosition( math::Vector( position.x(), position.y(), position.z() ), object.position );
+    cubes::CompressOrientation( math::Quaternion(1,0,0,0), object.orientation );
+    object.enabled = player;
+    object.session = 0;
+    object.player = player;
+    activation::ObjectId id = game_instance->AddObject( object, position.x(), position.y() );
+    if ( player )
+        game_instance->DisableObject( id );
+}
+
+static GameInstance * create_scene( int numThreads )
+{
+    // note: matches CubesInternal::Initialize so the benchmark steps the scene the game runs
+
+    game::Config config;
+
+    config.maxObjects = CubeSteps * CubeSteps + MaxPlayers + 1;
+    config.deactivationTime = 0.5f;
+    config.cellSize = 2.0f;
+    config.cellWidth = CubeSteps / config.cellSize + 2 * 2;
+    config.cellHeight = config.cellWidth;
+    config.activationDistance = 100.0f;
+
+    config.simConfig.ERP = 0.25f;
+    config.simConfig.CFM = 0.001f;
+    config.simConfig.MaxIterations = 32;
+    config.simConfig.WarmStarting = true;
+    config.simConfig.MaximumCorrectingVelocity = 250.0f;
+    config.simConfig.ContactSurfaceLayer = 0.01f;
+    config.simConfig.Elasticity = 0.0f;
+    config.simConfig.LinearDrag = 0.001f;
+    config.simConfig.AngularDrag = 0.001f;
+    config.simConfig.Friction = 200.0f;
+    config.simConfig.NumThreads = numThreads;
+
+    auto game_instance = new GameInstance( config );
+
+    game_instance->InitializeBegin();
+
+    game_instance->AddPlane( math::Vector(0,0,1), 0 );
+
+    add_cube( game_instance, 1, vectorial::vec3f(0,0,10) );
+
+    const float origin = -CubeSteps / 2.0f;
+    const float z = hypercube::NonPlayerCubeSize / 2.0f;
+    for ( int y = 0; y < CubeSteps; ++y )
+        for ( int x = 0; x < CubeSteps; ++x )
+            add_cube( game_instance, 0, vectorial::vec3f(x+origin+0.5f,y+origin+0.5f,z) );
+
+    game_instance->InitializeEnd();
+
+    game_instance->OnPlayerJoined( 0 );
+    game_instance->SetLocalPlayer( 0 );
+    game_instance->SetPlayerFocus( 0, 1 );
+
+    game_instance->SetFlag( game::FLAG_Push );
+    game_instance->SetFlag( game::FLAG_Pull );
+
+    return game_instance;
+}
+
+static game::Input get_input( int frame )
+{
+    // roll in a square around the grid, pushing all the way
+
+    game::Input input;
+    input.push = true;
+    switch ( ( frame / 120 ) % 4 )
+    {
+        case 0: input.up = true;    break;
+        case 1: input.right = true; break;
+        case 2: input.down = true;  break;
+        case 3: input.left = true;  break;
+    }
+    return input;
+}
+
+int main( int argc, char * argv[] )
+{
+    int maxThreads = 4;
+    int numFrames = 600;
+
+    if ( argc > 1 )
+        maxThreads = atoi( argv[1] );
+    if ( argc > 2 )
+        numFrames = atoi( argv[2] );
+
+    if ( maxThreads < 1 || numFrames < 1 )
+    {
+        printf( "usage: CubesBench [max threads] [frames]\n" );
+        return 1;
+    }
+
+    printf( "%d cubes, %d frames, 1..%d threads\n\n", CubeSteps * CubeSteps, numFrames, maxThreads );
+
+    double baseline = 0.0;
+
+    for ( int numThreads = 1; numThreads <= maxThreads; ++numThreads )
+    {
+        auto game_instance = create_scene( numThreads );
+
+        for ( int i = 0; i < WarmupFrames; ++i )
+        {
+            game_instance->SetPlayerInput( 0, get_input( i ) );
+            game_instance->Update( DeltaTime );
+        }
+
+        double totalTime = 0.0;
+        double maxTime = 0.0;
+
+        for ( int i = 0; i < numFrames; ++i )
+        {
+            game_instance->SetPlayerInput( 0, get_input( WarmupFrames + i ) );
+
+            const double start = core::time();
+
+            game_instance->Update( DeltaTime );
+
+            const double frameTime = core::time() - start;
+
+            totalTime += frameTime;
+            if ( frameTime > maxTime )
+                maxTime = frameTime;
+        }
+
+        const double average = totalTime / numFrames;
+
+        if ( numThreads == 1 )
+            baseline = average;
+
+        printf( "%2d threads: %.3f ms/frame avg, %.3f ms max, %.2fx\n",
+            numThreads, average * 1000.0, maxTime * 1000.0, baseline / average );
+
+        delete game_instance;
+    }
+
+    return 0;
+}
@@ -0,0 +1,546 @@
+// Tools - Copyright (c) 2008-2015, Glenn Fiedler
+
+/*
+    Headless load generator for the client/server library.
+
+    Runs thousands of client state machines against a server and drives
+    test message traffic over each connection with the game message factory.
+    Reports connect latency, message throughput, server side counters and
+    the time spent in Server::Update.
+
+        LoadGen [clients] [seconds] [messages per second] [server address]
+
+    By default the server runs in process and every client talks to it over
+    a loopback network, so the client count is not limited by sockets and
+    the run is a repeatable benchmark of Server::Update. Time is simulated
+    at 60 frames per second and the loop runs as fast as it can.
+
+    If a server address is given, each client opens its own UDP socket and
+    connects to that server in real time instead. The server identifies
+    clients by address, so clients can't share a socket.
+*/
+
+#include "core/Core.h"
+#include "core/Memory.h"
+#include "network/Network.h"
+#include "network/BSDSocket.h"
+#include "network/Loopback.h"
+#include "protocol/ReliableMessageChannel.h"
+#include "ClientServer/Client.h"
+#include "ClientServer/Server.h"
+#include "game/GameMessages.h"
+#include "game/GamePackets.h"
+#include "game/GameChannelStructure.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int MaxClients = 32 * 1024;
+static const int MaxPacketSize = 1200;
+static const int ServerPort = 10000;
+static const int BaseClientPort = 20000;
+static const double DeltaTime = 1.0 / 60.0;
+
+class LoadGenClient : public clientServer::Client
+{
+public:
+
+    LoadGenClient( const clientServer::ClientConfig & config ) : Client( config ) {}
+
+    const GameContext * GetGameContext() const
+    {
+        const protocol::Block * block = GetServerData();
+        return block ? (const GameContext*) block->GetData() : nullptr;
+    }
+
+protected:
+
+    void OnServerDataReceived( const protocol::Block & block ) override
+    {
+        SetContext( clientServer::CONTEXT_USER, block.GetData() );
+    }
+};
+
+class LoadGenServer : public clientServer::Server
+{
+public:
+
+    LoadGenServer( const clientServer::ServerConfig & config ) : Server( config )
+    {
+        CORE_ASSERT( config.serverData );
+        SetContext( clientServer::CONTEXT_USER, config.serverData->GetData() );
+    }
+};
+
+struct LoadGenClientInfo
+{
+    LoadGenClient * client = nullptr;
+    network::Interface * networkInterface = nullptr;
+    double connectStartTime = 0.0;
+    double sendAccumulator = 0.0;
+    uint16_t sendSequence = 0;
+    int state = clientServer::CLIENT_STATE_DISCONNECTED;
+};
+
+struct LoadGenStats
+{
+    int numConnects = 0;
+    int numConnectFailures = 0;
+    int numDisconnects = 0;
+    double totalConnectTime = 0.0;
+    double minConnectTime = 0.0;
+    double maxConnectTime = 0.0;
+
+    uint64_t clientMessagesSent = 0;
+    uint64_t clientMessagesReceived = 0;
+    uint64_t serverMessagesReceived = 0;
+
+    uint64_t serverUpdateNanoseconds = 0;
+    uint64_t maxServerUpdateNanoseconds = 0;
+    uint64_t clientUpdateNanoseconds = 0;
+    int numFrames = 0;
+};
+
+static void update_server_messages( clientServer::Server & server, GameMessageFactory & messageFactory, LoadGenStats & stats )
+{
+    // echo every message back to the client that sent it
+
+    const int maxClients = server.GetConfig().maxClients;
+
+    for ( int i = 0; i < maxClients; ++i )
+    {
+        if ( server.GetClientState( i ) != clientServer::SERVER_CLIENT_STATE_CONNECTED )
+            continue;
+
+        auto connection = server.GetClientConnection( i );
+        auto messageChannel = static_cast<protocol::ReliableMessageChannel*>( connection->GetChannel( 0 ) );
+
+        while ( messageChannel->CanSendMessage() )
+        {
+            auto message = messageChannel->ReceiveMessage();
+            if ( !message )
+                break;
+
+            CORE_ASSERT( message->GetType() == MESSAGE_TEST );
+
+            auto testMessage = (TestMessage*) message;
+
+            auto replyMessage = (TestMessage*) messageFactory.Create( MESSAGE_TEST );
+            CORE_ASSERT( replyMessage );
+            replyMessage->sequence = testMessage->sequence;
+            replyMessage->value = testMessage->value;
+            messageChannel->SendMessage( replyMessage );
+
+            messageFactory.Release( message );
+
+            stats.serverMessagesReceived++;
+        }
+    }
+}
+
+static void update_client_messages( LoadGenClientInfo & info, GameMessageFactory & messageFactory, double messageRate, LoadGenStats & stats )
+{
+    auto gameContext = info.client->GetGameContext();
+    auto connection = info.client->GetConnection();
+    auto messageChannel = static_cast<protocol::ReliableMessageChannel*>( connection->GetChannel( 0 ) );
+
+    info.sendAccumulator += messageRate * DeltaTime;
+
+    while ( info.sendAccumulator >= 1.0 && messageChannel->CanSendMessage() )
+    {
+        auto message = (TestMessage*) messageFactory.Create( MESSAGE_TEST );
+        CORE_ASSERT( message );
+        message->sequence = info.sendSequence++;
+        message->value = core::random_int( gameContext->value_min, gameContext->value_max );
+        messageChannel->SendMessage( message );
+        info.sendAccumulator -= 1.0;
+        stats.clientMessagesSent++;
+    }
+
+    // IMPORTANT: don't let a backed up channel build an unbounded burst
+
+    info.sendAccumulator = core::min( info.sendAccumulator, 1.0 );
+
+    while ( true )
+    {
+        auto message = messageChannel->ReceiveMessage();
+        if ( !message )
+            break;
+        messageFactory.Release( message );
+        stats.clientMessagesReceived++;
+    }
+}
+
+static void update_client_state( LoadGenClientInfo & info, double time, LoadGenStats & stats )
+{
+    const int previous = info.state;
+    const int current = info.state = info.client->GetState();
+
+    if ( current == previous )
+        return;
+
+    if ( current == clientServer::CLIENT_STATE_CONNECTED )
+    {
+        const double connectTime = time - info.connectStartTime;
+        if ( stats.numConnects == 0 || connectTime < stats.minConnectTime )
+            stats.minConnectTime = connectTime;
+        if ( stats.numConnects == 0 || connectTime > stats.maxConnectTime )
+            stats.maxConnectTime = connectTime;
+        stats.totalConnectTime += connectTime;
+        stats.numConnects++;
+    }
+    else if ( current == clientServer::CLIENT_STATE_DISCONNECTED )
+    {
+        if ( previous == clientServer::CLIENT_STATE_CONNECTED )
+            stats.numDisconnects++;
+        else
+            stats.numConnectFailures++;
+    }
+}
+
+static void print_report( const LoadGenStats & stats, int numClients, int numConnected, double seconds, const clientServer::Server * server, const network::LoopbackInterface * serverInterface )
+{
+    printf( "\nclients: %d connected, %d total\n", numConnected, numClients );
+
+    printf( "connects: %d ok, %d failed, %d disconnected after connect\n", stats.numConnects, stats.numConnectFailures, stats.numDisconnects );
+
+    if ( stats.numConnects > 0 )
+    {
+        printf( "connect latency: avg %.1f ms, min %.1f ms, max %.1f ms\n",
+            1000.0 * stats.totalConnectTime / stats.numConnects,
+            1000.0 * stats.minConnectTime,
+            1000.0 * stats.maxConnectTime );
+    }
+
+    printf( "client messages: %llu sent (%.1f/sec), %llu echoes received (%.1f/sec)\n",
+        (unsigned long long) stats.clientMessagesSent, stats.clientMessagesSent / seconds,
+        (unsigned long long) stats.clientMessagesReceived, stats.clientMessagesReceived / seconds );
+
+    if ( stats.numFrames > 0 )
+    {
+        printf( "client update: %.3f ms/frame\n", stats.clientUpdateNanoseconds / 1000000.0 / stats.numFrames );
+    }
+
+    if ( !server )
+        return;
+
+    printf( "server messages: %llu received (%.1f/sec)\n", (unsigned long long) stats.serverMessagesReceived, stats.serverMessagesReceived / seconds );
+
+    if ( stats.numFrames > 0 )
+    {
+        printf( "server update: %.3f ms/frame avg, %.3f ms max over %d frames\n",
+            stats.serverUpdateNanoseconds / 1000000.0 / stats.numFrames,
+            stats.maxServerUpdateNanoseconds / 1000000.0,
+            stats.numFrames );
+    }
+
+    // connection counters summed over the server's connected client slots
+
+    uint64_t connectionCounters[protocol::CONNECTION_COUNTER_NUM_COUNTERS];
+    uint64_t channelCounters[protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_NUM_COUNTERS];
+    memset( connectionCounters, 0, sizeof( connectionCounters ) );
+    memset( channelCounters, 0, sizeof( channelCounters ) );
+
+    const int maxClients = server->GetConfig().maxClients;
+    for ( int i = 0; i < maxClients; ++i )
+    {
+        if ( server->GetClientState( i ) != clientServer::SERVER_CLIENT_STATE_CONNECTED )
+            continue;
+
+        auto connection = const_cast<clientServer::Server*>( server )->GetClientConnection( i );
+        for ( int j = 0; j < protocol::CONNECTION_COUNTER_NUM_COUNTERS; ++j )
+            connectionCounters[j] += connection->GetCounter( j );
+
+        auto messageChannel = static_cast<protocol::ReliableMessageChannel*>( connection->GetChannel( 0 ) );
+        for ( int j = 0; j < protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_NUM_COUNTERS; ++j )
+            channelCounters[j] += messageChannel->GetCounter( j );
+    }
+
+    printf( "server connections: %llu packets read, %llu written, %llu acked, %llu discarded, %llu lost\n",
+        (unsigned long long) connectionCounters[protocol::CONNECTION_COUNTER_PACKETS_READ],
+        (unsigned long long) connectionCounters[protocol::CONNECTION_COUNTER_PACKETS_WRITTEN],
+        (unsigned long long) connectionCounters[protocol::CONNECTION_COUNTER_PACKETS_ACKED],
+        (unsigned long long) connectionCounters[protocol::CONNECTION_COUNTER_PACKETS_DISCARDED],
+        (unsigned long long) connectionCounters[protocol::CONNECTION_COUNTER_PACKETS_LOST] );
+
+    printf( "server channels: %llu messages sent, %llu written, %llu read, %llu received, %llu late, %llu early\n",
+        (unsigned long long) channelCounters[protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_SENT],
+        (unsigned long long) channelCounters[protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_WRITTEN],
+        (unsigned long long) channelCounters[protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_READ],
+        (unsigned long long) channelCounters[protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_RECEIVED],
+        (unsigned long long) channelCounters[protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_LATE],
+        (unsigned long long) channelCounters[protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_EARLY] );
+
+    if ( serverInterface )
+    {
+        printf( "server interface: %llu packets sent, %llu received, %llu dropped (receive queue full)\n",
+            (unsigned long long) serverInterface->GetCounter( network::LOOPBACK_COUNTER_PACKETS_SENT ),
+            (unsigned long long) serverInterface->GetCounter( network::LOOPBACK_COUNTER_PACKETS_RECEIVED ),
+            (unsigned long long) serverInterface->GetCounter( network::LOOPBACK_COUNTER_RECEIVE_QUEUE_FULL ) );
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    const int numClients = argc > 1 ? atoi( argv[1] ) : 1024;
+    const double seconds = argc > 2 ? atof( argv[2] ) : 10.0;
+    const double messageRate = argc > 3 ? atof( argv[3] ) : 10.0;
+    const char * serverAddressString = argc > 4 ? argv[4] : nullptr;
+
+    if ( numClients <= 0 || numClients > MaxClients || seconds <= 0.0 || messageRate < 0.0 )
+    {
+        printf( "usage: LoadGen [clients] [seconds] [messages per second] [server address]\n" );
+        printf( "clients must be in [1,%d]\n", MaxClients );
+        return 1;
+    }
+
+    const bool inProcess = serverAddressString == nullptr;
+
+    if ( inProcess && BaseClientPort + numClients > 65535 )
+    {
+        printf( "error: too many clients for in process mode\n" );
+        return 1;
+    }
+
+    srand( 0 );
+
+    core::memory::initialize();
+
+    if ( !network::InitializeNetwork() )
+    {
+        printf( "error: failed to initialize network\n" );
+        return 1;
+    }
+
+    int result = 0;
+
+    {
+        core::Allocator & allocator = core::memory::default_allocator();
+
+        GamePacketFactory packetFactory( allocator );
+
+        GameMessageFactory messageFactory( allocator );
+
+        GameChannelStructure channelStructure( messageFactory );
+
+        // in process server on a loopback network
+
+        network::Address serverAddress;
+
+        network::LoopbackNetwork * loopbackNetwork = nullptr;
+        network::LoopbackInterface * serverInterface = nullptr;
+        protocol::Block * serverData = nullptr;
+        LoadGenServer * server = nullptr;
+
+        if ( inProcess )
+        {
+            serverAddress = network::Address( "::1" );
+            serverAddress.SetPort( ServerPort );
+
+            loopbackNetwork = CORE_NEW( allocator, network::LoopbackNetwork, allocator, MaxPacketSize );
+
+            network::LoopbackConfig loopbackConfig;
+            loopbackConfig.network = loopbackNetwork;
+            loopbackConfig.address = serverAddress;
+            loopbackConfig.receiveQueueSize = core::max( 256, numClients * 4 );
+            loopbackConfig.packetFactory = &packetFactory;
+            serverInterface = CORE_NEW( allocator, network::LoopbackInterface, loopbackConfig );
+
+            // same server data as the game server so connect cost matches
+
+            const int serverDataSize = sizeof(GameContext) + 10 * 1024 + 11;
+            serverData = CORE_NEW( allocator, protocol::Block, allocator, serverDataSize );
+            {
+                uint8_t * data = serverData->GetData();
+                for ( int i = 0; i < serverDataSize; ++i )
+                    data[i] = ( 10 + i ) % 256;
+
+                auto gameContext = (GameContext*) data;
+                gameContext->value_min = -1 - ( rand() % 100000000 );
+                gameContext->value_max = rand() % 1000000000;
+            }
+
+            clientServer::ServerConfig serverConfig;
+            serverConfig.serverData = serverData;
+            serverConfig.maxClients = numClients;
+            serverConfig.channelStructure = &channelStructure;
+            serverConfig.networkInterface = serverInterface;
+
+            server = CORE_NEW( allocator, LoadGenServer, serverConfig );
+        }
+        else
+        {
+            serverAddress = network::Address( serverAddressString );
+            if ( !serverAddress.IsValid() )
+            {
+                printf( "error: invalid server address %s\n", serverAddressString );
+                result = 1;
+            }
+            else if ( serverAddress.GetPort() == 0 )
+            {
+                serverAddress.SetPort( ServerPort );
+            }
+        }
+
+        // create clients
+
+        const int clientDataSize = 4096 + 21;
+        protocol::Block clientData( allocator, clientDataSize );
+        {
+            uint8_t * data = clientData.GetData();
+            for ( int i = 0; i < clientDataSize; ++i )
+                data[i] = ( 20 + i ) % 256;
+        }
+
+        LoadGenClientInfo * clientInfo = CORE_NEW_ARRAY( allocator, LoadGenClientInfo, numClients );
+
+        for ( int i = 0; i < numClients && result == 0; ++i )
+        {
+            if ( inProcess )
+            {
+                network::LoopbackConfig loopbackConfig;
+                loopbackConfig.network = loopbackNetwork;
+                loopbackConfig.address = serverAddress;
+                loopbackConfig.address.SetPort( BaseClientPort + i );
+                loopbackConfig.packetFactory = &packetFactory;
+                clientInfo[i].networkInterface = CORE_NEW( allocator, network::LoopbackInterface, loopbackConfig );
+            }
+            else
+            {
+                network::BSDSocketConfig bsdSocketConfig;
+                bsdSocketConfig.port = 0;
+                bsdSocketConfig.ipv6 = serverAddress.GetType() == network::ADDRESS_IPV6;
+                bsdSocketConfig.maxPacketSize = MaxPacketSize;
+                bsdSocketConfig.packetFactory = &packetFactory;
+                bsdSocketConfig.coalescePackets = true;             // IMPORTANT: must match the game server
+                auto socket = CORE_NEW( allocator, network::BSDSocket, bsdSocketConfig );
+                clientInfo[i].networkInterface = socket;
+                if ( socket->GetError() )
+                {
+                    printf( "error: failed to create socket for client %d\n", i );
+                    result = 1;
+                }
+            }
+
+            clientServer::ClientConfig clientConfig;
+            clientConfig.clientData = &clientData;
+            clientConfig.channelStructure = &channelStructure;
+            clientConfig.networkInterface = clientInfo[i].networkInterface;
+
+            clientInfo[i].client = CORE_NEW( allocator, LoadGenClient, clientConfig );
+        }
+
+        if ( result == 0 )
+        {
+            printf( "%d clients, %.1f seconds, %.1f messages per second per client, %s\n",
+                numClients, seconds, messageRate, inProcess ? "in process server" : serverAddressString );
+
+            LoadGenStats stats;
+
+            core::TimeBase timeBase;
+            timeBase.deltaTime = DeltaTime;
+
+            for ( int i = 0; i < numClients; ++i )
+            {
+                clientInfo[i].client->Connect( serverAddress );
+                clientInfo[i].connectStartTime = timeBase.time;
+            }
+
+            const uint64_t startNanoseconds = core::nanoseconds();
+
+            int numConnected = 0;
+
+            while ( timeBase.time < seconds )
+            {
+                if ( server )
+                {
+                    const uint64_t serverStart = core::nanoseconds();
+
+                    server->Update( timeBase );
+
+                    update_server_messages( *server, messageFactory, stats );
+
+                    const uint64_t serverNanoseconds = core::nanoseconds() - serverStart;
+                    stats.serverUpdateNanoseconds += serverNanoseconds;
+                    stats.maxServerUpdateNanoseconds = core::max( stats.maxServerUpdateNanoseconds, serverNanoseconds );
+                }
+
+                const uint64_t clientStart = core::nanoseconds();
+
+                numConnected = 0;
+
+                for ( int i = 0; i < numClients; ++i )
+                {
+                    LoadGenClientInfo & info = clientInfo[i];
+
+                    info.client->Update( timeBase );
+
+                    update_client_state( info, timeBase.time, stats );
+
+                    if ( info.client->IsConnected() )
+                    {
+                        update_client_messages( info, messageFactory, messageRate, stats );
+                        numConnected++;
+                    }
+                    else if ( info.client->IsDisconnected() )
+                    {
+                        info.client->ClearError();
+                        info.client->Connect( serverAddress );
+                        info.connectStartTime = timeBase.time;
+                        info.sendAccumulator = 0.0;
+                        info.sendSequence = 0;
+                    }
+                }
+
+                stats.clientUpdateNanoseconds += core::nanoseconds() - clientStart;
+
+                stats.numFrames++;
+
+                timeBase.time += timeBase.deltaTime;
+
+                if ( stats.numFrames % 60 == 0 )
+                    printf( "%.1f: %d/%d clients connected\n", timeBase.time, numConnected, numClients );
+
+                // against a remote server time must be real time
+
+                if ( !inProcess )
+                {
+                    const double elapsed = ( core::nanoseconds() - startNanoseconds ) / 1000000000.0;
+                    if ( elapsed < timeBase.time )
+                        core::sleep_milliseconds( uint32_t( ( timeBase.time - elapsed ) * 1000 ) );
+                }
+            }
+
+            const double wallSeconds = ( core::nanoseconds() - startNanoseconds ) / 1000000000.0;
+
+            printf( "\nsimulated %.1f seconds in %.2f seconds wall time\n", seconds, wallSeconds );
+
+            print_report( stats, numClients, numConnected, seconds, server, serverInterface );
+        }
+
+        typedef network::Interface NetworkInterface;
+
+        for ( int i = 0; i < numClients; ++i )
+        {
+            if ( clientInfo[i].client )
+                CORE_DELETE( allocator, LoadGenClient, clientInfo[i].client );
+            if ( clientInfo[i].networkInterface )
+                CORE_DELETE( allocator, NetworkInterface, clientInfo[i].networkInterface );
+        }
+
+        CORE_DELETE_ARRAY( allocator, clientInfo, numClients );
+
+        if ( server )
+        {
+            CORE_DELETE( allocator, LoadGenServer, server );
+            CORE_DELETE( allocator, Block, serverData );
+            CORE_DELETE( allocator, LoopbackInterface, serverInterface );
+            CORE_DELETE( allocator, LoopbackNetwork, loopbackNetwork );
+        }
+    }
+
+    network::ShutdownNetwork();
+
+    core::memory::shutdown();
+
+    return result;
+}
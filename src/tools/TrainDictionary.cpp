@@ -0,0 +1,140 @@
+// Tools - Copyright (c) 2008-2015, Glenn Fiedler
+
+/*
+    Trains a static packet compression dictionary from a packet capture.
+
+    Capture traffic by setting BSDSocketConfig::captureFile, then run:
+
+        TrainDictionary <capture file> <dictionary file> [dictionary size]
+
+    Load the dictionary file on both client and server and pass it in
+    BSDSocketConfig::compressionDictionary with compressPackets = true.
+*/
+
+#include "core/Core.h"
+#include "core/Memory.h"
+#include "network/Compressor.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int MaxCaptureBytes = 64 * 1024 * 1024;
+static const int MaxCapturePackets = 1024 * 1024;
+static const int MaxPacketBytes = 64 * 1024;
+
+static void report( const network::Compressor & compressor, const uint8_t * data, const int * sizes, int numPackets, const char * label )
+{
+    uint8_t compressed[MaxPacketBytes];
+
+    uint64_t rawBytes = 0;
+    uint64_t compressedBytes = 0;
+
+    const uint8_t * p = data;
+    for ( int i = 0; i < numPackets; ++i )
+    {
+        const int bytes = compressor.Compress( p, sizes[i], compressed, sizes[i] - 1 );
+        rawBytes += sizes[i];
+        compressedBytes += bytes > 0 ? bytes + 1 : sizes[i] + 1;
+        p += sizes[i];
+    }
+
+    printf( "%s: %llu -> %llu bytes (%.1f%% saved)\n", 
+        label, 
+        (unsigned long long) rawBytes, 
+        (unsigned long long) compressedBytes, 
+        rawBytes > 0 ? 100.0 * ( 1.0 - double( compressedBytes ) / double( rawBytes ) ) : 0.0 );
+}
+
+int main( int argc, char * argv[] )
+{
+    if ( argc < 3 )
+    {
+        printf( "usage: TrainDictionary <capture file> <dictionary file> [dictionary size]\n" );
+        return 1;
+    }
+
+    const char * captureFilename = argv[1];
+    const char * dictionaryFilename = argv[2];
+    const int dictionarySize = argc > 3 ? atoi( argv[3] ) : 16 * 1024;
+
+    if ( dictionarySize <= 0 || dictionarySize > network::MaxCompressorDictionarySize )
+    {
+        printf( "error: dictionary size must be in [1,%d]\n", network::MaxCompressorDictionarySize );
+        return 1;
+    }
+
+    core::memory::initialize();
+    {
+        core::Allocator & allocator = core::memory::default_allocator();
+
+        FILE * file = fopen( captureFilename, "rb" );
+        if ( !file )
+        {
+            printf( "error: failed to open capture file %s\n", captureFilename );
+            core::memory::shutdown();
+            return 1;
+        }
+
+        uint8_t * data = (uint8_t*) allocator.Allocate( MaxCaptureBytes );
+        int * sizes = (int*) allocator.Allocate( sizeof( int ) * MaxCapturePackets );
+
+        int numPackets = 0;
+        int totalBytes = 0;
+
+        while ( numPackets < MaxCapturePackets )
+        {
+            const int maxBytes = core::min( MaxPacketBytes, MaxCaptureBytes - totalBytes );
+            const int bytes = network::read_capture_record( file, data + totalBytes, maxBytes );
+            if ( bytes <= 0 )
+            {
+                if ( bytes < 0 )
+                    printf( "warning: capture truncated after %d packets\n", numPackets );
+                break;
+            }
+            sizes[numPackets++] = bytes;
+            totalBytes += bytes;
+        }
+
+        fclose( file );
+
+        printf( "read %d packets (%d bytes) from %s\n", numPackets, totalBytes, captureFilename );
+
+        uint8_t * dictionary = (uint8_t*) allocator.Allocate( dictionarySize );
+
+        const int trainedSize = network::train_dictionary( allocator, data, sizes, numPackets, dictionary, dictionarySize );
+
+        int result = 0;
+
+        FILE * output = trainedSize > 0 ? fopen( dictionaryFilename, "wb" ) : nullptr;
+        if ( trainedSize <= 0 )
+        {
+            printf( "error: not enough packet data to train a dictionary\n" );
+            result = 1;
+        }
+        else if ( output && fwrite( dictionary, trainedSize, 1, output ) == 1 )
+        {
+            printf( "wrote %d byte dictionary to %s\n", trainedSize, dictionaryFilename );
+
+            network::Compressor withoutDictionary( allocator );
+            network::Compressor withDictionary( allocator, dictionary, trainedSize );
+
+            report( withoutDictionary, data, sizes, numPackets, "no dictionary" );
+            report( withDictionary, data, sizes, numPackets, "dictionary" );
+        }
+        else
+        {
+            printf( "error: failed to write dictionary file %s\n", dictionaryFilename );
+            result = 1;
+        }
+
+        if ( output )
+            fclose( output );
+
+        allocator.Free( dictionary );
+        allocator.Free( sizes );
+        allocator.Free( data );
+
+        core::memory::shutdown();
+
+        return result;
+    }
+}
@@ -52,7 +52,7 @@ struct ServerInfo
     network::Simulator * networkSimulator;
 };
 
-void soak_test()
+void soak_test( const char * traceFile )
 {
 #if PROFILE
     printf( "[profile client server]\n" );
@@ -89,6 +89,8 @@ void soak_test()
         serverInfo[i].networkSimulator->AddState( { 0.1f, 0.1f, 5.0f } );
         serverInfo[i].networkSimulator->AddState( { 0.2f, 0.1f, 10.0f } );
         serverInfo[i].networkSimulator->AddState( { 0.25f, 0.1f, 25.0f } );
+        if ( traceFile && !serverInfo[i].networkSimulator->LoadTrace( traceFile ) )
+            exit( 1 );
 
         const int serverDataSize = sizeof(TestContext) + 256 * i + 11 + i;
         serverInfo[i].serverData = CORE_NEW( core::memory::default_allocator(), protocol::Block, core::memory::default_allocator(), serverDataSize );
@@ -135,6 +137,8 @@ void soak_test()
         clientInfo[i].networkSimulator->AddState( { 0.1f, 0.1f, 5.0f } );
         clientInfo[i].networkSimulator->AddState( { 0.2f, 0.1f, 10.0f } );
         clientInfo[i].networkSimulator->AddState( { 0.25f, 0.1f, 25.0f } );
+        if ( traceFile && !clientInfo[i].networkSimulator->LoadTrace( traceFile ) )
+            exit( 1 );
 
         const int clientDataSize = 10 + 64 * i + 21 + i;
         clientInfo[i].clientData = CORE_NEW( core::memory::default_allocator(), protocol::Block, core::memory::default_allocator(), clientDataSize );
@@ -368,7 +372,7 @@ void soak_test()
     }
 }
 
-int main()
+int main( int argc, char * argv[] )
 {
     srand( time( nullptr ) );
 
@@ -384,7 +388,11 @@ int main()
 
     CORE_ASSERT( network::IsNetworkInitialized() );
 
-    soak_test();
+    // optional: replay link conditions from a simulator trace file instead of switching between random states
+
+    const char * traceFile = argc > 1 ? argv[1] : nullptr;
+
+    soak_test( traceFile );
 
     network::ShutdownNetwork();
 
@@ -2,11 +2,13 @@
 #include "ClientServer/Client.h"
 #include "ClientServer/Server.h"
 #include "ClientServer/ClientServerPackets.h"
+#include "ClientServer/RateController.h"
 #include "protocol/Message.h"
 #include "protocol/ReliableMessageChannel.h"
 #include "network/Network.h"
 #include "network/Interface.h"
 #include "network/BSDSocket.h"
+#include "network/Loopback.h"
 #include "network/DNSResolver.h"
 #include "TestCommon.h"
 #include "TestPackets.h"
@@ -49,7 +51,7 @@ void test_client_initial_state()
         CORE_CHECK( client.GetError() == clientServer::CLIENT_ERROR_NONE );
         CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_DISCONNECTED );
         CORE_CHECK( client.GetNetworkInterface() == &networkInterface );
-#if PROTOCOL_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
         CORE_CHECK( client.GetResolver() == nullptr );
 #endif
     }
@@ -57,36 +59,74 @@ void test_client_initial_state()
     core::memory::shutdown();
 }
 
-#if PROTOCOL_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
+
+// IMPORTANT: resolve tests run offline against a local hosts file
+
+static const char * TestHostsFile = "test_client_hosts.txt";
+
+static void write_test_hosts_file()
+{
+    FILE * file = fopen( TestHostsFile, "w" );
+    CORE_CHECK( file );
+    fprintf( file, "::1 server.test\n" );
+    fclose( file );
+}
+
+// resolver that never finishes a lookup
+
+class TestStalledResolver : public network::Resolver
+{
+    network::ResolveEntry m_entry;
+
+public:
+
+    void Resolve( const char * name ) {}
+
+    void Update( const core::TimeBase & timeBase ) {}
+
+    void Clear() {}
+
+    const network::ResolveEntry * GetEntry( const char * name ) const
+    {
+        return &m_entry;
+    }
+};
 
 void test_client_resolve_hostname_failure()
 {
     printf( "test_client_resolve_hostname_failure\n" );
 
-    memory::initialize();
+    core::memory::initialize();
     {
-        TestMessageFactory messageFactory( memory::default_allocator() );
+        TestMessageFactory messageFactory( core::memory::default_allocator() );
 
         TestChannelStructure channelStructure( messageFactory );
 
-        ClientServerPacketFactory packetFactory( memory::default_allocator(), &channelStructure );
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
 
-        BSDSocketConfig bsdSocketConfig;
+        network::BSDSocketConfig bsdSocketConfig;
         bsdSocketConfig.port = 10000;
         bsdSocketConfig.maxPacketSize = 1024;
         bsdSocketConfig.packetFactory = &packetFactory;
 
-        BSDSocket networkInterface( bsdSocketConfig );
+        network::BSDSocket networkInterface( bsdSocketConfig );
 
-        DNSResolver resolver;
+        write_test_hosts_file();
 
-        ClientConfig clientConfig;
+        network::DNSResolverConfig resolverConfig;
+        resolverConfig.hostsFile = TestHostsFile;
+        resolverConfig.useSystemResolver = false;
+
+        network::DNSResolver resolver( resolverConfig );
+
+        clientServer::ClientConfig clientConfig;
         clientConfig.connectingTimeOut = 1000000.0;
         clientConfig.resolver = &resolver;
         clientConfig.networkInterface = &networkInterface;
         clientConfig.channelStructure = &channelStructure;
 
-        Client client( clientConfig );
+        clientServer::Client client( clientConfig );
 
         client.Connect( "my butt" );
 
@@ -94,9 +134,9 @@ void test_client_resolve_hostname_failure()
         CORE_CHECK( !client.IsDisconnected() );
         CORE_CHECK( !client.IsConnected() );
         CORE_CHECK( !client.HasError() );
-        CORE_CHECK( client.GetState() == CLIENT_STATE_RESOLVING_HOSTNAME );
+        CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_RESOLVING_HOSTNAME );
 
-        TimeBase timeBase;
+        core::TimeBase timeBase;
         timeBase.deltaTime = 1.0f;
 
         for ( int i = 0; i < 100; ++i )
@@ -107,46 +147,50 @@ void test_client_resolve_hostname_failure()
             client.Update( timeBase );
 
             timeBase.time += timeBase.deltaTime;
+
+            core::sleep_milliseconds( 1 );
         }
 
         CORE_CHECK( client.IsDisconnected() );
         CORE_CHECK( !client.IsConnecting() );
         CORE_CHECK( !client.IsConnected() );
         CORE_CHECK( client.HasError() );
-        CORE_CHECK( client.GetState() == CLIENT_STATE_DISCONNECTED );
-        CORE_CHECK( client.GetError() == CLIENT_ERROR_RESOLVE_HOSTNAME_FAILED );
+        CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_DISCONNECTED );
+        CORE_CHECK( client.GetError() == clientServer::CLIENT_ERROR_RESOLVE_HOSTNAME_FAILED );
+
+        remove( TestHostsFile );
     }
 
-    memory::shutdown();
+    core::memory::shutdown();
 }
 
 void test_client_resolve_hostname_timeout()
 {
     printf( "test_client_resolve_hostname_timeout\n" );
 
-    memory::initialize();
+    core::memory::initialize();
     {
-        TestMessageFactory messageFactory( memory::default_allocator() );
+        TestMessageFactory messageFactory( core::memory::default_allocator() );
 
         TestChannelStructure channelStructure( messageFactory );
 
-        ClientServerPacketFactory packetFactory( memory::default_allocator(), &channelStructure );
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
 
-        BSDSocketConfig bsdSocketConfig;
+        network::BSDSocketConfig bsdSocketConfig;
         bsdSocketConfig.port = 10000;
         bsdSocketConfig.maxPacketSize = 1024;
         bsdSocketConfig.packetFactory = &packetFactory;
 
-        BSDSocket networkInterface( bsdSocketConfig );
+        network::BSDSocket networkInterface( bsdSocketConfig );
 
-        DNSResolver resolver;
+        TestStalledResolver resolver;
 
-        ClientConfig clientConfig;
+        clientServer::ClientConfig clientConfig;
         clientConfig.resolver = &resolver;
         clientConfig.networkInterface = &networkInterface;
         clientConfig.channelStructure = &channelStructure;
 
-        Client client( clientConfig );
+        clientServer::Client client( clientConfig );
 
         client.Connect( "my butt" );
 
@@ -154,9 +198,9 @@ void test_client_resolve_hostname_timeout()
         CORE_CHECK( !client.IsDisconnected() );
         CORE_CHECK( !client.IsConnected() );
         CORE_CHECK( !client.HasError() );
-        CORE_CHECK( client.GetState() == CLIENT_STATE_RESOLVING_HOSTNAME );
+        CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_RESOLVING_HOSTNAME );
 
-        TimeBase timeBase;
+        core::TimeBase timeBase;
         timeBase.deltaTime = 1.0f;
 
         for ( int i = 0; i < 60; ++i )
@@ -173,68 +217,82 @@ void test_client_resolve_hostname_timeout()
         CORE_CHECK( !client.IsConnecting() );
         CORE_CHECK( !client.IsConnected() );
         CORE_CHECK( client.HasError() );
-        CORE_CHECK( client.GetState() == CLIENT_STATE_DISCONNECTED );
-        CORE_CHECK( client.GetError() == CLIENT_ERROR_CONNECTION_TIMED_OUT );
-        CORE_CHECK( client.GetExtendedError() == CLIENT_STATE_RESOLVING_HOSTNAME );
+        CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_DISCONNECTED );
+        CORE_CHECK( client.GetError() == clientServer::CLIENT_ERROR_CONNECTION_TIMED_OUT );
+        CORE_CHECK( client.GetExtendedError() == clientServer::CLIENT_STATE_RESOLVING_HOSTNAME );
     }
+
+    core::memory::shutdown();
 }
 
 void test_client_resolve_hostname_success()
 {
     printf( "test_client_resolve_hostname_success\n" );
 
-    memory::initialize();
+    core::memory::initialize();
     {
-        TestMessageFactory messageFactory( memory::default_allocator() );
+        TestMessageFactory messageFactory( core::memory::default_allocator() );
 
         TestChannelStructure channelStructure( messageFactory );
 
-        ClientServerPacketFactory packetFactory( memory::default_allocator(), &channelStructure );
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
 
-        BSDSocketConfig bsdSocketConfig;
+        network::BSDSocketConfig bsdSocketConfig;
         bsdSocketConfig.port = 10000;
         bsdSocketConfig.maxPacketSize = 1024;
         bsdSocketConfig.packetFactory = &packetFactory;
 
-        BSDSocket networkInterface( bsdSocketConfig );
+        network::BSDSocket networkInterface( bsdSocketConfig );
 
-        DNSResolver resolver;
+        write_test_hosts_file();
 
-        ClientConfig clientConfig;
+        network::DNSResolverConfig resolverConfig;
+        resolverConfig.hostsFile = TestHostsFile;
+        resolverConfig.useSystemResolver = false;
+
+        network::DNSResolver resolver( resolverConfig );
+
+        clientServer::ClientConfig clientConfig;
         clientConfig.resolver = &resolver;
         clientConfig.networkInterface = &networkInterface;
         clientConfig.channelStructure = &channelStructure;
 
-        Client client( clientConfig );
+        clientServer::Client client( clientConfig );
 
-        client.Connect( "localhost" );
+        client.Connect( "server.test:40000" );
 
         CORE_CHECK( client.IsConnecting() );
         CORE_CHECK( !client.IsDisconnected() );
         CORE_CHECK( !client.IsConnected() );
         CORE_CHECK( !client.HasError() );
-        CORE_CHECK( client.GetState() == CLIENT_STATE_RESOLVING_HOSTNAME );
+        CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_RESOLVING_HOSTNAME );
 
-        TimeBase timeBase;
+        core::TimeBase timeBase;
         timeBase.deltaTime = 0.01f;
 
-        for ( int i = 0; i < 60; ++i )
+        for ( int i = 0; i < 500; ++i )
         {
-            if ( client.GetState() == CLIENT_STATE_SENDING_CONNECTION_REQUEST )
+            if ( client.GetState() == clientServer::CLIENT_STATE_SENDING_CONNECTION_REQUEST )
                 break;
 
             client.Update( timeBase );
 
             timeBase.time += timeBase.deltaTime;
+
+            core::sleep_milliseconds( 1 );
         }
 
         CORE_CHECK( !client.IsDisconnected() );
         CORE_CHECK( client.IsConnecting() );
         CORE_CHECK( !client.IsConnected() );
         CORE_CHECK( !client.HasError() );
-        CORE_CHECK( client.GetState() == CLIENT_STATE_SENDING_CONNECTION_REQUEST );
-        CORE_CHECK( client.GetError() == CLIENT_ERROR_NONE );
+        CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_SENDING_CONNECTION_REQUEST );
+        CORE_CHECK( client.GetError() == clientServer::CLIENT_ERROR_NONE );
+
+        remove( TestHostsFile );
     }
+
+    core::memory::shutdown();
 }
 
 #endif
@@ -437,7 +495,9 @@ void test_client_connection_challenge()
             sleep_after_too_many_iterations( iteration );
         }
 
-        CORE_CHECK( server.GetClientState( clientIndex ) == clientServer::SERVER_CLIENT_STATE_SENDING_CHALLENGE );
+        // the challenge is stateless. the server does not commit a slot until it receives a valid challenge response
+
+        CORE_CHECK( server.GetClientState( clientIndex ) == clientServer::SERVER_CLIENT_STATE_DISCONNECTED );
 
         CORE_CHECK( !client.IsDisconnected() );
         CORE_CHECK( client.IsConnecting() );
@@ -1036,6 +1096,148 @@ void test_client_connection_server_full()
     core::memory::shutdown(); 
 }
 
+void test_client_connection_request_flood()
+{
+    printf( "test_client_connection_request_flood\n" );
+
+    core::memory::initialize();
+    {
+        TestMessageFactory messageFactory( core::memory::default_allocator() );
+
+        TestChannelStructure channelStructure( messageFactory );
+
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::BSDSocketConfig bsdSocketConfig;
+        bsdSocketConfig.port = 10000;
+        bsdSocketConfig.maxPacketSize = 1024;
+        bsdSocketConfig.packetFactory = &packetFactory;
+
+        network::BSDSocket serverNetworkInterface( bsdSocketConfig );
+
+        clientServer::ServerConfig serverConfig;
+        serverConfig.maxClients = 2;
+        serverConfig.channelStructure = &channelStructure;
+        serverConfig.networkInterface = &serverNetworkInterface;
+
+        clientServer::Server server( serverConfig );
+
+        bsdSocketConfig.port = 0;
+
+        network::BSDSocket attackerNetworkInterface( bsdSocketConfig );
+
+        const network::Address serverAddress( "::1", 10000 );
+
+        core::TimeBase timeBase;
+        timeBase.deltaTime = 0.01f;
+
+        // flood the server with connection requests and forged challenge responses.
+        // the server answers requests with challenges but must never commit a client slot.
+
+        clientServer::ChallengeResponsePacket validResponse;
+
+        int numChallenges = 0;
+
+        for ( int i = 0; i < 50; ++i )
+        {
+            for ( int j = 0; j < 16; ++j )
+            {
+                auto request = (clientServer::ConnectionRequestPacket*) packetFactory.Create( clientServer::CLIENT_SERVER_PACKET_CONNECTION_REQUEST );
+                request->clientId = core::generate_id();
+                attackerNetworkInterface.SendPacket( serverAddress, request );
+
+                auto response = (clientServer::ChallengeResponsePacket*) packetFactory.Create( clientServer::CLIENT_SERVER_PACKET_CHALLENGE_RESPONSE );
+                response->clientId = core::generate_id();
+                response->serverId = core::generate_id();
+                response->challengeTime = uint64_t( timeBase.time * 1000.0 );
+                response->challengeToken = ( uint64_t( rand() ) << 32 ) | rand();
+                attackerNetworkInterface.SendPacket( serverAddress, response );
+            }
+
+            attackerNetworkInterface.Update( timeBase );
+
+            server.Update( timeBase );
+
+            for ( int j = 0; j < serverConfig.maxClients; ++j )
+                CORE_CHECK( server.GetClientState( j ) == clientServer::SERVER_CLIENT_STATE_DISCONNECTED );
+
+            while ( auto packet = attackerNetworkInterface.ReceivePacket() )
+            {
+                if ( packet->GetType() == clientServer::CLIENT_SERVER_PACKET_CONNECTION_CHALLENGE )
+                {
+                    auto challenge = (clientServer::ConnectionChallengePacket*) packet;
+                    validResponse.clientId = challenge->clientId;
+                    validResponse.serverId = challenge->serverId;
+                    validResponse.challengeTime = challenge->challengeTime;
+                    validResponse.challengeToken = challenge->challengeToken;
+                    numChallenges++;
+                }
+                packetFactory.Destroy( packet );
+            }
+
+            timeBase.time += timeBase.deltaTime;
+
+            core::sleep_milliseconds( 1 );
+        }
+
+        CORE_CHECK( numChallenges > 0 );
+
+        // a valid token with any field changed is rejected
+
+        auto tampered = (clientServer::ChallengeResponsePacket*) packetFactory.Create( clientServer::CLIENT_SERVER_PACKET_CHALLENGE_RESPONSE );
+        tampered->clientId = validResponse.clientId + 1;
+        tampered->serverId = validResponse.serverId;
+        tampered->challengeTime = validResponse.challengeTime;
+        tampered->challengeToken = validResponse.challengeToken;
+        attackerNetworkInterface.SendPacket( serverAddress, tampered );
+        attackerNetworkInterface.Update( timeBase );
+
+        for ( int i = 0; i < 10; ++i )
+        {
+            server.Update( timeBase );
+            timeBase.time += timeBase.deltaTime;
+            core::sleep_milliseconds( 1 );
+        }
+
+        for ( int j = 0; j < serverConfig.maxClients; ++j )
+            CORE_CHECK( server.GetClientState( j ) == clientServer::SERVER_CLIENT_STATE_DISCONNECTED );
+
+        // a legitimate client still connects
+
+        network::BSDSocket clientNetworkInterface( bsdSocketConfig );
+
+        clientServer::ClientConfig clientConfig;
+        clientConfig.channelStructure = &channelStructure;
+        clientConfig.networkInterface = &clientNetworkInterface;
+
+        clientServer::Client client( clientConfig );
+
+        client.Connect( serverAddress );
+
+        int iteration = 0;
+
+        while ( true )
+        {
+            if ( client.IsConnected() || client.HasError() )
+                break;
+
+            client.Update( timeBase );
+
+            server.Update( timeBase );
+
+            timeBase.time += timeBase.deltaTime;
+
+            sleep_after_too_many_iterations( iteration );
+        }
+
+        CORE_CHECK( client.IsConnected() );
+        CORE_CHECK( server.GetClientState( 0 ) == clientServer::SERVER_CLIENT_STATE_CONNECTED );
+        CORE_CHECK( server.GetClientState( 1 ) == clientServer::SERVER_CLIENT_STATE_DISCONNECTED );
+    }
+
+    core::memory::shutdown();
+}
+
 void test_client_connection_timeout()
 {
     printf( "test_client_connection_timeout\n" );
@@ -1341,11 +1543,26 @@ void test_client_connection_reconnect()
         CORE_CHECK( client.GetError() == clientServer::CLIENT_ERROR_NONE );
         CORE_CHECK( client.GetExtendedError() == 0 );
 
+        // slot objects are allocated on demand, and returned to the pool when the slot is reset
+
+        for ( int i = 0; i < serverConfig.maxClients; ++i )
+        {
+            if ( i != clientIndex )
+                CORE_CHECK( server.GetClientConnection( i ) == nullptr );
+        }
+
+        protocol::Connection * connection = server.GetClientConnection( clientIndex );
+        CORE_CHECK( connection );
+        CORE_CHECK( server.GetNumPooledConnections() == 0 );
+
         // now disconnect the client on the server and call connect again
         // verify the client can create a new connection to the server.
 
         server.DisconnectClient( clientIndex );
 
+        CORE_CHECK( server.GetClientConnection( clientIndex ) == nullptr );
+        CORE_CHECK( server.GetNumPooledConnections() == 1 );
+
         client.Connect( "[::1]:10001" );
 
         iteration = 0;
@@ -1372,6 +1589,9 @@ void test_client_connection_reconnect()
         CORE_CHECK( client.GetState() == clientServer::CLIENT_STATE_CONNECTED );
         CORE_CHECK( client.GetError() == clientServer::CLIENT_ERROR_NONE );
         CORE_CHECK( client.GetExtendedError() == 0 );
+
+        CORE_CHECK( server.GetClientConnection( clientIndex ) == connection );
+        CORE_CHECK( server.GetNumPooledConnections() == 0 );
     }
 
     core::memory::shutdown();
@@ -2317,6 +2537,106 @@ void test_server_data_too_large()
     core::memory::shutdown();
 }
 
+void test_server_data_sender()
+{
+    printf( "test_server_data_sender\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::LoopbackNetwork loopbackNetwork( core::memory::default_allocator(), 1200 );
+
+        network::LoopbackConfig loopbackConfig;
+        loopbackConfig.network = &loopbackNetwork;
+        loopbackConfig.address = network::Address( "::1", 10000 );
+        loopbackConfig.packetFactory = &packetFactory;
+
+        network::LoopbackInterface serverNetworkInterface( loopbackConfig );
+
+        loopbackConfig.address = network::Address( "::1", 10001 );
+
+        network::LoopbackInterface clientNetworkInterface( loopbackConfig );
+
+        const int ServerDataSize = 10 * 1024 + 11;
+        const int FragmentSize = 1024;
+        const int NumClients = 3;
+
+        protocol::Block serverData( core::memory::default_allocator(), ServerDataSize );
+        for ( int i = 0; i < ServerDataSize; ++i )
+            serverData.GetData()[i] = ( 10 + i ) % 256;
+
+        clientServer::ServerDataSender sender( core::memory::default_allocator(), serverData, FragmentSize, 60, NumClients );
+
+        CORE_CHECK( sender.GetNumFragments() == 11 );
+
+        clientServer::ClientServerInfo info;
+        info.address = clientNetworkInterface.GetAddress();
+        info.packetFactory = &packetFactory;
+        info.networkInterface = &serverNetworkInterface;
+
+        core::TimeBase timeBase;
+        timeBase.deltaTime = 0.1;
+
+        // fragments are paced per-client and point into the shared block
+
+        for ( int i = 0; i < 20; ++i )
+        {
+            timeBase.time += timeBase.deltaTime;
+
+            for ( int j = 0; j < NumClients; ++j )
+            {
+                if ( sender.SendCompleted( j ) )
+                    continue;
+                info.clientId = j + 1;
+                sender.Update( j, timeBase, info );
+            }
+
+            clientNetworkInterface.Update( timeBase );
+
+            while ( auto packet = clientNetworkInterface.ReceivePacket() )
+            {
+                CORE_CHECK( packet->GetType() == clientServer::CLIENT_SERVER_PACKET_DATA_BLOCK_FRAGMENT );
+
+                auto fragmentPacket = (clientServer::DataBlockFragmentPacket*) packet;
+
+                CORE_CHECK( fragmentPacket->clientId >= 1 && fragmentPacket->clientId <= NumClients );
+                CORE_CHECK( fragmentPacket->blockSize == ServerDataSize );
+                CORE_CHECK( fragmentPacket->numFragments == 11 );
+                CORE_CHECK( fragmentPacket->fragmentBytes == ( fragmentPacket->fragmentId == 10 ? 11 : FragmentSize ) );
+                CORE_CHECK( memcmp( fragmentPacket->fragmentData, serverData.GetData() + fragmentPacket->fragmentId * FragmentSize, fragmentPacket->fragmentBytes ) == 0 );
+
+                // client 0 acks everything, client 1 only even fragments, client 2 nothing
+
+                const int clientIndex = fragmentPacket->clientId - 1;
+                if ( clientIndex == 0 || ( clientIndex == 1 && ( fragmentPacket->fragmentId % 2 ) == 0 ) )
+                {
+                    sender.ProcessAck( clientIndex, fragmentPacket->fragmentId );
+                    sender.ProcessAck( clientIndex, fragmentPacket->fragmentId );
+                }
+
+                packetFactory.Destroy( packet );
+            }
+        }
+
+        CORE_CHECK( sender.SendCompleted( 0 ) );
+        CORE_CHECK( !sender.SendCompleted( 1 ) );
+        CORE_CHECK( sender.GetNumAckedFragments( 1 ) == 6 );
+        CORE_CHECK( sender.GetNumAckedFragments( 2 ) == 0 );
+
+        sender.ProcessAck( 2, -1 );
+        sender.ProcessAck( 2, 11 );
+        CORE_CHECK( sender.GetNumAckedFragments( 2 ) == 0 );
+
+        sender.Reset( 0 );
+        CORE_CHECK( !sender.SendCompleted( 0 ) );
+        CORE_CHECK( sender.GetNumAckedFragments( 0 ) == 0 );
+        CORE_CHECK( sender.GetNumAckedFragments( 1 ) == 6 );
+    }
+
+    core::memory::shutdown();
+}
+
 void test_client_server_user_context()
 {
     printf( "test_client_server_user_context\n" );
@@ -2474,6 +2794,376 @@ void test_client_server_user_context()
     }
 }
 
+void test_client_server_loopback()
+{
+    printf( "test_client_server_loopback\n" );
+
+    core::memory::initialize();
+    {
+        TestMessageFactory messageFactory( core::memory::default_allocator() );
+
+        TestChannelStructure channelStructure( messageFactory );
+
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        // many clients and one server in process, connected through a loopback network
+
+        network::LoopbackNetwork loopbackNetwork( core::memory::default_allocator(), 1200 );
+
+        network::LoopbackConfig loopbackConfig;
+        loopbackConfig.network = &loopbackNetwork;
+        loopbackConfig.address = network::Address( "::1" );
+        loopbackConfig.address.SetPort( 10000 );
+        loopbackConfig.packetFactory = &packetFactory;
+
+        network::LoopbackInterface serverNetworkInterface( loopbackConfig );
+
+        const int NumClients = 64;
+
+        clientServer::ServerConfig serverConfig;
+        serverConfig.maxClients = NumClients;
+        serverConfig.channelStructure = &channelStructure;
+        serverConfig.networkInterface = &serverNetworkInterface;
+
+        clientServer::Server server( serverConfig );
+
+        CORE_CHECK( server.IsOpen() );
+
+        clientServer::Client * clients[NumClients];
+
+        network::LoopbackInterface * clientInterface[NumClients];
+
+        for ( int i = 0; i < NumClients; ++i )
+        {
+            loopbackConfig.address.SetPort( 20000 + i );
+
+            clientInterface[i] = CORE_NEW( core::memory::default_allocator(), network::LoopbackInterface, loopbackConfig );
+
+            clientServer::ClientConfig clientConfig;
+            clientConfig.channelStructure = &channelStructure;
+            clientConfig.networkInterface = clientInterface[i];
+
+            clients[i] = CORE_NEW( core::memory::default_allocator(), clientServer::Client, clientConfig );
+
+            clients[i]->Connect( serverNetworkInterface.GetAddress() );
+        }
+
+        core::TimeBase timeBase;
+        timeBase.deltaTime = 0.01f;
+
+        for ( int iteration = 0; iteration < 1000; ++iteration )
+        {
+            int numConnectedClients = 0;
+            for ( auto client : clients )
+            {
+                if ( client->GetState() == clientServer::CLIENT_STATE_CONNECTED )
+                    numConnectedClients++;
+
+                client->Update( timeBase );
+            }
+
+            if ( numConnectedClients == NumClients )
+                break;
+
+            server.Update( timeBase );
+
+            timeBase.time += timeBase.deltaTime;
+        }
+
+        for ( int i = 0; i < NumClients; ++i )
+        {
+            CORE_CHECK( clients[i]->IsConnected() );
+            CORE_CHECK( server.GetClientState(i) == clientServer::SERVER_CLIENT_STATE_CONNECTED );
+            CORE_CHECK( clientInterface[i]->GetCounter( network::LOOPBACK_COUNTER_SERIALIZE_READ_FAILURES ) == 0 );
+        }
+
+        CORE_CHECK( serverNetworkInterface.GetCounter( network::LOOPBACK_COUNTER_SERIALIZE_READ_FAILURES ) == 0 );
+
+        for ( int i = 0; i < NumClients; ++i )
+        {
+            typedef network::LoopbackInterface LoopbackInterface;
+            CORE_DELETE( core::memory::default_allocator(), Client, clients[i] );
+            CORE_DELETE( core::memory::default_allocator(), LoopbackInterface, clientInterface[i] );
+        }
+    }
+
+    core::memory::shutdown(); 
+}
+
+class LossyInterface : public network::Interface
+{
+    // wraps another interface, dropping every n-th packet sent and tracking the largest connection packet sent
+
+    network::Interface * m_interface;
+    const void ** m_context = nullptr;
+    int m_dropEvery = 0;
+    int m_numSent = 0;
+    int m_maxConnectionPacketBytes = 0;
+
+public:
+
+    LossyInterface( network::Interface * networkInterface ) : m_interface( networkInterface ) {}
+
+    void SetDropEvery( int dropEvery ) { m_dropEvery = dropEvery; }
+
+    void ResetMaxConnectionPacketBytes() { m_maxConnectionPacketBytes = 0; }
+
+    int GetMaxConnectionPacketBytes() const { return m_maxConnectionPacketBytes; }
+
+    void SendPacket( const network::Address & address, protocol::Packet * packet )
+    {
+        if ( packet->GetType() == clientServer::CLIENT_SERVER_PACKET_CONNECTION )
+        {
+            protocol::MeasureStream measureStream( GetMaxPacketSize() );
+            measureStream.SetContext( m_context );
+            static_cast<protocol::ConnectionPacket*>( packet )->SerializeMeasure( measureStream );
+            m_maxConnectionPacketBytes = core::max( m_maxConnectionPacketBytes, measureStream.GetBytesProcessed() );
+        }
+
+        if ( m_dropEvery && ++m_numSent % m_dropEvery == 0 )
+        {
+            GetPacketFactory().Destroy( packet );
+            return;
+        }
+
+        m_interface->SendPacket( address, packet );
+    }
+
+    protocol::Packet * ReceivePacket() { return m_interface->ReceivePacket(); }
+
+    void Update( const core::TimeBase & timeBase ) { m_interface->Update( timeBase ); }
+
+    uint32_t GetMaxPacketSize() const { return m_interface->GetMaxPacketSize(); }
+
+    protocol::PacketFactory & GetPacketFactory() const { return m_interface->GetPacketFactory(); }
+
+    void SetContext( const void ** context )
+    {
+        m_context = context;
+        m_interface->SetContext( context );
+    }
+};
+
+void test_client_server_adaptive_packet_size()
+{
+    printf( "test_client_server_adaptive_packet_size\n" );
+
+    core::memory::initialize();
+    {
+        TestMessageFactory messageFactory( core::memory::default_allocator() );
+
+        TestChannelStructure channelStructure( messageFactory );
+
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::LoopbackNetwork loopbackNetwork( core::memory::default_allocator(), 1024 );
+
+        network::LoopbackConfig loopbackConfig;
+        loopbackConfig.network = &loopbackNetwork;
+        loopbackConfig.address = network::Address( "::1" );
+        loopbackConfig.packetFactory = &packetFactory;
+
+        loopbackConfig.address.SetPort( 10000 );
+        network::LoopbackInterface serverLoopbackInterface( loopbackConfig );
+
+        loopbackConfig.address.SetPort( 20000 );
+        network::LoopbackInterface clientLoopbackInterface( loopbackConfig );
+
+        LossyInterface serverNetworkInterface( &serverLoopbackInterface );
+        LossyInterface clientNetworkInterface( &clientLoopbackInterface );
+
+        // the smallest packet size must still fit the largest test message
+
+        clientServer::RateControllerConfig rateControllerConfig;
+        rateControllerConfig.minPacketSize = 96;
+        rateControllerConfig.maxPacketSize = 1024;
+
+        clientServer::ServerConfig serverConfig;
+        serverConfig.channelStructure = &channelStructure;
+        serverConfig.networkInterface = &serverNetworkInterface;
+        serverConfig.adaptiveSendRate = true;
+        serverConfig.rateController = rateControllerConfig;
+
+        clientServer::Server server( serverConfig );
+
+        CORE_CHECK( server.IsOpen() );
+
+        clientServer::ClientConfig clientConfig;
+        clientConfig.channelStructure = &channelStructure;
+        clientConfig.networkInterface = &clientNetworkInterface;
+        clientConfig.adaptiveSendRate = true;
+        clientConfig.rateController = rateControllerConfig;
+
+        clientServer::Client client( clientConfig );
+
+        client.Connect( serverLoopbackInterface.GetAddress() );
+
+        core::TimeBase timeBase;
+        timeBase.deltaTime = 0.01f;
+
+        const int clientIndex = 0;
+
+        for ( int iteration = 0; iteration < 1000; ++iteration )
+        {
+            if ( client.IsConnected() && server.GetClientState( clientIndex ) == clientServer::SERVER_CLIENT_STATE_CONNECTED )
+                break;
+
+            client.Update( timeBase );
+
+            server.Update( timeBase );
+
+            timeBase.time += timeBase.deltaTime;
+        }
+
+        CORE_CHECK( client.IsConnected() );
+        CORE_CHECK( server.GetClientState( clientIndex ) == clientServer::SERVER_CLIENT_STATE_CONNECTED );
+
+        auto clientMessageChannel = static_cast<protocol::ReliableMessageChannel*>( client.GetConnection()->GetChannel( 0 ) );
+        auto serverMessageChannel = static_cast<protocol::ReliableMessageChannel*>( server.GetClientConnection( clientIndex )->GetChannel( 0 ) );
+
+        int numMessagesSent = 0;
+
+        // run with messages always queued on both sides, so packets are as large as the connection allows
+
+        auto run = [&]( double seconds )
+        {
+            const double finishTime = timeBase.time + seconds;
+
+            while ( timeBase.time < finishTime )
+            {
+                while ( clientMessageChannel->CanSendMessage() && serverMessageChannel->CanSendMessage() )
+                {
+                    auto clientMessage = (TestMessage*) messageFactory.Create( MESSAGE_TEST );
+                    clientMessage->sequence = numMessagesSent;
+                    clientMessageChannel->SendMessage( clientMessage );
+
+                    auto serverMessage = (TestMessage*) messageFactory.Create( MESSAGE_TEST );
+                    serverMessage->sequence = numMessagesSent;
+                    serverMessageChannel->SendMessage( serverMessage );
+
+                    numMessagesSent++;
+                }
+
+                client.Update( timeBase );
+
+                server.Update( timeBase );
+
+                while ( auto message = clientMessageChannel->ReceiveMessage() )
+                    messageFactory.Release( message );
+
+                while ( auto message = serverMessageChannel->ReceiveMessage() )
+                    messageFactory.Release( message );
+
+                timeBase.time += timeBase.deltaTime;
+            }
+        };
+
+        // good link: the send rate climbs to the ceiling and packets grow to the largest size
+
+        run( 20.0 );
+
+        CORE_CHECK( client.GetSendRate() == rateControllerConfig.maxSendRate );
+        CORE_CHECK( server.GetClientSendRate( clientIndex ) == rateControllerConfig.maxSendRate );
+        CORE_CHECK( client.GetPacketSize() == rateControllerConfig.maxPacketSize );
+        CORE_CHECK( server.GetClientPacketSize( clientIndex ) == rateControllerConfig.maxPacketSize );
+        CORE_CHECK( clientNetworkInterface.GetMaxConnectionPacketBytes() > rateControllerConfig.minPacketSize );
+        CORE_CHECK( serverNetworkInterface.GetMaxConnectionPacketBytes() > rateControllerConfig.minPacketSize );
+
+        // one in four packets lost each way: both sides back off and the packets actually sent shrink
+
+        clientNetworkInterface.SetDropEvery( 4 );
+        serverNetworkInterface.SetDropEvery( 4 );
+
+        run( 20.0 );
+
+        CORE_CHECK( client.IsConnected() );
+        CORE_CHECK( client.GetPacketSize() == rateControllerConfig.minPacketSize );
+        CORE_CHECK( server.GetClientPacketSize( clientIndex ) == rateControllerConfig.minPacketSize );
+
+        clientNetworkInterface.ResetMaxConnectionPacketBytes();
+        serverNetworkInterface.ResetMaxConnectionPacketBytes();
+
+        run( 5.0 );
+
+        CORE_CHECK( clientNetworkInterface.GetMaxConnectionPacketBytes() > 0 );
+        CORE_CHECK( serverNetworkInterface.GetMaxConnectionPacketBytes() > 0 );
+        CORE_CHECK( clientNetworkInterface.GetMaxConnectionPacketBytes() <= rateControllerConfig.minPacketSize );
+        CORE_CHECK( serverNetworkInterface.GetMaxConnectionPacketBytes() <= rateControllerConfig.minPacketSize );
+    }
+
+    core::memory::shutdown(); 
+}
+
+void test_rate_controller()
+{
+    printf( "test_rate_controller\n" );
+
+    clientServer::RateControllerConfig config;
+    config.minSendRate = 10.0f;
+    config.maxSendRate = 60.0f;
+
+    clientServer::RateController rateController( config );
+
+    CORE_CHECK( rateController.GetSendRate() == config.minSendRate );
+    CORE_CHECK( rateController.GetPacketSize() == config.minPacketSize );
+
+    const double deltaTime = 0.01;
+
+    // no RTT measurement yet: hold the send rate
+
+    for ( int i = 0; i < 1000; ++i )
+        rateController.Update( deltaTime, 0.0f, 0.0f );
+
+    CORE_CHECK( rateController.GetSendRate() == config.minSendRate );
+
+    // good link: ramp up to the ceiling and stay there
+
+    for ( int i = 0; i < 10000; ++i )
+        rateController.Update( deltaTime, 0.05f, 0.0f );
+
+    CORE_CHECK( !rateController.IsCongested() );
+    CORE_CHECK( rateController.GetSendRate() == config.maxSendRate );
+    CORE_CHECK( rateController.GetPacketSize() == config.maxPacketSize );
+
+    // packet loss: back off towards the floor but never below it
+
+    for ( int i = 0; i < 100; ++i )
+        rateController.Update( deltaTime, 0.05f, 25.0f );
+
+    CORE_CHECK( rateController.IsCongested() );
+    CORE_CHECK( rateController.GetSendRate() < config.maxSendRate );
+
+    for ( int i = 0; i < 10000; ++i )
+        rateController.Update( deltaTime, 0.05f, 25.0f );
+
+    CORE_CHECK( rateController.GetSendRate() == config.minSendRate );
+
+    // queuing delay: RTT growing well above the lowest RTT seen is congestion even without loss
+
+    for ( int i = 0; i < 10000; ++i )
+        rateController.Update( deltaTime, 0.05f, 0.0f );
+
+    CORE_CHECK( rateController.GetSendRate() == config.maxSendRate );
+
+    for ( int i = 0; i < 100; ++i )
+        rateController.Update( deltaTime, 0.05f + config.maxQueueDelay * 2, 0.0f );
+
+    CORE_CHECK( rateController.IsCongested() );
+    CORE_CHECK( rateController.GetSendRate() < config.maxSendRate );
+
+    // route change: the higher RTT holds, so once the old lowest RTT ages out of the window it is no longer congestion
+
+    for ( int i = 0; i < 10000; ++i )
+        rateController.Update( deltaTime, 0.05f + config.maxQueueDelay * 2, 0.0f );
+
+    CORE_CHECK( !rateController.IsCongested() );
+    CORE_CHECK( rateController.GetSendRate() == config.maxSendRate );
+
+    rateController.Reset();
+
+    CORE_CHECK( rateController.GetSendRate() == config.minSendRate );
+}
+
 int main()
 {
     srand( time( nullptr ) );
@@ -2488,7 +3178,7 @@ int main()
 
     test_client_initial_state();
 
-#if PROTOCOL_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
     test_client_resolve_hostname_failure();
     test_client_resolve_hostname_timeout();
     test_client_resolve_hostname_success();
@@ -2502,6 +3192,7 @@ int main()
     test_client_connection_messages();
     test_client_connection_disconnect();
     test_client_connection_server_full();
+    test_client_connection_request_flood();
     test_client_connection_timeout();
     test_client_connection_already_connected();
     test_client_connection_reconnect();
@@ -2513,9 +3204,16 @@ int main()
     test_client_and_server_data_reconnect();
     test_client_and_server_data_multiple_clients();
     test_server_data_too_large();
+    test_server_data_sender();
 
     test_client_server_user_context();
 
+    test_client_server_loopback();
+
+    test_client_server_adaptive_packet_size();
+
+    test_rate_controller();
+
     network::ShutdownNetwork();
 
     return 0;
@@ -253,6 +253,27 @@ void test_murmur_hash()
     CORE_CHECK( h == 0xe604acc23b568f83ull );
 }
 
+void test_siphash()
+{
+    printf( "test_siphash\n" );
+
+    // reference vectors from the SipHash paper: key 00..0f, message 00..(n-1)
+
+    uint8_t key[16];
+    uint8_t message[15];
+    for ( int i = 0; i < 16; ++i )
+        key[i] = i;
+    for ( int i = 0; i < 15; ++i )
+        message[i] = i;
+
+    CORE_CHECK( core::siphash_24( message, 0, key ) == 0x726fdb47dd0e0e31ull );
+    CORE_CHECK( core::siphash_24( message, 8, key ) == 0x93f5f5799a932462ull );
+    CORE_CHECK( core::siphash_24( message, 15, key ) == 0xa129ca6149be45e5ull );
+
+    key[0] ^= 1;
+    CORE_CHECK( core::siphash_24( message, 15, key ) != 0xa129ca6149be45e5ull );
+}
+
 void test_queue()
 {
     printf( "test_queue\n" );
@@ -326,6 +347,7 @@ int main()
     test_hash();
     test_multi_hash();
     test_murmur_hash();
+    test_siphash();
     test_queue();
     test_pointer_arithmetic();
     test_sequence();
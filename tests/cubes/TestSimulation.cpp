@@ -0,0 +1,217 @@
+#include "core/Core.h"
+#include "cubes/Simulation.h"
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+extern "C"
+{
+    extern void dRandSetSeed( unsigned int seed );
+}
+
+using namespace cubes;
+
+static const float DeltaTime = 1.0f / 60.0f;
+
+static SimulationObjectState cube_state( float x, float y, float z )
+{
+    SimulationObjectState objectState;
+    objectState.enabled = true;
+    objectState.scale = 1.0f;
+    objectState.position = math::Vector( x, y, z );
+    objectState.orientation = math::Quaternion( 1, 0, 0, 0 );
+    objectState.linearVelocity = math::Vector( 0, 0, 0 );
+    objectState.angularVelocity = math::Vector( 0, 0, 0 );
+    return objectState;
+}
+
+void test_simulation_readd_object_falls()
+{
+    printf( "test_simulation_readd_object_falls\n" );
+
+    Simulation simulation;
+    simulation.Initialize();
+    simulation.AddPlane( math::Vector( 0, 0, 1 ), 0 );
+
+    // removed bodies go back to the pool disabled. the object added in their place must still simulate
+
+    const int first = simulation.AddObject( cube_state( 0, 0, 10 ) );
+    simulation.RemoveObject( first );
+
+    const int id = simulation.AddObject( cube_state( 0, 0, 10 ) );
+
+    for ( int i = 0; i < 30; ++i )
+        simulation.Update( DeltaTime );
+
+    SimulationObjectState objectState;
+    simulation.GetObjectState( id, objectState );
+
+    CORE_CHECK( objectState.enabled );
+    CORE_CHECK( objectState.position.z < 9.0f );
+}
+
+void test_simulation_force_after_reset()
+{
+    printf( "test_simulation_force_after_reset\n" );
+
+    Simulation simulation;
+    simulation.Initialize();
+    simulation.AddPlane( math::Vector( 0, 0, 1 ), 0 );
+
+    float distance[2];
+
+    for ( int pass = 0; pass < 2; ++pass )
+    {
+        if ( pass > 0 )
+        {
+            simulation.Reset();
+            simulation.AddPlane( math::Vector( 0, 0, 1 ), 0 );
+        }
+
+        const int id = simulation.AddObject( cube_state( 0, 0, 0.5f ) );
+
+        for ( int i = 0; i < 60; ++i )
+        {
+            simulation.ApplyForce( id, math::Vector( 200, 0, 0 ) );
+            simulation.Update( DeltaTime );
+        }
+
+        SimulationObjectState objectState;
+        simulation.GetObjectState( id, objectState );
+        distance[pass] = objectState.position.x;
+    }
+
+    // the same push moves the object the same distance before and after the reset
+
+    CORE_CHECK( distance[0] > 1.0f );
+    CORE_CHECK( fabs( distance[1] - distance[0] ) < 0.01f );
+}
+
+void test_simulation_add_disabled_object_sleeps()
+{
+    printf( "test_simulation_add_disabled_object_sleeps\n" );
+
+    Simulation simulation;
+    simulation.Initialize();
+    simulation.AddPlane( math::Vector( 0, 0, 1 ), 0 );
+
+    const int first = simulation.AddObject( cube_state( 0, 0, 0.5f ) );
+    simulation.RemoveObject( first );
+
+    SimulationObjectState initialState = cube_state( 0, 0, 0.5f );
+    initialState.enabled = false;
+
+    const int id = simulation.AddObject( initialState );
+
+    simulation.Update( DeltaTime );
+
+    SimulationObjectState objectState;
+    simulation.GetObjectState( id, objectState );
+
+    CORE_CHECK( !objectState.enabled );
+}
+
+static const int DeterministicFrames = 300;
+static const int DeterministicGridSize = 8;
+static const int DeterministicRemoveFrame = 100;
+static const int DeterministicAddFrame = 150;
+static const int DeterministicRemoveStart = 20;
+static const int DeterministicRemoveCount = 10;
+
+static void run_deterministic_scene( SimulationBroadphase broadphase, std::vector<uint64_t> & hashes, float & addedHeight, float & playerDistance )
+{
+    SimulationConfig config;
+    config.Deterministic = true;
+    config.WarmStarting = true;
+    config.Broadphase = broadphase;
+
+    Simulation simulation;
+    simulation.Initialize( config );
+    simulation.AddPlane( math::Vector( 0, 0, 1 ), 0 );
+
+    const int player = simulation.AddObject( cube_state( -6, 0, 0.5f ) );
+
+    const float origin = -DeterministicGridSize / 2.0f;
+    for ( int y = 0; y < DeterministicGridSize; ++y )
+        for ( int x = 0; x < DeterministicGridSize; ++x )
+            simulation.AddObject( cube_state( x + origin + 0.5f, y + origin + 0.5f, 0.5f ) );
+
+    hashes.resize( DeterministicFrames );
+
+    for ( int frame = 0; frame < DeterministicFrames; ++frame )
+    {
+        // remove a row of cubes, then drop them back in from above. freed ids and pooled bodies are
+        // reused last in first out, so removing in reverse hands the same ids back in order
+
+        if ( frame == DeterministicRemoveFrame )
+        {
+            for ( int i = DeterministicRemoveCount - 1; i >= 0; --i )
+                simulation.RemoveObject( DeterministicRemoveStart + i );
+        }
+
+        if ( frame == DeterministicAddFrame )
+        {
+            for ( int i = 0; i < DeterministicRemoveCount; ++i )
+            {
+                const int id = simulation.AddObject( cube_state( i - 5.0f, 6.0f, 5.0f ) );
+                CORE_CHECK( id == DeterministicRemoveStart + i );
+            }
+        }
+
+        simulation.ApplyForce( player, math::Vector( 40, 8, 0 ) );
+
+        // note: quickstep reorders constraints randomly, so seed per frame like the lockstep demo does
+
+        dRandSetSeed( frame );
+
+        simulation.Update( DeltaTime );
+
+        hashes[frame] = simulation.GetStateHash();
+    }
+
+    SimulationObjectState objectState;
+
+    simulation.GetObjectState( DeterministicRemoveStart, objectState );
+    addedHeight = objectState.position.z;
+
+    simulation.GetObjectState( player, objectState );
+    playerDistance = objectState.position.x + 6;
+}
+
+void test_simulation_deterministic_broadphases()
+{
+    printf( "test_simulation_deterministic_broadphases\n" );
+
+    std::vector<uint64_t> expected;
+    float addedHeight, playerDistance;
+
+    run_deterministic_scene( BROADPHASE_QuadTree, expected, addedHeight, playerDistance );
+
+    // the scene actually moves: the player pushes into the grid and the re-added cubes fall
+
+    CORE_CHECK( playerDistance > 1.0f );
+    CORE_CHECK( addedHeight < 2.0f );
+    CORE_CHECK( expected[DeterministicFrames-1] != expected[DeterministicFrames-2] );
+
+    // the order pairs come out of each broadphase differs, but the state must hash the same every frame
+
+    const SimulationBroadphase broadphases[] = { BROADPHASE_Hash, BROADPHASE_SweepAndPrune, BROADPHASE_Simple };
+
+    for ( int i = 0; i < (int) ( sizeof( broadphases ) / sizeof( broadphases[0] ) ); ++i )
+    {
+        std::vector<uint64_t> hashes;
+        run_deterministic_scene( broadphases[i], hashes, addedHeight, playerDistance );
+        for ( int frame = 0; frame < DeterministicFrames; ++frame )
+            CORE_CHECK( hashes[frame] == expected[frame] );
+    }
+}
+
+int main()
+{
+    test_simulation_readd_object_falls();
+    test_simulation_force_after_reset();
+    test_simulation_add_disabled_object_sleeps();
+    test_simulation_deterministic_broadphases();
+
+    return 0;
+}
@@ -210,3 +210,49 @@ void test_address6()
 
     core::memory::shutdown();
 }
+
+void test_address_compare()
+{
+    printf( "test_address_compare\n" );
+
+    core::memory::initialize();
+
+    {
+        CORE_CHECK( sizeof( network::Address ) == 20 );
+
+        network::Address a( 127, 0, 0, 1, 1000 );
+        network::Address b( "127.0.0.1:1000" );
+        network::Address c( 0x7f000001, 1000 );
+        CORE_CHECK( a == b );
+        CORE_CHECK( a == c );
+        CORE_CHECK( a.Hash() == b.Hash() );
+        CORE_CHECK( a.Hash() == c.Hash() );
+
+        network::Address d( 127, 0, 0, 1, 1001 );
+        network::Address e( 127, 0, 0, 2, 1000 );
+        CORE_CHECK( a != d );
+        CORE_CHECK( a != e );
+        CORE_CHECK( a.Hash() != d.Hash() );
+        CORE_CHECK( a.Hash() != e.Hash() );
+
+        // ipv4 is stored v4 mapped, but is never equal to the same address as ipv6
+
+        network::Address mapped( "[::ffff:127.0.0.1]:1000" );
+        CORE_CHECK( mapped.GetType() == network::ADDRESS_IPV6 );
+        CORE_CHECK( a != mapped );
+        CORE_CHECK( a.Hash() != mapped.Hash() );
+
+        network::Address f( "::1" );
+        network::Address g( 0, 0, 0, 0, 0, 0, 0, 1 );
+        CORE_CHECK( f == g );
+        CORE_CHECK( f.Hash() == g.Hash() );
+
+        network::Address undefined;
+        network::Address hostname( "not.an.address:1000" );
+        CORE_CHECK( !hostname.IsValid() );
+        CORE_CHECK( undefined == hostname );
+        CORE_CHECK( undefined.Hash() == hostname.Hash() );
+    }
+
+    core::memory::shutdown();
+}
@@ -438,3 +438,258 @@ void test_bsd_socket_send_and_receive_multiple_ipv6()
     }
     core::memory::shutdown();
 }
+
+void test_bsd_socket_send_and_receive_coalesced()
+{
+    printf( "test_bsd_socket_send_and_receive_coalesced\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::BSDSocketConfig sender_config;
+        sender_config.port = 10000;
+        sender_config.ipv6 = false;
+        sender_config.maxPacketSize = 256;
+        sender_config.coalescePackets = true;
+        sender_config.packetFactory = &packetFactory;
+
+        network::BSDSocket interface_sender( sender_config );
+        
+        network::BSDSocketConfig receiver_config;
+        receiver_config.port = 10001;
+        receiver_config.ipv6 = false;
+        receiver_config.maxPacketSize = 256;
+        receiver_config.coalescePackets = true;
+        receiver_config.packetFactory = &packetFactory;
+
+        network::BSDSocket interface_receiver( receiver_config );
+
+        network::Address sender_address( "[127.0.0.1]:10000" );
+        network::Address receiver_address( "[127.0.0.1]:10001" );
+
+        core::TimeBase timeBase;
+        timeBase.deltaTime = 0.01f;
+
+        const int NumPackets = 32;
+
+        int numReceived = 0;
+
+        for ( int i = 0; i < NumPackets; ++i )
+        {
+            auto updatePacket = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+            updatePacket->timestamp = i;
+            interface_sender.SendPacket( receiver_address, updatePacket );
+        }
+
+        interface_sender.Update( timeBase );
+
+        CORE_CHECK( interface_sender.GetCounter( network::BSD_SOCKET_COUNTER_PACKETS_COALESCED ) > 0 );
+        CORE_CHECK( interface_sender.GetCounter( network::BSD_SOCKET_COUNTER_PACKETS_SENT ) < NumPackets );
+
+        for ( int j = 0; j < 100 && numReceived < NumPackets; ++j )
+        {
+            interface_receiver.Update( timeBase );
+
+            while ( true )
+            {
+                auto packet = interface_receiver.ReceivePacket();
+                if ( !packet )
+                    break;
+
+                CORE_CHECK( packet->GetAddress() == sender_address );
+                CORE_CHECK( packet->GetType() == PACKET_UPDATE );
+
+                // loopback preserves order, so packets arrive in the order they were queued
+
+                auto recv_updatePacket = static_cast<UpdatePacket*>( packet );
+                CORE_CHECK( recv_updatePacket->timestamp == (uint16_t) numReceived );
+                numReceived++;
+
+                packetFactory.Destroy( packet );
+            }
+
+            timeBase.time += timeBase.deltaTime;
+        }
+
+        CORE_CHECK( numReceived == NumPackets );
+    }
+    core::memory::shutdown();
+}
+
+void test_bsd_socket_send_and_receive_compressed()
+{
+    printf( "test_bsd_socket_send_and_receive_compressed\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::BSDSocketConfig sender_config;
+        sender_config.port = 10000;
+        sender_config.ipv6 = false;
+        sender_config.maxPacketSize = 1024;
+        sender_config.coalescePackets = true;
+        sender_config.compressPackets = true;
+        sender_config.packetFactory = &packetFactory;
+
+        network::BSDSocket interface_sender( sender_config );
+        
+        network::BSDSocketConfig receiver_config;
+        receiver_config.port = 10001;
+        receiver_config.ipv6 = false;
+        receiver_config.maxPacketSize = 1024;
+        receiver_config.coalescePackets = true;
+        receiver_config.compressPackets = true;
+        receiver_config.packetFactory = &packetFactory;
+
+        network::BSDSocket interface_receiver( receiver_config );
+
+        network::Address sender_address( "[127.0.0.1]:10000" );
+        network::Address receiver_address( "[127.0.0.1]:10001" );
+
+        core::TimeBase timeBase;
+        timeBase.deltaTime = 0.01f;
+
+        // identical packets coalesced into one datagram are highly compressible
+
+        const int NumPackets = 32;
+
+        for ( int i = 0; i < NumPackets; ++i )
+        {
+            auto connectPacket = (ConnectPacket*) packetFactory.Create( PACKET_CONNECT );
+            connectPacket->a = 2;
+            connectPacket->b = 6;
+            connectPacket->c = -1;
+            interface_sender.SendPacket( receiver_address, connectPacket );
+        }
+
+        interface_sender.Update( timeBase );
+
+        CORE_CHECK( interface_sender.GetCounter( network::BSD_SOCKET_COUNTER_PACKETS_COMPRESSED ) > 0 );
+        CORE_CHECK( interface_sender.GetCounter( network::BSD_SOCKET_COUNTER_BYTES_AFTER_COMPRESSION ) < 
+                    interface_sender.GetCounter( network::BSD_SOCKET_COUNTER_BYTES_BEFORE_COMPRESSION ) );
+
+        int numReceived = 0;
+
+        for ( int j = 0; j < 100 && numReceived < NumPackets; ++j )
+        {
+            interface_receiver.Update( timeBase );
+
+            while ( true )
+            {
+                auto packet = interface_receiver.ReceivePacket();
+                if ( !packet )
+                    break;
+
+                CORE_CHECK( packet->GetAddress() == sender_address );
+                CORE_CHECK( packet->GetType() == PACKET_CONNECT );
+
+                auto recv_connectPacket = static_cast<ConnectPacket*>( packet );
+                CORE_CHECK( recv_connectPacket->a == 2 );
+                CORE_CHECK( recv_connectPacket->b == 6 );
+                CORE_CHECK( recv_connectPacket->c == -1 );
+                numReceived++;
+
+                packetFactory.Destroy( packet );
+            }
+
+            timeBase.time += timeBase.deltaTime;
+        }
+
+        CORE_CHECK( numReceived == NumPackets );
+        CORE_CHECK( interface_receiver.GetCounter( network::BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES ) == 0 );
+    }
+    core::memory::shutdown();
+}
+
+void test_bsd_socket_receive_discarded_datagram()
+{
+    printf( "test_bsd_socket_receive_discarded_datagram\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        // coalesced identical packets compress well under the receiver's max packet size, but decompress past it
+
+        network::BSDSocketConfig bad_sender_config;
+        bad_sender_config.port = 10000;
+        bad_sender_config.ipv6 = false;
+        bad_sender_config.maxPacketSize = 1024;
+        bad_sender_config.coalescePackets = true;
+        bad_sender_config.compressPackets = true;
+        bad_sender_config.packetFactory = &packetFactory;
+
+        network::BSDSocket interface_bad_sender( bad_sender_config );
+
+        network::BSDSocketConfig sender_config;
+        sender_config.port = 10001;
+        sender_config.ipv6 = false;
+        sender_config.maxPacketSize = 64;
+        sender_config.compressPackets = true;
+        sender_config.packetFactory = &packetFactory;
+
+        network::BSDSocket interface_sender( sender_config );
+
+        network::BSDSocketConfig receiver_config;
+        receiver_config.port = 10002;
+        receiver_config.ipv6 = false;
+        receiver_config.maxPacketSize = 64;
+        receiver_config.compressPackets = true;
+        receiver_config.packetFactory = &packetFactory;
+
+        network::BSDSocket interface_receiver( receiver_config );
+
+        network::Address sender_address( "[127.0.0.1]:10001" );
+        network::Address receiver_address( "[127.0.0.1]:10002" );
+
+        core::TimeBase timeBase;
+        timeBase.deltaTime = 0.01f;
+
+        for ( int i = 0; i < 32; ++i )
+        {
+            auto connectPacket = (ConnectPacket*) packetFactory.Create( PACKET_CONNECT );
+            interface_bad_sender.SendPacket( receiver_address, connectPacket );
+        }
+
+        interface_bad_sender.Update( timeBase );
+
+        auto updatePacket = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+        updatePacket->timestamp = 100;
+        interface_sender.SendPacket( receiver_address, updatePacket );
+
+        interface_sender.Update( timeBase );
+
+        // the discarded datagram must not stop the receive loop, so the good packet behind it arrives in the same update
+
+        bool received = false;
+
+        for ( int j = 0; j < 100 && !received; ++j )
+        {
+            const uint64_t failures = interface_receiver.GetCounter( network::BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES );
+
+            interface_receiver.Update( timeBase );
+
+            auto packet = interface_receiver.ReceivePacket();
+
+            if ( interface_receiver.GetCounter( network::BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES ) != failures )
+                CORE_CHECK( packet );
+
+            if ( packet )
+            {
+                CORE_CHECK( packet->GetAddress() == sender_address );
+                CORE_CHECK( packet->GetType() == PACKET_UPDATE );
+                CORE_CHECK( static_cast<UpdatePacket*>( packet )->timestamp == 100 );
+                packetFactory.Destroy( packet );
+                received = true;
+            }
+
+            timeBase.time += timeBase.deltaTime;
+        }
+
+        CORE_CHECK( received );
+        CORE_CHECK( interface_receiver.GetCounter( network::BSD_SOCKET_COUNTER_DECOMPRESSION_FAILURES ) == 1 );
+    }
+    core::memory::shutdown();
+}
@@ -0,0 +1,149 @@
+#include "network/Compressor.h"
+#include "core/Memory.h"
+#include <string.h>
+#include <stdlib.h>
+
+static void generate_packet( uint8_t * packet, int bytes, int sequence )
+{
+    // mostly static header and state with a few changing fields, like real game packets
+
+    for ( int i = 0; i < bytes; ++i )
+        packet[i] = (uint8_t) ( ( i * 7 ) % 23 );
+
+    packet[0] = (uint8_t) sequence;
+    packet[1] = (uint8_t) ( sequence >> 8 );
+
+    for ( int i = 0; i < 8; ++i )
+        packet[ 16 + rand() % ( bytes - 16 ) ] = (uint8_t) rand();
+}
+
+void test_compressor()
+{
+    printf( "test_compressor\n" );
+
+    core::memory::initialize();
+    {
+        core::Allocator & allocator = core::memory::default_allocator();
+
+        network::Compressor compressor( allocator );
+
+        const int MaxBytes = 1024;
+
+        uint8_t input[MaxBytes];
+        uint8_t compressed[MaxBytes];
+        uint8_t output[MaxBytes];
+
+        // compressible data round trips and gets smaller
+
+        generate_packet( input, MaxBytes, 100 );
+
+        const int compressedBytes = compressor.Compress( input, MaxBytes, compressed, MaxBytes - 1 );
+        CORE_CHECK( compressedBytes > 0 );
+        CORE_CHECK( compressedBytes < MaxBytes / 2 );
+
+        const int outputBytes = compressor.Decompress( compressed, compressedBytes, output, MaxBytes );
+        CORE_CHECK( outputBytes == MaxBytes );
+        CORE_CHECK( memcmp( input, output, MaxBytes ) == 0 );
+
+        // random data does not compress
+
+        for ( int i = 0; i < MaxBytes; ++i )
+            input[i] = (uint8_t) rand();
+
+        CORE_CHECK( compressor.Compress( input, MaxBytes, compressed, MaxBytes - 1 ) == 0 );
+
+        // every size round trips, including empty and tiny inputs
+
+        for ( int bytes = 0; bytes < 64; ++bytes )
+        {
+            for ( int i = 0; i < bytes; ++i )
+                input[i] = (uint8_t) ( rand() % 3 );
+
+            const int n = compressor.Compress( input, bytes, compressed, MaxBytes );
+            CORE_CHECK( n > 0 );
+            CORE_CHECK( compressor.Decompress( compressed, n, output, MaxBytes ) == bytes );
+            CORE_CHECK( memcmp( input, output, bytes ) == 0 );
+        }
+
+        // malformed data is rejected without writing out of bounds
+
+        generate_packet( input, MaxBytes, 200 );
+
+        const int n = compressor.Compress( input, MaxBytes, compressed, MaxBytes - 1 );
+        CORE_CHECK( n > 0 );
+        CORE_CHECK( compressor.Decompress( compressed, n, output, MaxBytes / 2 ) == -1 );
+        CORE_CHECK( compressor.Decompress( compressed, n - 1, output, MaxBytes ) == -1 );
+        CORE_CHECK( compressor.Decompress( compressed, 0, output, MaxBytes ) == -1 );
+
+        for ( int i = 0; i < 1000; ++i )
+        {
+            for ( int j = 0; j < 64; ++j )
+                compressed[j] = (uint8_t) rand();
+            const int result = compressor.Decompress( compressed, 64, output, MaxBytes );
+            CORE_CHECK( result >= -1 && result <= MaxBytes );
+        }
+    }
+    core::memory::shutdown();
+}
+
+void test_compressor_dictionary()
+{
+    printf( "test_compressor_dictionary\n" );
+
+    core::memory::initialize();
+    {
+        core::Allocator & allocator = core::memory::default_allocator();
+
+        const int NumSamples = 256;
+        const int PacketBytes = 128;
+        const int DictionarySize = 4096;
+
+        uint8_t * samples = (uint8_t*) allocator.Allocate( NumSamples * PacketBytes );
+        int sizes[NumSamples];
+
+        for ( int i = 0; i < NumSamples; ++i )
+        {
+            generate_packet( samples + i * PacketBytes, PacketBytes, i );
+            sizes[i] = PacketBytes;
+        }
+
+        uint8_t dictionary[DictionarySize];
+
+        const int dictionarySize = network::train_dictionary( allocator, samples, sizes, NumSamples, dictionary, DictionarySize );
+        CORE_CHECK( dictionarySize > 0 );
+        CORE_CHECK( dictionarySize <= DictionarySize );
+
+        network::Compressor withoutDictionary( allocator );
+        network::Compressor withDictionary( allocator, dictionary, dictionarySize );
+
+        int bytesWithout = 0;
+        int bytesWith = 0;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            uint8_t input[PacketBytes];
+            uint8_t compressed[PacketBytes];
+            uint8_t output[PacketBytes];
+
+            generate_packet( input, PacketBytes, 1000 + i );
+
+            const int a = withoutDictionary.Compress( input, PacketBytes, compressed, PacketBytes );
+            CORE_CHECK( a > 0 );
+            bytesWithout += a;
+
+            const int b = withDictionary.Compress( input, PacketBytes, compressed, PacketBytes );
+            CORE_CHECK( b > 0 );
+            bytesWith += b;
+
+            CORE_CHECK( withDictionary.Decompress( compressed, b, output, PacketBytes ) == PacketBytes );
+            CORE_CHECK( memcmp( input, output, PacketBytes ) == 0 );
+        }
+
+        // small packets compress much better when they can reference the dictionary
+
+        CORE_CHECK( bytesWith < bytesWithout );
+
+        allocator.Free( samples );
+    }
+    core::memory::shutdown();
+}
@@ -3,120 +3,245 @@
 #if NETWORK_USE_RESOLVER
 
 #include "network/DNSResolver.h"
+#include "core/Memory.h"
+#include <stdio.h>
+
+// IMPORTANT: resolver tests run offline against a local hosts file
+
+static const char * TestHostsFile = "test_hosts.txt";
+
+static void write_test_hosts_file()
+{
+    FILE * file = fopen( TestHostsFile, "w" );
+    CORE_CHECK( file );
+    fprintf( file, "# test hosts file\n" );
+    fprintf( file, "127.0.0.1       localhost server.test\n" );
+    fprintf( file, "10.0.0.1        multi.test      # first address\n" );
+    fprintf( file, "10.0.0.2        multi.test\n" );
+    fprintf( file, "::1             localhost server.test\n" );
+    fprintf( file, "not-an-address  garbage.test\n" );
+    fclose( file );
+}
+
+static const network::ResolveEntry * wait_for_entry( network::DNSResolver & resolver, const char * name, double time = 0.0 )
+{
+    core::TimeBase timeBase;
+    timeBase.time = time;
+
+    for ( int i = 0; i < 500; ++i )
+    {
+        resolver.Update( timeBase );
+
+        auto entry = resolver.GetEntry( name );
+        if ( !entry || entry->status != network::RESOLVE_IN_PROGRESS )
+            return entry;
+
+        core::sleep_milliseconds( 10 );
+    }
+
+    return resolver.GetEntry( name );
+}
 
 void test_dns_resolve()
 {
     printf( "test_dns_resolve\n" );
 
-    network::DNSResolver resolver;
+    core::memory::initialize();
+    {
+        write_test_hosts_file();
 
-    std::string google_hostname( "google.com" );
+        network::DNSResolverConfig config;
+        config.hostsFile = TestHostsFile;
+        config.useSystemResolver = false;
+        config.ipv6 = false;
 
-    resolver.Resolve( google_hostname );
+        network::DNSResolver resolver( config );
 
-    auto google_entry = resolver.GetEntry( google_hostname );
-    CORE_CHECK( google_entry );
-    CORE_CHECK( google_entry->status == network::RESOLVE_IN_PROGRESS );
+        CORE_CHECK( resolver.GetNumHosts() == 6 );
 
-    double t = 0.0;
-    double dt = 0.1f;
-    int ms = (int) ( dt * 1000 );
+        resolver.Resolve( "server.test" );
 
-    for ( int i = 0; i < 50; ++i )
-    {
-        resolver.Update( TimeBase() );
+        auto entry = resolver.GetEntry( "server.test" );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_IN_PROGRESS );
 
-        auto google_entry = resolver.GetEntry( google_hostname );
-        if ( google_entry && google_entry->status != network::RESOLVE_IN_PROGRESS )
-            break;
+        entry = wait_for_entry( resolver, "server.test" );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_SUCCEEDED );
+        CORE_CHECK( entry->result.numAddresses == 1 );
+        CORE_CHECK( entry->result.address[0] == network::Address( "127.0.0.1" ) );
 
-        sleep_milliseconds( ms );
+        resolver.Resolve( "MULTI.test" );
 
-        t += dt;
-    }
+        entry = wait_for_entry( resolver, "MULTI.test" );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_SUCCEEDED );
+        CORE_CHECK( entry->result.numAddresses == 2 );
+        CORE_CHECK( entry->result.address[0] == network::Address( "10.0.0.1" ) );
+        CORE_CHECK( entry->result.address[1] == network::Address( "10.0.0.2" ) );
+
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_LOOKUPS_STARTED ) == 2 );
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_LOOKUPS_SUCCEEDED ) == 2 );
 
-    google_entry = resolver.GetEntry( google_hostname );
-    CORE_CHECK( google_entry );
-    CORE_CHECK( google_entry->status == network::RESOLVE_SUCCEEDED );
-    CORE_CHECK( google_entry->result.numAddresses );
+        remove( TestHostsFile );
+    }
+    core::memory::shutdown();
 }
 
 void test_dns_resolve_with_port()
 {
     printf( "test_dns_resolve_with_port\n" );
 
-    network::DNSResolver resolver;
+    core::memory::initialize();
+    {
+        write_test_hosts_file();
+
+        network::DNSResolverConfig config;
+        config.hostsFile = TestHostsFile;
+        config.useSystemResolver = false;
+
+        network::DNSResolver resolver( config );
 
-    std::string google_hostname( "google.com:5000" );
+        resolver.Resolve( "server.test:5000" );
 
-    resolver.Resolve( google_hostname );
+        auto entry = wait_for_entry( resolver, "server.test:5000" );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_SUCCEEDED );
+        CORE_CHECK( entry->result.numAddresses == 1 );
+        CORE_CHECK( entry->result.address[0] == network::Address( "::1", 5000 ) );
+        for ( int i = 0; i < entry->result.numAddresses; ++i )
+            CORE_CHECK( entry->result.address[i].GetPort() == 5000 );
 
-    auto google_entry = resolver.GetEntry( google_hostname );
-    CORE_CHECK( google_entry );
-    CORE_CHECK( google_entry->status == network::RESOLVE_IN_PROGRESS );
+        remove( TestHostsFile );
+    }
+    core::memory::shutdown();
+}
 
-    double t = 0.0;
-    double dt = 0.1f;
-    int ms = (int) ( dt * 1000 );
+void test_dns_resolve_failure()
+{
+    printf( "test_dns_resolve_failure\n" );
 
-    for ( int i = 0; i < 50; ++i )
+    core::memory::initialize();
     {
-        resolver.Update( TimeBase() );
+        write_test_hosts_file();
 
-        auto google_entry = resolver.GetEntry( google_hostname );
-        if ( google_entry && google_entry->status != network::RESOLVE_IN_PROGRESS )
-            break;
+        network::DNSResolverConfig config;
+        config.hostsFile = TestHostsFile;
+        config.useSystemResolver = false;
 
-        sleep_milliseconds( ms );
+        network::DNSResolver resolver( config );
 
-        t += dt;
-    }
+        resolver.Resolve( "aoeusoanthuoaenuhansuhtasthas" );
+        resolver.Resolve( "garbage.test" );
+
+        auto entry = wait_for_entry( resolver, "aoeusoanthuoaenuhansuhtasthas" );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_FAILED );
+        CORE_CHECK( entry->result.numAddresses == 0 );
 
-    google_entry = resolver.GetEntry( google_hostname );
-    CORE_CHECK( google_entry );
-    CORE_CHECK( google_entry->status == network::RESOLVE_SUCCEEDED );
-    CORE_CHECK( google_entry->result.numAddresses );
-    for ( int i = 0; i < google_entry->result.numAddresses; ++i )
-        CORE_CHECK( google_entry->result.address[i].GetPort() == 5000 );
+        entry = wait_for_entry( resolver, "garbage.test" );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_FAILED );
+
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_LOOKUPS_FAILED ) == 2 );
+
+        remove( TestHostsFile );
+    }
+    core::memory::shutdown();
 }
 
-void test_dns_resolve_failure()
+void test_dns_resolve_cache()
 {
-    printf( "test_dns_resolve_failure\n" );
+    printf( "test_dns_resolve_cache\n" );
+
+    core::memory::initialize();
+    {
+        write_test_hosts_file();
 
-    network::DNSResolver resolver;
+        network::DNSResolverConfig config;
+        config.hostsFile = TestHostsFile;
+        config.useSystemResolver = false;
+        config.numThreads = 4;
+        config.maxEntries = 2;
+        config.cacheTime = 10.0;
+        config.failedCacheTime = 1.0;
 
-    std::string garbage_hostname( "aoeusoanthuoaenuhansuhtasthas" );
+        network::DNSResolver resolver( config );
 
-//    printf( "resolving garbage hostname: %s\n", garbage_hostname.c_str() );
+        // identical names in flight are coalesced into one lookup
 
-    resolver.Resolve( garbage_hostname );
+        for ( int i = 0; i < 10; ++i )
+            resolver.Resolve( "server.test" );
 
-    auto entry = resolver.GetEntry( garbage_hostname );
-    CORE_CHECK( entry );
-    CORE_CHECK( entry->status == network::RESOLVE_IN_PROGRESS );
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_LOOKUPS_STARTED ) == 1 );
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_LOOKUPS_COALESCED ) == 9 );
 
-    double t = 0.0;
-    double dt = 0.1f;
-    int ms = (int) ( dt * 1000 );
+        auto entry = wait_for_entry( resolver, "server.test" );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_SUCCEEDED );
 
-    while ( true )
-    {
-        resolver.Update( TimeBase() );
+        // cached until the ttl expires, then looked up again
 
-        auto entry = resolver.GetEntry( garbage_hostname );
-        if ( entry && entry->status != network::RESOLVE_IN_PROGRESS )
-            break;
+        core::TimeBase timeBase;
+        timeBase.time = 5.0;
+        resolver.Update( timeBase );
 
-        sleep_milliseconds( ms );
+        resolver.Resolve( "server.test" );
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_CACHE_HITS ) == 1 );
+        CORE_CHECK( resolver.GetEntry( "server.test" )->status == network::RESOLVE_SUCCEEDED );
 
-        t += dt;
-    }
+        timeBase.time = 20.0;
+        resolver.Update( timeBase );
 
-    entry = resolver.GetEntry( garbage_hostname );
-    CORE_CHECK( entry );
+        resolver.Resolve( "server.test" );
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_CACHE_EXPIRED ) == 1 );
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_LOOKUPS_STARTED ) == 2 );
+        CORE_CHECK( resolver.GetEntry( "server.test" )->status == network::RESOLVE_IN_PROGRESS );
 
-    CORE_CHECK( entry->status == network::RESOLVE_FAILED );
+        entry = wait_for_entry( resolver, "server.test", timeBase.time );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_SUCCEEDED );
+
+        // when full, the completed entry closest to expiring is evicted
+
+        resolver.Resolve( "nothing.test" );
+        entry = wait_for_entry( resolver, "nothing.test", timeBase.time );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_FAILED );
+
+        resolver.Resolve( "multi.test" );
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_CACHE_EVICTIONS ) == 1 );
+        CORE_CHECK( resolver.GetEntry( "nothing.test" ) == nullptr );
+        CORE_CHECK( resolver.GetEntry( "server.test" ) != nullptr );
+
+        // clearing with a lookup in flight drops its result when it completes
+
+        resolver.Clear();
+        CORE_CHECK( resolver.GetEntry( "multi.test" ) == nullptr );
+        CORE_CHECK( resolver.GetEntry( "server.test" ) == nullptr );
+
+        for ( int i = 0; i < 50; ++i )
+        {
+            resolver.Update( timeBase );
+            core::sleep_milliseconds( 1 );
+        }
+
+        resolver.Resolve( "server.test" );
+        resolver.Resolve( "localhost" );
+
+        entry = wait_for_entry( resolver, "localhost", timeBase.time );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_SUCCEEDED );
+
+        entry = wait_for_entry( resolver, "server.test", timeBase.time );
+        CORE_CHECK( entry );
+        CORE_CHECK( entry->status == network::RESOLVE_SUCCEEDED );
+
+        CORE_CHECK( resolver.GetCounter( network::DNS_RESOLVER_COUNTER_CACHE_FULL ) == 0 );
+
+        remove( TestHostsFile );
+    }
+    core::memory::shutdown();
 }
 
 #else
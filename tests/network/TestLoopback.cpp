@@ -0,0 +1,107 @@
+#include "network/Network.h"
+#include "network/Loopback.h"
+#include "TestPackets.h"
+
+static void test_loopback( bool serializePackets )
+{
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::LoopbackNetwork loopbackNetwork( core::memory::default_allocator(), 1024 );
+
+        const int NumInterfaces = 8;
+
+        network::LoopbackInterface * interfaces[NumInterfaces];
+
+        for ( int i = 0; i < NumInterfaces; ++i )
+        {
+            network::LoopbackConfig config;
+            config.network = &loopbackNetwork;
+            config.address = network::Address( "::1" );
+            config.address.SetPort( 10000 + i );
+            config.receiveQueueSize = 16;
+            config.serializePackets = serializePackets;
+            config.packetFactory = &packetFactory;
+            interfaces[i] = CORE_NEW( core::memory::default_allocator(), network::LoopbackInterface, config );
+        }
+
+        CORE_CHECK( loopbackNetwork.GetNumInterfaces() == NumInterfaces );
+
+        for ( int i = 0; i < NumInterfaces; ++i )
+            CORE_CHECK( loopbackNetwork.FindInterface( interfaces[i]->GetAddress() ) == interfaces[i] );
+
+        const int NumIterations = 100;
+
+        for ( int iteration = 0; iteration < NumIterations; ++iteration )
+        {
+            // every interface sends one packet to the next one
+
+            for ( int i = 0; i < NumInterfaces; ++i )
+            {
+                auto & to = interfaces[(i+1)%NumInterfaces]->GetAddress();
+                auto packet = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+                packet->timestamp = iteration * NumInterfaces + i;
+                interfaces[i]->SendPacket( to, packet );
+            }
+
+            for ( int i = 0; i < NumInterfaces; ++i )
+            {
+                const int from = ( i + NumInterfaces - 1 ) % NumInterfaces;
+
+                auto packet = interfaces[i]->ReceivePacket();
+                CORE_CHECK( packet );
+                CORE_CHECK( packet->GetType() == PACKET_UPDATE );
+                CORE_CHECK( packet->GetAddress() == interfaces[from]->GetAddress() );
+                CORE_CHECK( ( (UpdatePacket*) packet )->timestamp == iteration * NumInterfaces + from );
+                packetFactory.Destroy( packet );
+
+                CORE_CHECK( interfaces[i]->ReceivePacket() == nullptr );
+            }
+        }
+
+        // buffers are reused, not allocated per-packet
+
+        if ( serializePackets )
+            CORE_CHECK( loopbackNetwork.GetNumBuffers() <= NumInterfaces );
+        else
+            CORE_CHECK( loopbackNetwork.GetNumBuffers() == 0 );
+
+        // packets to an address with no interface are dropped
+
+        network::Address nowhere( "::1" );
+        nowhere.SetPort( 9999 );
+        interfaces[0]->SendPacket( nowhere, packetFactory.Create( PACKET_UPDATE ) );
+        CORE_CHECK( interfaces[0]->GetCounter( network::LOOPBACK_COUNTER_NO_ENDPOINT ) == 1 );
+
+        // packets past the receive queue size are dropped. packets left in the queue are cleaned up on shutdown
+
+        for ( int i = 0; i < 20; ++i )
+            interfaces[0]->SendPacket( interfaces[1]->GetAddress(), packetFactory.Create( PACKET_CONNECT ) );
+
+        CORE_CHECK( interfaces[1]->GetCounter( network::LOOPBACK_COUNTER_RECEIVE_QUEUE_FULL ) == 4 );
+        CORE_CHECK( interfaces[0]->GetCounter( network::LOOPBACK_COUNTER_PACKETS_SENT ) == NumIterations + 20 );
+        CORE_CHECK( interfaces[1]->GetCounter( network::LOOPBACK_COUNTER_PACKETS_RECEIVED ) == NumIterations );
+
+        typedef network::LoopbackInterface LoopbackInterface;
+        for ( int i = 0; i < NumInterfaces; ++i )
+            CORE_DELETE( core::memory::default_allocator(), LoopbackInterface, interfaces[i] );
+
+        CORE_CHECK( loopbackNetwork.GetNumInterfaces() == 0 );
+    }
+    core::memory::shutdown();
+}
+
+void test_loopback_serialize()
+{
+    printf( "test_loopback_serialize\n" );
+
+    test_loopback( true );
+}
+
+void test_loopback_passthrough()
+{
+    printf( "test_loopback_passthrough\n" );
+
+    test_loopback( false );
+}
@@ -1,21 +1,39 @@
 #include "core/Core.h"
 #include "network/Network.h"
+#include "network/Config.h"
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 extern void test_address4();
 extern void test_address6();
+extern void test_address_compare();
 
 extern void test_bsd_socket_send_and_receive_ipv4();
 extern void test_bsd_socket_send_and_receive_ipv6();
 extern void test_bsd_socket_send_and_receive_multiple_ipv4();
 extern void test_bsd_socket_send_and_receive_multiple_ipv6();
+extern void test_bsd_socket_send_and_receive_coalesced();
+extern void test_bsd_socket_send_and_receive_compressed();
+extern void test_bsd_socket_receive_discarded_datagram();
 
-#if PROTOCOL_USE_RESOLVER
+extern void test_compressor();
+extern void test_compressor_dictionary();
+
+extern void test_simulator_udp();
+extern void test_simulator_tcp();
+extern void test_simulator_link_models();
+extern void test_simulator_queue();
+extern void test_simulator_trace();
+
+extern void test_loopback_serialize();
+extern void test_loopback_passthrough();
+
+#if NETWORK_USE_RESOLVER
 extern void test_dns_resolve();
 extern void test_dns_resolve_with_port();
 extern void test_dns_resolve_failure();
+extern void test_dns_resolve_cache();
 #endif
 
 int main()
@@ -32,16 +50,33 @@ int main()
 
     test_address4();
     test_address6();
+    test_address_compare();
 
     test_bsd_socket_send_and_receive_ipv4();
     test_bsd_socket_send_and_receive_ipv6();
     test_bsd_socket_send_and_receive_multiple_ipv4();
     test_bsd_socket_send_and_receive_multiple_ipv6();
+    test_bsd_socket_send_and_receive_coalesced();
+    test_bsd_socket_send_and_receive_compressed();
+    test_bsd_socket_receive_discarded_datagram();
+
+    test_compressor();
+    test_compressor_dictionary();
+
+    test_simulator_udp();
+    test_simulator_tcp();
+    test_simulator_link_models();
+    test_simulator_queue();
+    test_simulator_trace();
+
+    test_loopback_serialize();
+    test_loopback_passthrough();
 
-#if PROTOCOL_USE_RESOLVER
+#if NETWORK_USE_RESOLVER
     test_dns_resolve();
     test_dns_resolve_with_port();
     test_dns_resolve_failure();
+    test_dns_resolve_cache();
 #endif
 
     network::ShutdownNetwork();
@@ -0,0 +1,464 @@
+#include "network/Network.h"
+#include "network/Simulator.h"
+#include "TestPackets.h"
+
+void test_simulator_udp()
+{
+    printf( "test_simulator_udp\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::SimulatorConfig config;
+        config.packetFactory = &packetFactory;
+        config.numPackets = 256;
+
+        network::Simulator simulator( config );
+
+        network::Address address( "127.0.0.1" );
+        address.SetPort( 10000 );
+
+        core::TimeBase timeBase;
+        timeBase.time = 0.0;
+        timeBase.deltaTime = 0.01;
+
+        simulator.Update( timeBase );
+
+        // give each packet its own latency so the delivery order is known
+
+        const int NumPackets = 200;
+
+        float latency[NumPackets];
+
+        for ( int i = 0; i < NumPackets; ++i )
+        {
+            latency[i] = core::random_float( 0.0f, 1.0f );
+
+            simulator.ClearStates();
+            simulator.AddState( network::SimulatorState( latency[i], 0.0f, 0.0f ) );
+
+            auto packet = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+            packet->timestamp = i;
+            simulator.SendPacket( address, packet );
+        }
+
+        simulator.ClearStates();
+
+        int numReceived = 0;
+        float previousLatency = 0.0f;
+
+        while ( timeBase.time < 1.0 + timeBase.deltaTime )
+        {
+            timeBase.time += timeBase.deltaTime;
+
+            simulator.Update( timeBase );
+
+            while ( true )
+            {
+                auto packet = simulator.ReceivePacket();
+                if ( !packet )
+                    break;
+
+                CORE_CHECK( packet->GetType() == PACKET_UPDATE );
+                CORE_CHECK( packet->GetAddress() == address );
+
+                const int index = ( (UpdatePacket*) packet )->timestamp;
+                CORE_CHECK( index >= 0 );
+                CORE_CHECK( index < NumPackets );
+                CORE_CHECK( latency[index] <= timeBase.time );
+                CORE_CHECK( latency[index] >= previousLatency );
+
+                previousLatency = latency[index];
+                numReceived++;
+
+                packetFactory.Destroy( packet );
+            }
+        }
+
+        CORE_CHECK( numReceived == NumPackets );
+
+        // when the packet buffer wraps the oldest packets are dropped
+
+        simulator.AddState( network::SimulatorState( 0.5f, 0.0f, 0.0f ) );
+
+        for ( int i = 0; i < config.numPackets + 10; ++i )
+        {
+            auto packet = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+            packet->timestamp = i;
+            simulator.SendPacket( address, packet );
+        }
+
+        timeBase.time += 1.0;
+        simulator.Update( timeBase );
+
+        numReceived = 0;
+        int previousTimestamp = -1;
+
+        while ( true )
+        {
+            auto packet = simulator.ReceivePacket();
+            if ( !packet )
+                break;
+
+            const int timestamp = ( (UpdatePacket*) packet )->timestamp;
+            CORE_CHECK( timestamp >= 10 );
+            CORE_CHECK( timestamp > previousTimestamp );
+            previousTimestamp = timestamp;
+            numReceived++;
+
+            packetFactory.Destroy( packet );
+        }
+
+        CORE_CHECK( numReceived == config.numPackets );
+    }
+    core::memory::shutdown();
+}
+
+void test_simulator_tcp()
+{
+    printf( "test_simulator_tcp\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::SimulatorConfig config;
+        config.packetFactory = &packetFactory;
+
+        network::Simulator simulator( config );
+
+        simulator.SetTCPMode( true );
+
+        simulator.AddState( network::SimulatorState( 0.1f, 0.05f, 10.0f ) );
+
+        network::Address address( "127.0.0.1" );
+        address.SetPort( 10000 );
+
+        core::TimeBase timeBase;
+        timeBase.time = 0.0;
+        timeBase.deltaTime = 0.01;
+
+        const int NumPackets = 100;
+
+        int numSent = 0;
+        int numReceived = 0;
+
+        for ( int i = 0; i < 1000; ++i )
+        {
+            simulator.Update( timeBase );
+
+            if ( numSent < NumPackets )
+            {
+                auto packet = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+                packet->timestamp = numSent++;
+                simulator.SendPacket( address, packet );
+            }
+
+            while ( true )
+            {
+                auto packet = simulator.ReceivePacket();
+                if ( !packet )
+                    break;
+
+                // TCP mode never drops and always delivers in order
+
+                CORE_CHECK( ( (UpdatePacket*) packet )->timestamp == numReceived );
+                numReceived++;
+
+                packetFactory.Destroy( packet );
+            }
+
+            timeBase.time += timeBase.deltaTime;
+        }
+
+        CORE_CHECK( numReceived == NumPackets );
+    }
+    core::memory::shutdown();
+}
+
+static int receive_all( network::Simulator & simulator, TestPacketFactory & packetFactory )
+{
+    int numReceived = 0;
+    while ( true )
+    {
+        auto packet = simulator.ReceivePacket();
+        if ( !packet )
+            break;
+        numReceived++;
+        packetFactory.Destroy( packet );
+    }
+    return numReceived;
+}
+
+void test_simulator_link_models()
+{
+    printf( "test_simulator_link_models\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::SimulatorConfig config;
+        config.packetFactory = &packetFactory;
+
+        network::Simulator simulator( config );
+
+        network::Address address( "127.0.0.1" );
+        address.SetPort( 10000 );
+
+        core::TimeBase timeBase;
+        timeBase.time = 0.0;
+        timeBase.deltaTime = 0.01;
+
+        simulator.Update( timeBase );
+
+        const int NumPackets = 10;
+
+        // duplication
+
+        {
+            network::SimulatorState state;
+            state.duplicateChance = 100.0f;
+            simulator.ClearStates();
+            simulator.AddState( state );
+
+            for ( int i = 0; i < NumPackets; ++i )
+                simulator.SendPacket( address, packetFactory.Create( PACKET_UPDATE ) );
+
+            CORE_CHECK( receive_all( simulator, packetFactory ) == NumPackets * 2 );
+        }
+
+        // reordered packets are held back past latency, so packets sent after them overtake them
+
+        {
+            network::SimulatorState state( 0.1f, 0.0f, 0.0f );
+            state.reorderChance = 100.0f;
+            state.reorderDelay = 0.05f;
+            simulator.ClearStates();
+            simulator.AddState( state );
+
+            auto heldPacket = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+            heldPacket->timestamp = 1;
+            simulator.SendPacket( address, heldPacket );
+
+            state.reorderChance = 0.0f;
+            simulator.ClearStates();
+            simulator.AddState( state );
+
+            auto nextPacket = (UpdatePacket*) packetFactory.Create( PACKET_UPDATE );
+            nextPacket->timestamp = 2;
+            simulator.SendPacket( address, nextPacket );
+
+            CORE_CHECK( receive_all( simulator, packetFactory ) == 0 );
+
+            timeBase.time += 0.125;
+            simulator.Update( timeBase );
+
+            auto packet = simulator.ReceivePacket();
+            CORE_CHECK( packet );
+            CORE_CHECK( static_cast<UpdatePacket*>( packet )->timestamp == 2 );
+            packetFactory.Destroy( packet );
+
+            CORE_CHECK( receive_all( simulator, packetFactory ) == 0 );
+
+            timeBase.time += 0.05;
+            simulator.Update( timeBase );
+
+            packet = simulator.ReceivePacket();
+            CORE_CHECK( packet );
+            CORE_CHECK( static_cast<UpdatePacket*>( packet )->timestamp == 1 );
+            packetFactory.Destroy( packet );
+        }
+
+        // burst loss
+
+        {
+            network::SimulatorState state;
+            state.burstChance = 100.0f;
+            state.burstEndChance = 0.0f;
+            state.burstPacketLoss = 100.0f;
+            simulator.ClearStates();
+            simulator.AddState( state );
+
+            for ( int i = 0; i < NumPackets; ++i )
+                simulator.SendPacket( address, packetFactory.Create( PACKET_UPDATE ) );
+
+            CORE_CHECK( receive_all( simulator, packetFactory ) == 0 );
+
+            simulator.Reset();
+        }
+
+        // bandwidth cap queues packets behind each other
+
+        {
+            network::SimulatorState state;
+            state.bandwidth = 100.0f;
+            simulator.ClearStates();
+            simulator.AddState( state );
+
+            for ( int i = 0; i < NumPackets; ++i )
+                simulator.SendPacket( address, packetFactory.Create( PACKET_UPDATE ) );
+
+            // each packet is about 30 bytes with the header, so roughly 2.4ms per packet at 100kbps
+
+            CORE_CHECK( receive_all( simulator, packetFactory ) == 0 );
+
+            timeBase.time += 0.0125;
+            simulator.Update( timeBase );
+
+            CORE_CHECK( receive_all( simulator, packetFactory ) == 5 );
+
+            timeBase.time += 0.0125;
+            simulator.Update( timeBase );
+
+            CORE_CHECK( receive_all( simulator, packetFactory ) == 5 );
+        }
+    }
+    core::memory::shutdown();
+}
+
+void test_simulator_queue()
+{
+    printf( "test_simulator_queue\n" );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::Address address( "127.0.0.1" );
+        address.SetPort( 10000 );
+
+        const int QueueSize = 300;
+        const int NumPackets = 100;
+
+        network::SimulatorState state;
+        state.bandwidth = 100.0f;
+
+        // drop tail: a burst larger than the queue loses everything past the queue size
+
+        int dropTailReceived = 0;
+
+        {
+            network::SimulatorConfig config;
+            config.packetFactory = &packetFactory;
+            config.queueSize = QueueSize;
+            config.queueMode = network::SIMULATOR_QUEUE_DROP_TAIL;
+
+            network::Simulator simulator( config );
+            simulator.AddState( state );
+
+            core::TimeBase timeBase;
+            simulator.Update( timeBase );
+
+            for ( int i = 0; i < NumPackets; ++i )
+                simulator.SendPacket( address, packetFactory.Create( PACKET_UPDATE ) );
+
+            CORE_CHECK( simulator.GetNumQueueDrops() > 0 );
+            CORE_CHECK( simulator.GetQueueDelay() > 0.0f );
+
+            timeBase.time = 10.0;
+            simulator.Update( timeBase );
+
+            dropTailReceived = receive_all( simulator, packetFactory );
+
+            CORE_CHECK( dropTailReceived > 0 );
+            CORE_CHECK( dropTailReceived == NumPackets - (int) simulator.GetNumQueueDrops() );
+
+            // packets excluded from bandwidth bypass the bottleneck
+
+            const uint64_t numQueueDrops = simulator.GetNumQueueDrops();
+
+            for ( int i = 0; i < NumPackets; ++i )
+            {
+                simulator.SetBandwidthExclude( true );
+                simulator.SendPacket( address, packetFactory.Create( PACKET_UPDATE ) );
+                simulator.SetBandwidthExclude( false );
+            }
+
+            CORE_CHECK( simulator.GetNumQueueDrops() == numQueueDrops );
+            CORE_CHECK( receive_all( simulator, packetFactory ) == NumPackets );
+        }
+
+        // RED: starts dropping before the queue is full
+
+        {
+            network::SimulatorConfig config;
+            config.packetFactory = &packetFactory;
+            config.queueSize = QueueSize;
+            config.queueMode = network::SIMULATOR_QUEUE_RED;
+            config.redWeight = 1.0f;
+
+            network::Simulator simulator( config );
+            simulator.AddState( state );
+
+            core::TimeBase timeBase;
+            simulator.Update( timeBase );
+
+            for ( int i = 0; i < NumPackets; ++i )
+                simulator.SendPacket( address, packetFactory.Create( PACKET_UPDATE ) );
+
+            timeBase.time = 10.0;
+            simulator.Update( timeBase );
+
+            const int numReceived = receive_all( simulator, packetFactory );
+            CORE_CHECK( numReceived > 0 );
+            CORE_CHECK( numReceived < dropTailReceived );
+            CORE_CHECK( numReceived == NumPackets - (int) simulator.GetNumQueueDrops() );
+        }
+    }
+    core::memory::shutdown();
+}
+
+void test_simulator_trace()
+{
+    printf( "test_simulator_trace\n" );
+
+    const char * filename = "simulator_trace.txt";
+
+    FILE * file = fopen( filename, "w" );
+    CORE_CHECK( file );
+    fprintf( file, "# time latency jitter loss\n" );
+    fprintf( file, "0.0 0.1 0.0 0\n" );
+    fprintf( file, "1.0 0.2 0.01 5\n" );
+    fprintf( file, "\n" );
+    fprintf( file, "2.0 0.3 0.02 10\n" );
+    fclose( file );
+
+    core::memory::initialize();
+    {
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        network::SimulatorConfig config;
+        config.packetFactory = &packetFactory;
+
+        network::Simulator simulator( config );
+
+        CORE_CHECK( !simulator.LoadTrace( "does_not_exist.txt" ) );
+
+        CORE_CHECK( simulator.LoadTrace( filename ) );
+
+        core::TimeBase timeBase;
+        timeBase.time = 100.0;
+
+        simulator.Update( timeBase );
+        CORE_CHECK( simulator.GetState().latency == 0.1f );
+
+        timeBase.time = 101.5;
+        simulator.Update( timeBase );
+        CORE_CHECK( simulator.GetState().latency == 0.2f );
+        CORE_CHECK( simulator.GetState().jitter == 0.01f );
+        CORE_CHECK( simulator.GetState().packetLoss == 5.0f );
+
+        // the trace loops
+
+        timeBase.time = 102.5;
+        simulator.Update( timeBase );
+        CORE_CHECK( simulator.GetState().latency == 0.1f );
+
+        simulator.ClearTrace();
+    }
+    core::memory::shutdown();
+
+    remove( filename );
+}
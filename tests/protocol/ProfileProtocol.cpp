@@ -1,3 +1,5 @@
 #define PROFILE 1
 
+// IMPORTANT: build the protocol library with -DPROTOCOL_STREAM_STATS=1 as well to get per-scope bit stats
+
 #include "SoakProtocol.cpp"
\ No newline at end of file
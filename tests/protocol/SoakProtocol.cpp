@@ -101,6 +101,9 @@ void soak_test()
     uint16_t sendMessageId = 0;
     uint64_t numMessagesSent = 0;
     uint64_t numMessagesReceived = 0;
+#if PROFILE && PROTOCOL_STREAM_STATS
+    uint64_t numIterations = 0;
+#endif
 
     core::TimeBase timeBase;
     timeBase.time = 0.0;
@@ -235,6 +238,15 @@ void soak_test()
         CORE_CHECK( messageChannel->GetCounter( protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_RECEIVED ) == numMessagesReceived );
         CORE_CHECK( messageChannel->GetCounter( protocol::RELIABLE_MESSAGE_CHANNEL_COUNTER_MESSAGES_EARLY ) == 0 );
 
+#if PROFILE && PROTOCOL_STREAM_STATS
+        const int StatsDumpInterval = 1000;
+        if ( ++numIterations % StatsDumpInterval == 0 )
+        {
+            printf( "%09.2f - stream stats\n", timeBase.time );
+            protocol::stream_stats::dump();
+        }
+#endif
+
         timeBase.time += timeBase.deltaTime;
     }
 }
@@ -56,4 +56,22 @@ void test_bitpacker()
 
     CORE_CHECK( reader.GetBitsRead() == bitsWritten );
     CORE_CHECK( reader.GetBitsRemaining() == BufferSize * 8 - bitsWritten );
+
+    // a reader sized to exactly the bytes written can read right up to its last bit
+
+    const int bytesWritten = writer.GetBytesWritten();
+
+    protocol::BitReader exactReader( buffer, bytesWritten );
+
+    CORE_CHECK( exactReader.ReadBits( 1 ) == 0 );
+    CORE_CHECK( exactReader.ReadBits( 1 ) == 1 );
+    CORE_CHECK( exactReader.ReadBits( 8 ) == 10 );
+    CORE_CHECK( exactReader.ReadBits( 8 ) == 255 );
+    CORE_CHECK( exactReader.ReadBits( 10 ) == 1000 );
+    CORE_CHECK( exactReader.ReadBits( 16 ) == 50000 );
+    CORE_CHECK( exactReader.ReadBits( 32 ) == 9999999 );
+    CORE_CHECK( exactReader.ReadBits( bytesWritten * 8 - bitsWritten ) == 0 );
+
+    CORE_CHECK( exactReader.GetBitsRemaining() == 0 );
+    CORE_CHECK( !exactReader.IsOverflow() );
 }
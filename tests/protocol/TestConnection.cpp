@@ -1,6 +1,8 @@
 #include "protocol/Connection.h"
 #include "core/Memory.h"
 #include "TestPackets.h"
+#include "TestMessages.h"
+#include "TestChannelStructure.h"
 
 class FakeChannel : public protocol::ChannelAdapter 
 {
@@ -194,3 +196,202 @@ void test_acks()
     }
     core::memory::shutdown();
 }
+
+static int exchange_packets( protocol::Connection & sender, protocol::Connection & receiver, protocol::PacketFactory & packetFactory, int latency, int numIterations, int dropEvery )
+{
+    // packets take latency iterations each way, and every dropEvery-th packet from the sender is dropped
+
+    const int MaxLatency = 64;
+
+    CORE_ASSERT( latency > 0 );
+    CORE_ASSERT( latency <= MaxLatency );
+
+    protocol::ConnectionPacket * toReceiver[MaxLatency];
+    protocol::ConnectionPacket * toSender[MaxLatency];
+    memset( toReceiver, 0, sizeof( toReceiver ) );
+    memset( toSender, 0, sizeof( toSender ) );
+
+    core::TimeBase timeBase;
+    timeBase.deltaTime = 1.0f / 60.0f;
+
+    int numDropped = 0;
+
+    for ( int i = 0; i < numIterations; ++i )
+    {
+        sender.Update( timeBase );
+        receiver.Update( timeBase );
+
+        const int index = i % latency;
+
+        if ( toReceiver[index] )
+        {
+            receiver.ReadPacket( toReceiver[index] );
+            packetFactory.Destroy( toReceiver[index] );
+            toReceiver[index] = nullptr;
+        }
+
+        if ( toSender[index] )
+        {
+            sender.ReadPacket( toSender[index] );
+            packetFactory.Destroy( toSender[index] );
+            toSender[index] = nullptr;
+        }
+
+        toReceiver[index] = sender.WritePacket();
+        toSender[index] = receiver.WritePacket();
+
+        CORE_CHECK( toReceiver[index] );
+        CORE_CHECK( toSender[index] );
+
+        if ( dropEvery && ( i % dropEvery ) == 0 )
+        {
+            packetFactory.Destroy( toReceiver[index] );
+            toReceiver[index] = nullptr;
+            numDropped++;
+        }
+
+        timeBase.time += timeBase.deltaTime;
+    }
+
+    for ( int i = 0; i < MaxLatency; ++i )
+    {
+        if ( toReceiver[i] )
+            packetFactory.Destroy( toReceiver[i] );
+        if ( toSender[i] )
+            packetFactory.Destroy( toSender[i] );
+    }
+
+    return numDropped;
+}
+
+void test_connection_rtt_and_packet_loss()
+{
+    printf( "test_connection_rtt_and_packet_loss\n" );
+
+    core::memory::initialize();
+    {
+        FakeChannelStructure channelStructure;
+
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        protocol::ConnectionConfig connectionConfig;
+        connectionConfig.packetFactory = &packetFactory;
+        connectionConfig.channelStructure = &channelStructure;
+
+        // one second RTT at 60 packets per second: acks arrive long after 32 newer packets are sent, but nothing is lost
+
+        const int Latency = 30;
+        const float RTT = 2 * Latency / 60.0f;
+
+        {
+            protocol::Connection sender( connectionConfig );
+            protocol::Connection receiver( connectionConfig );
+
+            exchange_packets( sender, receiver, packetFactory, Latency, 600, 0 );
+
+            CORE_CHECK( fabs( sender.GetRTT() - RTT ) < 0.001f );
+            CORE_CHECK( sender.GetPacketLoss() < 1.0f );
+            CORE_CHECK( sender.GetCounter( protocol::CONNECTION_COUNTER_PACKETS_LOST ) == 0 );
+            CORE_CHECK( sender.GetCounter( protocol::CONNECTION_COUNTER_PACKETS_ACKED ) > 500 );
+        }
+
+        // same RTT with one in four packets dropped. packets still waiting on their ack at the end aren't counted yet
+
+        {
+            protocol::Connection sender( connectionConfig );
+            protocol::Connection receiver( connectionConfig );
+
+            const int numDropped = exchange_packets( sender, receiver, packetFactory, Latency, 600, 4 );
+
+            const uint64_t numLost = sender.GetCounter( protocol::CONNECTION_COUNTER_PACKETS_LOST );
+
+            CORE_CHECK( fabs( sender.GetRTT() - RTT ) < 0.001f );
+            CORE_CHECK( sender.GetPacketLoss() > 15.0f );
+            CORE_CHECK( sender.GetPacketLoss() < 35.0f );
+            CORE_CHECK( numLost <= (uint64_t) numDropped );
+            CORE_CHECK( numLost >= (uint64_t) numDropped - 20 );
+            CORE_CHECK( receiver.GetCounter( protocol::CONNECTION_COUNTER_PACKETS_LOST ) == 0 );
+        }
+    }
+    core::memory::shutdown();
+}
+
+static int measure_packet( protocol::ConnectionPacket * packet, const void ** context, int maxPacketSize )
+{
+    protocol::MeasureStream measureStream( maxPacketSize );
+    measureStream.SetContext( context );
+    packet->SerializeMeasure( measureStream );
+    return measureStream.GetBytesProcessed();
+}
+
+void test_connection_packet_size()
+{
+    printf( "test_connection_packet_size\n" );
+
+    core::memory::initialize();
+    {
+        TestMessageFactory messageFactory( core::memory::default_allocator() );
+
+        TestChannelStructure channelStructure( messageFactory );
+
+        TestPacketFactory packetFactory( core::memory::default_allocator() );
+
+        const void * context[protocol::MaxContexts];
+        memset( context, 0, sizeof( context ) );
+        context[protocol::CONTEXT_CONNECTION] = &channelStructure;
+
+        const int MaxPacketSize = 1024;
+        const int SmallPacketSize = 64;
+
+        protocol::ConnectionConfig connectionConfig;
+        connectionConfig.maxPacketSize = MaxPacketSize;
+        connectionConfig.packetFactory = &packetFactory;
+        connectionConfig.channelStructure = &channelStructure;
+
+        protocol::Connection connection( connectionConfig );
+
+        CORE_CHECK( connection.GetPacketSize() == MaxPacketSize );
+
+        auto messageChannel = static_cast<protocol::ReliableMessageChannel*>( connection.GetChannel( 0 ) );
+
+        for ( int i = 0; i < 32; ++i )
+        {
+            auto message = (TestMessage*) messageFactory.Create( MESSAGE_TEST );
+            CORE_CHECK( message );
+            message->sequence = i;
+            messageChannel->SendMessage( message );
+        }
+
+        // with a small packet size, channel data is cut down to fit
+
+        connection.SetPacketSize( SmallPacketSize );
+
+        CORE_CHECK( connection.GetPacketSize() == SmallPacketSize );
+
+        auto packet = connection.WritePacket();
+        CORE_CHECK( packet );
+        CORE_CHECK( packet->channelData[0] );
+        const int smallBytes = measure_packet( packet, context, MaxPacketSize );
+        CORE_CHECK( smallBytes <= SmallPacketSize );
+        packetFactory.Destroy( packet );
+
+        // back at full size the channel is limited only by its own budget
+
+        connection.SetPacketSize( MaxPacketSize );
+
+        packet = connection.WritePacket();
+        CORE_CHECK( packet );
+        CORE_CHECK( packet->channelData[0] );
+        const int largeBytes = measure_packet( packet, context, MaxPacketSize );
+        CORE_CHECK( largeBytes > SmallPacketSize );
+        CORE_CHECK( largeBytes <= channelStructure.GetConfig().packetBudget + protocol::ConnectionPacketHeaderBytes );
+        packetFactory.Destroy( packet );
+
+        // the packet size can't be raised past the configured maximum
+
+        connection.SetPacketSize( MaxPacketSize * 2 );
+
+        CORE_CHECK( connection.GetPacketSize() == MaxPacketSize );
+    }
+    core::memory::shutdown();
+}
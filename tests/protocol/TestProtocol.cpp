@@ -8,6 +8,9 @@ extern void test_packet_factory();
 extern void test_bitpacker();
 extern void test_stream();
 extern void test_stream_context();
+extern void test_range_stream();
+extern void test_range_stream_models();
+extern void test_stream_stats();
 extern void test_bit_array();
 extern void test_sliding_window();
 extern void test_sequence_buffer();
@@ -16,6 +19,8 @@ extern void test_block();
 
 extern void test_connection();
 extern void test_acks();
+extern void test_connection_rtt_and_packet_loss();
+extern void test_connection_packet_size();
 
 extern void test_reliable_message_channel_messages();
 extern void test_reliable_message_channel_small_blocks();
@@ -60,6 +65,9 @@ int main()
     test_bitpacker();
     test_stream();
     test_stream_context();
+    test_range_stream();
+    test_range_stream_models();
+    test_stream_stats();
     test_bit_array();
     test_sliding_window();
     test_sequence_buffer();
@@ -68,6 +76,8 @@ int main()
 
     test_connection();
     test_acks();
+    test_connection_rtt_and_packet_loss();
+    test_connection_packet_size();
 
     test_reliable_message_channel_messages();
     test_reliable_message_channel_small_blocks();
@@ -0,0 +1,187 @@
+#include "protocol/RangeStream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct RangeTestObject
+{
+    int a,b,c;
+    uint32_t d;
+    bool e;
+    uint64_t f;
+    uint8_t bytes[7];
+
+    void Init()
+    {
+        a = 1;
+        b = -2;
+        c = 150000;
+        d = 0xDEADBEEF;
+        e = true;
+        f = 0x123456789ABCDEF0ULL;
+        for ( int i = 0; i < (int) sizeof( bytes ); ++i )
+            bytes[i] = i * 37;
+    }
+
+    template <typename Stream> void Serialize( Stream & stream )
+    {
+        serialize_int( stream, a, 0, 10 );
+        serialize_int( stream, b, -5, +5 );
+        serialize_int( stream, c, -100, 1000000 );
+        serialize_bits( stream, d, 32 );
+        serialize_bool( stream, e );
+        serialize_uint64( stream, f );
+        serialize_bytes( stream, bytes, sizeof( bytes ) );
+        serialize_check( stream, 0x12345678 );
+    }
+};
+
+void test_range_stream()
+{
+    printf( "test_range_stream\n" );
+
+    const int BufferSize = 256;
+
+    uint8_t buffer[BufferSize];
+
+    RangeTestObject writeObject;
+    writeObject.Init();
+
+    int bytesWritten = 0;
+    {
+        protocol::RangeWriteStream writeStream( buffer, BufferSize );
+        writeObject.Serialize( writeStream );
+        writeStream.Flush();
+        CORE_CHECK( !writeStream.IsOverflow() );
+        bytesWritten = writeStream.GetBytesProcessed();
+    }
+
+    RangeTestObject readObject;
+    memset( &readObject, 0, sizeof( readObject ) );
+    {
+        protocol::RangeReadStream readStream( buffer, bytesWritten );
+        readObject.Serialize( readStream );
+        CORE_CHECK( !readStream.IsOverflow() );
+    }
+
+    CORE_CHECK( readObject.a == writeObject.a );
+    CORE_CHECK( readObject.b == writeObject.b );
+    CORE_CHECK( readObject.c == writeObject.c );
+    CORE_CHECK( readObject.d == writeObject.d );
+    CORE_CHECK( readObject.e == writeObject.e );
+    CORE_CHECK( readObject.f == writeObject.f );
+    CORE_CHECK( memcmp( readObject.bytes, writeObject.bytes, sizeof( readObject.bytes ) ) == 0 );
+
+    // writing past the end of the buffer is detected
+
+    {
+        uint8_t small[8];
+        protocol::RangeWriteStream writeStream( small, sizeof( small ) );
+        writeObject.Serialize( writeStream );
+        writeStream.Flush();
+        CORE_CHECK( writeStream.IsOverflow() );
+    }
+}
+
+const int NumDeltas = 1000;
+const int DeltaMin = -300;
+const int DeltaMax = +300;
+
+template <typename Stream, typename Model> void serialize_deltas( Stream & stream, int * deltas, Model & model )
+{
+    for ( int i = 0; i < NumDeltas; ++i )
+        serialize_signed_symbol( stream, deltas[i], DeltaMin, DeltaMax, model );
+}
+
+static int random_delta()
+{
+    // mostly small deltas with the occasional large one, like cube position deltas in a snapshot
+
+    if ( rand() % 50 == 0 )
+        return DeltaMin + rand() % ( DeltaMax - DeltaMin + 1 );
+    const int magnitude = ( rand() % 4 ) * ( rand() % 3 );
+    return ( rand() % 2 ) ? magnitude : -magnitude;
+}
+
+void test_range_stream_models()
+{
+    printf( "test_range_stream_models\n" );
+
+    typedef protocol::AdaptiveModel<16> DeltaAdaptiveModel;
+    typedef protocol::StaticModel<16> DeltaStaticModel;
+
+    const int BufferSize = 4096;
+
+    uint8_t buffer[BufferSize];
+
+    int deltas[NumDeltas];
+    int readDeltas[NumDeltas];
+
+    uint64_t histogram[16];
+    memset( histogram, 0, sizeof( histogram ) );
+
+    for ( int i = 0; i < NumDeltas; ++i )
+    {
+        deltas[i] = random_delta();
+        const int zigzag = deltas[i] >= 0 ? deltas[i] * 2 : -deltas[i] * 2 - 1;
+        histogram[ core::min( zigzag, 15 ) ]++;
+    }
+
+    // bit packed baseline. the model is ignored and every symbol costs 4 bits
+
+    int bitPackedBytes = 0;
+    {
+        DeltaAdaptiveModel model;
+        protocol::WriteStream writeStream( buffer, BufferSize );
+        serialize_deltas( writeStream, deltas, model );
+        writeStream.Flush();
+        CORE_CHECK( !writeStream.IsOverflow() );
+        bitPackedBytes = writeStream.GetBytesProcessed();
+
+        memset( readDeltas, 0, sizeof( readDeltas ) );
+        protocol::ReadStream readStream( buffer, BufferSize );
+        serialize_deltas( readStream, readDeltas, model );
+        CORE_CHECK( memcmp( deltas, readDeltas, sizeof( deltas ) ) == 0 );
+    }
+
+    // adaptive model. encoder and decoder models start out the same and adapt in lockstep
+
+    int adaptiveBytes = 0;
+    {
+        DeltaAdaptiveModel writeModel;
+        protocol::RangeWriteStream writeStream( buffer, BufferSize );
+        serialize_deltas( writeStream, deltas, writeModel );
+        writeStream.Flush();
+        CORE_CHECK( !writeStream.IsOverflow() );
+        adaptiveBytes = writeStream.GetBytesProcessed();
+
+        memset( readDeltas, 0, sizeof( readDeltas ) );
+        DeltaAdaptiveModel readModel;
+        protocol::RangeReadStream readStream( buffer, adaptiveBytes );
+        serialize_deltas( readStream, readDeltas, readModel );
+        CORE_CHECK( !readStream.IsOverflow() );
+        CORE_CHECK( memcmp( deltas, readDeltas, sizeof( deltas ) ) == 0 );
+    }
+
+    // static model from the measured histogram
+
+    int staticBytes = 0;
+    {
+        DeltaStaticModel model( histogram );
+        protocol::RangeWriteStream writeStream( buffer, BufferSize );
+        serialize_deltas( writeStream, deltas, model );
+        writeStream.Flush();
+        CORE_CHECK( !writeStream.IsOverflow() );
+        staticBytes = writeStream.GetBytesProcessed();
+
+        memset( readDeltas, 0, sizeof( readDeltas ) );
+        protocol::RangeReadStream readStream( buffer, staticBytes );
+        serialize_deltas( readStream, readDeltas, model );
+        CORE_CHECK( !readStream.IsOverflow() );
+        CORE_CHECK( memcmp( deltas, readDeltas, sizeof( deltas ) ) == 0 );
+    }
+
+    CORE_CHECK( adaptiveBytes < bitPackedBytes );
+    CORE_CHECK( staticBytes < bitPackedBytes );
+    CORE_CHECK( staticBytes <= adaptiveBytes + 16 );
+}
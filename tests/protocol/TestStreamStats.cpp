@@ -0,0 +1,106 @@
+#define PROTOCOL_STREAM_STATS 1
+
+#include "protocol/Stream.h"
+#include <stdio.h>
+#include <string.h>
+
+struct StreamStatsTestObject
+{
+    int header;
+    int values[4];
+
+    template <typename Stream> void Serialize( Stream & stream )
+    {
+        serialize_scope( stream, "object" );
+
+        {
+            serialize_scope( stream, "header" );
+            serialize_bits( stream, header, 8 );
+        }
+
+        for ( int i = 0; i < 4; ++i )
+        {
+            serialize_scope_id( stream, "value", i );
+            serialize_int( stream, values[i], 0, 1023 );
+        }
+    }
+};
+
+void test_stream_stats()
+{
+    printf( "test_stream_stats\n" );
+
+    protocol::stream_stats::reset();
+
+    const int BufferSize = 256;
+
+    uint8_t buffer[BufferSize];
+
+    StreamStatsTestObject object;
+    object.header = 0xFF;
+    for ( int i = 0; i < 4; ++i )
+        object.values[i] = i * 100;
+
+    const int NumIterations = 10;
+
+    for ( int i = 0; i < NumIterations; ++i )
+    {
+        protocol::WriteStream writeStream( buffer, BufferSize );
+        object.Serialize( writeStream );
+        writeStream.Flush();
+    }
+
+    const int objectIndex = protocol::stream_stats::find( "object" );
+    CORE_CHECK( objectIndex >= 0 );
+
+    const protocol::StreamStatsEntry & objectEntry = protocol::stream_stats::get_entry( objectIndex );
+    CORE_CHECK( objectEntry.count == NumIterations );
+    CORE_CHECK( objectEntry.bits == NumIterations * ( 8 + 4 * 10 ) );
+    CORE_CHECK( objectEntry.minBits == 8 + 4 * 10 );
+    CORE_CHECK( objectEntry.maxBits == 8 + 4 * 10 );
+    CORE_CHECK( objectEntry.depth == 0 );
+
+    const int headerIndex = protocol::stream_stats::find( "header", -1, objectIndex );
+    CORE_CHECK( headerIndex >= 0 );
+    CORE_CHECK( protocol::stream_stats::get_entry( headerIndex ).bits == NumIterations * 8 );
+    CORE_CHECK( protocol::stream_stats::get_entry( headerIndex ).depth == 1 );
+
+    for ( int i = 0; i < 4; ++i )
+    {
+        const int valueIndex = protocol::stream_stats::find( "value", i, objectIndex );
+        CORE_CHECK( valueIndex >= 0 );
+        const protocol::StreamStatsEntry & valueEntry = protocol::stream_stats::get_entry( valueIndex );
+        CORE_CHECK( valueEntry.count == NumIterations );
+        CORE_CHECK( valueEntry.bits == NumIterations * 10 );
+        CORE_CHECK( valueEntry.histogram[4] == NumIterations );          // 8-15 bits
+    }
+
+    CORE_CHECK( protocol::stream_stats::get_num_entries() == 6 );
+
+    // read streams are not counted
+
+    {
+        protocol::ReadStream readStream( buffer, BufferSize );
+        StreamStatsTestObject readObject;
+        readObject.Serialize( readStream );
+        CORE_CHECK( protocol::stream_stats::get_entry( objectIndex ).count == NumIterations );
+    }
+
+    // measure streams are only counted on request
+
+    {
+        protocol::MeasureStream measureStream( BufferSize );
+        object.Serialize( measureStream );
+        CORE_CHECK( protocol::stream_stats::get_entry( objectIndex ).count == NumIterations );
+
+        protocol::stream_stats::count_measure_streams( true );
+        object.Serialize( measureStream );
+        protocol::stream_stats::count_measure_streams( false );
+        CORE_CHECK( protocol::stream_stats::get_entry( objectIndex ).count == NumIterations + 1 );
+    }
+
+    protocol::stream_stats::reset();
+
+    CORE_CHECK( protocol::stream_stats::get_num_entries() == 0 );
+    CORE_CHECK( protocol::stream_stats::find( "object" ) < 0 );
+}